@@ -7,6 +7,7 @@
 #include "../uniforms.glsl"
 #include "../matrices.glsl"
 #include "../easings.glsl"
+#include "../wind.glsl"
 
 layout (location = GRASS_LOCATION) in vec3 a_position;
 layout (location = TEXTURE0_LOCATION) in vec2 a_texture0;
@@ -21,9 +22,9 @@ out vec2 v_terrainUv;
 out float spawnChance;
 out float v_lodLevel;
 
-uniform mat4 u_world;
 uniform mat4 u_terrainTransform; // Transforms grass space into terrain UV space.
-uniform mat4 u_displacementTransform; // Transforms from world space into displacement uv space.
+uniform mat4 u_displacementTransform; // Transforms from world space into displacement window space.
+uniform vec2 u_displacementOffset; // Start of the window in the wrapping displacement map.
 
 uniform float u_heightModifier;
 
@@ -33,8 +34,6 @@ uniform sampler2D u_heightMap;
 uniform sampler2D u_lengthMap;
 uniform sampler2D u_displacementMap;
 
-uniform uint u_lodLevel;
-
 vec3 windMovement(vec2 terrainUv);
 vec3 computeNormal(vec2 uv);
 vec3 bezier(vec3 p0, vec3 p1, vec3 p2, vec3 p3, float t);
@@ -47,10 +46,16 @@ float random(vec2 st) {
 
 void main()
 {       
+    // Chunk and LOD of this indirect draw, blade data of the LOD starts at the base instance
+    uvec2 grassDraw = grassDraws[gl_DrawID];
+    mat4 world = grassChunks[grassDraw.x].world;
+    uint lodLevel = grassDraw.y;
+    GrassInstanceData blade = instanceData[gl_BaseInstance + gl_InstanceID];
+
     // Set UVs; texture and chunk.
     v_texture0 = a_texture0;
-    v_texture1 = instanceData[gl_InstanceID].chunkUv;
-    vec4 grassBladeWorld = u_world * vec4(instanceData[gl_InstanceID].position.xyz, 1.0);
+    v_texture1 = blade.chunkUv;
+    vec4 grassBladeWorld = world * vec4(blade.position.xyz, 1.0);
     v_terrainUv = (u_terrainTransform * grassBladeWorld).xy;
 
     // Add randomized yaw.
@@ -60,9 +65,12 @@ void main()
     vec3 wind = windMovement(v_texture1);
 
 	// Determine where to sample the displacement map.
-	vec2 displacementSampleUV = (u_displacementTransform * grassBladeWorld).xy;
-	
-	vec4 displacementSample = texture(u_displacementMap, displacementSampleUV);
+	vec2 displacementWindowUV = (u_displacementTransform * grassBladeWorld).xy;
+
+	// Outside the window around the displacer focus nothing is displaced.
+	vec4 displacementSample = vec4(0.5);
+	if (all(greaterThanEqual(displacementWindowUV, vec2(0.0))) && all(lessThan(displacementWindowUV, vec2(1.0))))
+		displacementSample = texture(u_displacementMap, displacementWindowUV + u_displacementOffset);
 	vec3 displacement = (displacementSample.xyz * 2 - 1); // From 0..1 to -1..1.
 
 	displacement = displacement.yxz * 1.0; // Swizzle.
@@ -96,15 +104,15 @@ void main()
         height *= 0;
 
     vec3 scale = vec3(1.0, 1.0, height);
-    scale.x = u_lodLevel > 0 ? ((u_lodLevel + 1) * (u_lodLevel + 1)) * 0.5 : 1.0;
+    scale.x = lodLevel > 0 ? ((lodLevel + 1) * (lodLevel + 1)) * 0.5 : 1.0;
     if(height < material.cutoffLength)
         scale = vec3(0.0);
 
     vec4 position = vec4(a_position, 1.0);
     position.zy = curve.yz;
-    position = vec4(position.xyz * scale * rotation + instanceData[gl_InstanceID].position.xyz, 1.0);    
+    position = vec4(position.xyz * scale * rotation + blade.position.xyz, 1.0);    
     
-    v_position = vec3((u_world * position).xyz);
+    v_position = vec3((world * position).xyz);
 
     // Apply height map sample.
     float heightMapSample = texture2D(u_heightMap, v_terrainUv).x * u_heightModifier;
@@ -116,13 +124,13 @@ void main()
     normal = mix(normal, vec3(0.0, 0.0, 1.0), distanceBlend);
     normal = normalize(normal);
 
-    v_normal = normalize((u_world * vec4(normal, 0.0)).xyz);
+    v_normal = normalize((world * vec4(normal, 0.0)).xyz);
 
     mat4 vp = bee_projection * bee_view;
     gl_Position = vp * vec4(v_position, 1.0);
     
     v_color = vec3(1.0);
-    v_lodLevel = material.lodsAdjustments[u_lodLevel];
+    v_lodLevel = material.lodsAdjustments[lodLevel];
     
 }
 
@@ -143,19 +151,7 @@ vec3 bezierGrad(vec3 p0, vec3 p1, vec3 p2, vec3 p3, float t)
 
 vec3 windMovement(vec2 chunkUv) 
 {
-    vec2 scrollDirection = vec2(cos(ambientWind.direction + PI / 2), sin(ambientWind.direction + PI / 2));
-    vec2 scroll = scrollDirection * bee_time * ambientWind.speed;
-    
-    vec2 windNoise = texture(u_windNoise, vec3(chunkUv + scroll, 0.0)).xy;
-    windNoise = windNoise * 2 - 1;
-    float angle = ambientWind.direction + (windNoise.x * 0.25);
-    
-	float strengthNoise = windNoise.y;
-	float strength = (strengthNoise * 0.5 + 0.5) * ambientWind.strength + 0.5;
-
-    vec3 direction = vec3(cos(angle), sin(angle), 0.0);
-
-    return direction * strength;
+    return ambientWindMovement(u_windNoise, chunkUv);
 }
 
 vec3 computeNormal(vec2 uv)
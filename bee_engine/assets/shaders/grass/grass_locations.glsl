@@ -1,9 +1,15 @@
 
 // SSBOs
 #define GRASS_LOCATION 0
+#define GRASS_CHUNKS_LOCATION 4
+#define GRASS_DRAW_COMMANDS_LOCATION 5
+#define GRASS_DRAWS_LOCATION 6
+#define GRASS_DRAW_COUNT_LOCATION 7
+#define GRASS_VISIBILITY_LOCATION 8
 
 // UBOs
 #define GRASS_MATERIAL_LOCATION 1
+#define GRASS_CULL_LOCATION 9
 
 // Texture Units
 #define DISPLACEMENT_MAP_TEXTURE_UNIT 4
@@ -29,11 +29,30 @@ struct GrassChunkMaterial
 	vec4 lodsAdjustments;
 };
 
+// Mirrored in grass/grass_culling.hpp
+struct GrassChunkData
+{
+	mat4 world;
+	vec4 boundsMin;
+	vec4 boundsMax;
+};
+
 layout(std430, binding=GRASS_LOCATION) buffer vertex_buffer 
 {
 	GrassInstanceData instanceData[];
 };
 
+layout(std430, binding=GRASS_CHUNKS_LOCATION) readonly buffer grass_chunks
+{
+	GrassChunkData grassChunks[];
+};
+
+// Per indirect draw: x chunk index, y LOD
+layout(std430, binding=GRASS_DRAWS_LOCATION) buffer grass_draws
+{
+	uvec2 grassDraws[];
+};
+
 layout(std140, binding=GRASS_MATERIAL_LOCATION) uniform grass_material
 {
 	GrassChunkMaterial material;
@@ -0,0 +1,76 @@
+#version 460 core
+#extension GL_GOOGLE_include_directive : require
+
+#include "../locations.glsl"
+#include "../uniforms.glsl"
+
+layout(location = BASE_COLOR_SAMPLER_LOCATION) uniform sampler2D s_albedo_atlas;
+layout(location = NORMAL_SAMPLER_LOCATION)     uniform sampler2D s_normal_atlas;
+layout(location = DEPTH_SAMPLER_LOCATION)      uniform sampler2D s_depth_atlas;
+layout(location = SPECULAR_SAMPER_LOCATION)    uniform samplerCube s_ibl_specular;
+
+uniform int u_framesPerSide;
+
+in vec3 v_position;
+in vec2 v_quadUv;
+in vec3 v_depthOffset;
+flat in vec2 v_frames[4];
+flat in vec4 v_frameWeights;
+flat in mat3 v_normalMatrix;
+
+layout(location = 0) out vec4 fragColor;
+layout(location = 2) out vec4 wsPositionOut;
+layout(location = 3) out vec4 normalOut;
+
+void ApplyFog(inout vec3 pixel_color, in vec3 fog_color, float fog_near, float fog_far, float distance);
+
+void main()
+{
+    vec4 albedo = vec4(0.0);
+    vec3 normal = vec3(0.0);
+    float depth = 0.0;
+
+    // Blend the neighbouring views
+    for (int i = 0; i < 4; i++)
+    {
+        vec2 atlasUv = (v_frames[i] + v_quadUv) / float(u_framesPerSide);
+        albedo += texture(s_albedo_atlas, atlasUv) * v_frameWeights[i];
+        normal += (texture(s_normal_atlas, atlasUv).xyz * 2.0 - 1.0) * v_frameWeights[i];
+        depth += (texture(s_depth_atlas, atlasUv).r * 2.0 - 1.0) * v_frameWeights[i];
+    }
+
+    if (albedo.a < 0.5)
+        discard;
+
+    albedo.rgb /= albedo.a;
+    albedo.rgb = pow(albedo.rgb, vec3(2.2));
+    normal = normalize(v_normalMatrix * normal);
+
+    // Push the fragment to the baked surface so impostors intersect the terrain correctly
+    vec3 position = v_position + v_depthOffset * depth;
+    vec4 clipPosition = bee_viewProjection * vec4(position, 1.0);
+    gl_FragDepth = (clipPosition.z / clipPosition.w) * 0.5 + 0.5;
+
+    vec3 diffuse = vec3(0.0);
+    for (int i = 0; i < bee_directionalLightsCount; i++)
+    {
+        vec3 direction = normalize(bee_directional_lights[i].direction);
+        float intensity = bee_directional_lights[i].intensity / 1000.0;
+        diffuse += max(dot(normal, direction), 0.0) * bee_directional_lights[i].color * intensity;
+    }
+
+    fragColor = vec4(albedo.rgb * (diffuse * (1.0 - bee_ambientFactor) + bee_ambientFactor), 1.0);
+
+    vec3 V = bee_eyePos - position;
+    if (bee_FogColor.w > 0.0)
+        ApplyFog(fragColor.rgb, textureLod(s_ibl_specular, -V, 1.0).rgb, bee_FogNear, bee_FogFar, length(V));
+
+    wsPositionOut = vec4(position, 1.0);
+    normalOut = vec4(normal, 1.0);
+}
+
+void ApplyFog(inout vec3 pixel_color, in vec3 fog_color, float fog_near, float fog_far, float distance)
+{
+    float fog_amount = clamp((distance - fog_near) / (fog_far - fog_near), 0.0, 1.0);
+    pixel_color = mix(pixel_color, fog_color, fog_amount);
+}
@@ -0,0 +1,51 @@
+#version 460 core
+#extension GL_GOOGLE_include_directive : require
+
+#include "../locations.glsl"
+#include "../uniforms.glsl"
+#include "impostor_common.glsl"
+
+uniform int u_framesPerSide;
+uniform vec3 u_center;
+uniform float u_radius;
+
+out vec3 v_position;
+out vec2 v_quadUv;
+out vec3 v_depthOffset;
+flat out vec2 v_frames[4];
+flat out vec4 v_frameWeights;
+flat out mat3 v_normalMatrix;
+
+void main()
+{
+    mat4 world = bee_transforms[gl_InstanceID].world;
+    float frames = float(u_framesPerSide);
+
+    // View direction in the space the atlas was baked in
+    vec3 eyeObject = (inverse(world) * vec4(bee_eyePos, 1.0)).xyz;
+    vec3 viewDirection = normalize(eyeObject - u_center);
+
+    // Pick the four frames surrounding the view direction and their bilinear weights
+    vec2 grid = octahedral_encode(viewDirection) * frames - 0.5;
+    vec2 base = clamp(floor(grid), vec2(0.0), vec2(frames - 1.0));
+    vec2 f = clamp(grid - base, vec2(0.0), vec2(1.0));
+
+    v_frames[0] = base;
+    v_frames[1] = min(base + vec2(1.0, 0.0), vec2(frames - 1.0));
+    v_frames[2] = min(base + vec2(0.0, 1.0), vec2(frames - 1.0));
+    v_frames[3] = min(base + vec2(1.0, 1.0), vec2(frames - 1.0));
+    v_frameWeights = vec4((1.0 - f.x) * (1.0 - f.y), f.x * (1.0 - f.y), (1.0 - f.x) * f.y, f.x * f.y);
+
+    // Triangle strip quad facing the viewer, using the same basis as the bake
+    vec2 corner = vec2(gl_VertexID & 1, gl_VertexID >> 1);
+    vec3 right, up;
+    billboard_basis(viewDirection, right, up);
+    vec3 localPosition = u_center + (right * (corner.x * 2.0 - 1.0) + up * (corner.y * 2.0 - 1.0)) * u_radius;
+
+    v_position = (world * vec4(localPosition, 1.0)).xyz;
+    v_quadUv = corner;
+    v_depthOffset = (world * vec4(viewDirection * u_radius, 0.0)).xyz;
+    v_normalMatrix = mat3(world);
+
+    gl_Position = bee_viewProjection * vec4(v_position, 1.0);
+}
@@ -0,0 +1,44 @@
+#version 460 core
+#extension GL_GOOGLE_include_directive : require
+
+#include "../locations.glsl"
+
+layout(location = BASE_COLOR_SAMPLER_LOCATION) uniform sampler2D s_base_color;
+
+uniform bool u_use_base_texture;
+uniform vec4 u_base_color_factor;
+
+// Bounding sphere and view direction of the frame being baked (object space)
+uniform vec3 u_center;
+uniform float u_radius;
+uniform vec3 u_viewDirection;
+
+in vec3 v_position;
+in vec3 v_normal;
+in vec2 v_texture0;
+
+layout(location = 0) out vec4 albedoOut;
+layout(location = 1) out vec4 normalOut;
+layout(location = 2) out vec4 depthOut;
+
+void main()
+{
+    vec4 albedo = vec4(1.0);
+    if (u_use_base_texture)
+        albedo = texture(s_base_color, v_texture0);
+    albedo *= u_base_color_factor;
+
+    if (albedo.a < 0.2)
+        discard;
+
+    vec3 normal = normalize(v_normal);
+    if (!gl_FrontFacing)
+        normal = -normal;
+
+    // Height towards the viewer, relative to the bounding sphere
+    float depth = dot(v_position - u_center, u_viewDirection) / u_radius;
+
+    albedoOut = vec4(albedo.rgb, 1.0);
+    normalOut = vec4(normal * 0.5 + 0.5, 1.0);
+    depthOut = vec4(depth * 0.5 + 0.5, 0.0, 0.0, 1.0);
+}
@@ -0,0 +1,24 @@
+#version 460 core
+#extension GL_GOOGLE_include_directive : require
+
+#include "../locations.glsl"
+
+layout (location = POSITION_LOCATION) in vec3 a_position;
+layout (location = NORMAL_LOCATION) in vec3 a_normal;
+layout (location = TEXTURE0_LOCATION) in vec2 a_texture0;
+
+// Node transform relative to the model root
+uniform mat4 u_world;
+uniform mat4 u_viewProjection;
+
+out vec3 v_position;
+out vec3 v_normal;
+out vec2 v_texture0;
+
+void main()
+{
+    v_position = (u_world * vec4(a_position, 1.0)).xyz;
+    v_normal = normalize(mat3(u_world) * a_normal);
+    v_texture0 = a_texture0;
+    gl_Position = u_viewProjection * vec4(v_position, 1.0);
+}
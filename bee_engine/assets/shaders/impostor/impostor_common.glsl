@@ -0,0 +1,37 @@
+// Octahedral mapping helpers for impostors.
+// Mirrored in source/rendering/impostor.cpp, keep both in sync.
+
+vec2 octahedral_encode(vec3 direction)
+{
+    direction /= (abs(direction.x) + abs(direction.y) + abs(direction.z));
+
+    vec2 octahedral = direction.xy;
+    if (direction.z < 0.0)
+    {
+        vec2 signs = vec2(direction.x >= 0.0 ? 1.0 : -1.0, direction.y >= 0.0 ? 1.0 : -1.0);
+        octahedral = (1.0 - abs(direction.yx)) * signs;
+    }
+
+    return octahedral * 0.5 + 0.5;
+}
+
+vec3 octahedral_decode(vec2 uv)
+{
+    vec2 octahedral = uv * 2.0 - 1.0;
+    vec3 direction = vec3(octahedral, 1.0 - abs(octahedral.x) - abs(octahedral.y));
+
+    if (direction.z < 0.0)
+    {
+        vec2 signs = vec2(direction.x >= 0.0 ? 1.0 : -1.0, direction.y >= 0.0 ? 1.0 : -1.0);
+        direction.xy = (1.0 - abs(direction.yx)) * signs;
+    }
+
+    return normalize(direction);
+}
+
+void billboard_basis(vec3 view_direction, out vec3 right, out vec3 up)
+{
+    vec3 world_up = abs(view_direction.z) > 0.999 ? vec3(0.0, 1.0, 0.0) : vec3(0.0, 0.0, 1.0);
+    right = normalize(cross(world_up, view_direction));
+    up = cross(view_direction, right);
+}
@@ -0,0 +1,36 @@
+// Clustered point lights, binned on the CPU by LightClusterGrid (rendering/light_clusters.hpp).
+// Requires locations.glsl and uniforms.glsl to be included first.
+
+layout(std430, binding = POINT_LIGHTS_SSBO_LOCATION) readonly buffer PointLightsSSBO
+{
+    point_light_struct bee_point_lights[];
+};
+
+// Per cluster: x offset into bee_light_indices, y number of lights
+layout(std430, binding = LIGHT_CLUSTERS_SSBO_LOCATION) readonly buffer LightClustersSSBO
+{
+    uvec2 bee_light_clusters[];
+};
+
+layout(std430, binding = LIGHT_INDICES_SSBO_LOCATION) readonly buffer LightIndicesSSBO
+{
+    uint bee_light_indices[];
+};
+
+// Cluster of a world space position, screen tiles in x and y and exponential depth slices in z
+uvec2 get_light_cluster(vec3 world_position)
+{
+    vec4 clip = bee_viewProjection * vec4(world_position, 1.0);
+    vec2 screen = clamp((clip.xy / clip.w) * 0.5 + 0.5, 0.0, 0.9999);
+
+    float view_depth = -(bee_view * vec4(world_position, 1.0)).z;
+    float slice = log(max(view_depth, 0.0001)) * bee_clusterSliceScale + bee_clusterSliceBias;
+
+    uvec3 cluster = uvec3(
+        uint(screen.x * float(LIGHT_CLUSTERS_X)),
+        uint(screen.y * float(LIGHT_CLUSTERS_Y)),
+        uint(clamp(slice, 0.0, float(LIGHT_CLUSTERS_Z - 1))));
+
+    uint index = (cluster.z * uint(LIGHT_CLUSTERS_Y) + cluster.y) * uint(LIGHT_CLUSTERS_X) + cluster.x;
+    return bee_light_clusters[index];
+}
@@ -13,12 +13,21 @@
 #define PER_MATERIAL_LOCATION               2
 #define PER_OBJECT_LOCATION                 3
 #define CAMERA_UBO_LOCATION                 4
-#define LIGHTS_UBO_LOCATION                 5
 #define TRANSFORMS_UBO_LOCATION             6
 #define DIRECTIONAL_LIGHTS_UBO_LOCATION     7
 #define AMBIENT_WIND_LOCATION				8
 #define UBO_LOCATION_COUNT                  9
 
+// SSBOs
+#define POINT_LIGHTS_SSBO_LOCATION          1
+#define LIGHT_CLUSTERS_SSBO_LOCATION        2
+#define LIGHT_INDICES_SSBO_LOCATION         3
+#define TERRAIN_NODES_SSBO_LOCATION         10
+#define DISPLACEMENT_TILES_SSBO_LOCATION    11
+#define DISPLACERS_SSBO_LOCATION            12
+#define DISPLACER_INDICES_SSBO_LOCATION     13
+#define WIND_CHECK_SSBO_LOCATION            14
+
 // Samplers
 #define BASE_COLOR_SAMPLER_LOCATION    0
 #define NORMAL_SAMPLER_LOCATION        1
@@ -4,13 +4,54 @@
 #include "../locations.glsl"
 #include "../uniforms.glsl"
 
-layout (location = POSITION_LOCATION) in vec3 a_position;
-layout (location = TEXTURE0_LOCATION) in vec2 a_texture0;
+#define TERRAIN_MAX_LOD_LEVELS 8
+
+// Unit grid patch, instanced over the selected quadtree nodes
+layout (location = POSITION_LOCATION) in vec2 a_gridPosition;
+
+// Mirrored in terrain/terrain_lod.hpp
+struct TerrainNode
+{
+    vec4 area; // xy local min corner, z size, w LOD level
+};
+
+layout(std430, binding = TERRAIN_NODES_SSBO_LOCATION) readonly buffer terrain_nodes
+{
+    TerrainNode nodes[];
+};
+
+uniform sampler2D s_heightmap;
+uniform float u_heightModifier;
+
+uniform vec4 u_eyePos; // Local space
+uniform vec2 u_terrainMin;
+uniform vec2 u_terrainMax;
+uniform float u_gridResolution;
+uniform vec2 u_morphRanges[TERRAIN_MAX_LOD_LEVELS];
 
 out vec2 v_uvs;
 
 void main()
-{       
-    v_uvs = a_texture0;
-    gl_Position = vec4(a_position, 1.0);
+{
+    TerrainNode node = nodes[gl_BaseInstance + gl_InstanceID];
+    int level = int(node.area.w);
+
+    vec2 position = node.area.xy + a_gridPosition * node.area.z;
+    vec2 uv = (position - u_terrainMin) / (u_terrainMax - u_terrainMin);
+    float height = texture(s_heightmap, uv).r * u_heightModifier;
+
+    // Towards the end of its range a vertex moves onto the grid of the next coarser level
+    float distanceToEye = distance(u_eyePos.xyz, vec3(position, height));
+    vec2 morphRange = u_morphRanges[level];
+    float morph = clamp((distanceToEye - morphRange.x) / max(morphRange.y - morphRange.x, 0.0001), 0.0, 1.0);
+
+    vec2 oddOffset = fract(a_gridPosition * u_gridResolution * 0.5) * 2.0 / u_gridResolution;
+    position -= oddOffset * node.area.z * morph;
+
+    // Nodes can reach past the terrain edge, those vertices collapse onto it
+    position = clamp(position, u_terrainMin, u_terrainMax);
+    uv = (position - u_terrainMin) / (u_terrainMax - u_terrainMin);
+
+    v_uvs = uv;
+    gl_Position = vec4(position, texture(s_heightmap, uv).r * u_heightModifier, 1.0);
 }
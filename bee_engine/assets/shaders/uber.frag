@@ -4,6 +4,7 @@
 
 #include "locations.glsl"
 #include "uniforms.glsl"
+#include "light_clusters.glsl"
 
 in vec3 v_position;
 in vec3 v_normal;
@@ -501,15 +502,18 @@ void main()
         specular += spc;
     }
 
-    for(int i = 0; i < bee_pointLightsCount; i++) // Point lights
+    uvec2 light_cluster = get_light_cluster(v_position);
+    for(uint i = 0; i < light_cluster.y; i++) // Point lights reaching this cluster
     {        
+        point_light_struct point_light = bee_point_lights[bee_light_indices[light_cluster.x + i]];
+
         fragment_light light;        
-        light.direction = bee_point_lights[i].position - v_position;
+        light.direction = point_light.position - v_position;
         float distance = length(light.direction);
         light.direction /= distance;
-        light.color_intensity = vec4(   bee_point_lights[i].color,
-                                        bee_point_lights[i].intensity);
-        light.attenuation = attenuation(distance, bee_point_lights[i].range);
+        light.color_intensity = vec4(   point_light.color,
+                                        point_light.intensity);
+        light.attenuation = attenuation(distance, point_light.range);
         light.attenuation *= c_point_light_tweak;
         vec3 dif = vec3(0.0);
         vec3 spc = vec3(0.0);
@@ -4,6 +4,7 @@
 #include "locations.glsl"
 #include "uniforms.glsl"
 #include "constants.glsl"
+#include "wind.glsl"
 
 layout (location = POSITION_LOCATION) in vec3 a_position;
 layout (location = NORMAL_LOCATION) in vec3 a_normal;
@@ -53,17 +54,6 @@ void main()
 
 vec3 windMovement(vec3 position) 
 {
-    vec2 scrollDirection = vec2(cos(ambientWind.direction + PI / 2), sin(ambientWind.direction + PI / 2));
-    vec2 scroll = scrollDirection * bee_time * ambientWind.speed;
-    
-    vec2 windNoise = texture(u_windNoise, vec3(scroll, 0.0) + position).xy;
-    windNoise = windNoise * 2 - 1;
-    float angle = ambientWind.direction + (windNoise.x * 0.25);
-    
-	float strengthNoise = windNoise.y;
-	float strength = (strengthNoise * 0.5 + 0.5) * ambientWind.strength + 0.5;
-
-    vec3 direction = vec3(cos(angle), sin(angle), 0.0);
-
-    return direction * strength;
+    // Only the horizontal position, so every height of a model sways the same way
+    return ambientWindMovement(u_windNoise, position.xy);
 }
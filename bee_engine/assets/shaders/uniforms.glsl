@@ -15,6 +15,8 @@ layout (std140, binding = CAMERA_UBO_LOCATION) uniform CameraUBO
     int bee_cascadeCount;             // 4
     vec4 bee_cascadePlaneDistances[4]; // 16 * 4
     float bee_farPlane;               // 4
+    float bee_clusterSliceScale;      // 4
+    float bee_clusterSliceBias;       // 4
 };
 
 struct directional_light_struct
@@ -33,7 +35,10 @@ layout(std140, binding = DIRECTIONAL_LIGHTS_UBO_LOCATION) uniform DirectionalLig
     directional_light_struct bee_directional_lights[4];
 };
 
-#define MAX_POINT_LIGHT_INSTANCES 128
+// Point lights live in a storage buffer, binned per cluster (see light_clusters.glsl)
+#define LIGHT_CLUSTERS_X 16
+#define LIGHT_CLUSTERS_Y 9
+#define LIGHT_CLUSTERS_Z 24
 
 struct point_light_struct
 {
@@ -50,11 +55,6 @@ struct AmbientWind
 	float speed;
 };
 
-layout(std140, binding = LIGHTS_UBO_LOCATION) uniform PointLightsUBO
-{
-    point_light_struct bee_point_lights[MAX_POINT_LIGHT_INSTANCES];
-};
-
 #define MAX_TRANSFORM_INSTANCES 256
 
 struct transform_struct
@@ -0,0 +1,33 @@
+// Ambient wind, sampled from the tileable wind field volume. Mirrored on the CPU by WindField and WindMap in wind/.
+// Expects uniforms.glsl to be included for the camera and wind buffers.
+
+// Tiles of the wind field per unit of noise coordinate, a tile holds WIND_FIELD_PERIOD noise cells
+#define WIND_FIELD_FREQUENCY 4.0
+// Second octave, offset so the tiles of both octaves do not line up
+#define WIND_FIELD_DETAIL_FREQUENCY 7.71
+#define WIND_FIELD_DETAIL_OFFSET vec3(0.37, 0.61, 0.13)
+#define WIND_FIELD_DETAIL_WEIGHT 0.35
+// The pattern slowly changes by moving through the depth of the volume
+#define WIND_FIELD_EVOLUTION 0.01
+
+// Two octaves of the noise volume in -1..1
+vec2 windNoise(sampler3D windField, vec3 coordinate)
+{
+    vec2 base = textureLod(windField, coordinate * WIND_FIELD_FREQUENCY, 0.0).xy * 2.0 - 1.0;
+    vec2 detail = textureLod(windField, coordinate * WIND_FIELD_DETAIL_FREQUENCY + WIND_FIELD_DETAIL_OFFSET, 0.0).xy * 2.0 - 1.0;
+    return (base + detail * WIND_FIELD_DETAIL_WEIGHT) / (1.0 + WIND_FIELD_DETAIL_WEIGHT);
+}
+
+// Wind push at a horizontal noise coordinate, scrolling with the ambient wind
+vec3 ambientWindMovement(sampler3D windField, vec2 coordinate)
+{
+    // Scrolls perpendicular to the wind direction
+    vec2 scrollDirection = vec2(-sin(ambientWind.direction), cos(ambientWind.direction));
+    vec2 scroll = scrollDirection * bee_time * ambientWind.speed;
+
+    vec2 noise = windNoise(windField, vec3(coordinate + scroll, bee_time * WIND_FIELD_EVOLUTION));
+    float angle = ambientWind.direction + (noise.x * 0.25);
+    float strength = (noise.y * 0.5 + 0.5) * ambientWind.strength + 0.5;
+
+    return vec3(cos(angle), sin(angle), 0.0) * strength;
+}
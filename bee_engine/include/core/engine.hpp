@@ -2,6 +2,7 @@
 #include <memory>
 #include <string>
 #include <functional>
+#include <vector>
 
 namespace JPH
 {
@@ -29,6 +30,8 @@ class Game;
 class Level;
 class DisplacementManager;
 class PhysicsSystem;
+class ShapeCache;
+struct SensorEvent;
 
 enum class Mode
 {
@@ -61,6 +64,9 @@ public:
     WindMap& GetWindMap() { return *m_windMap; }
     DisplacementManager& DisplacementManager() { return *m_displacementManager; }
     JPH::PhysicsSystem& PhysicsSystem();
+    bee::PhysicsSystem& GetPhysics() { return *m_physicsSystem; }
+    ShapeCache& PhysicsShapeCache();
+    const std::vector<SensorEvent>& PhysicsSensorEvents();
     Time& GetTime() { return *m_time; }
 
     ShaderDB& ShaderDB() { return *m_shaderDB; }
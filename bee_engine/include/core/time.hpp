@@ -26,8 +26,14 @@ public:
 	DeltaMS GetFixedTimeStep() const { return m_fixedTimestep; };
 	uint32_t GetFixedStepsNeeded() const { return m_physicsStepsNecessary; }
 
+	//Fraction of a fixed step left in the accumulator, rendering blends the last two steps by it
+	float GetFixedStepAlpha() const { return m_fixedTimeAccumulator / m_fixedTimestep; }
+
 	void SetFixedTimeStep(DeltaMS interval) { m_fixedTimestep = interval; }
 
+	//Caps the fixed steps taken in one frame, time beyond the cap is dropped so a long frame cannot spiral
+	void SetMaxFixedSteps(uint32_t steps) { m_maxFixedSteps = steps; }
+
 private:
 
 	std::chrono::high_resolution_clock::time_point m_prevFrameTime{};
@@ -38,6 +44,7 @@ private:
 	DeltaMS m_timeSinceStartup{};
 
 	uint32_t m_physicsStepsNecessary{};
+	uint32_t m_maxFixedSteps = 8;
 
 };
 
@@ -0,0 +1,40 @@
+#pragma once
+
+#include <glm/glm.hpp>
+#include <glm/gtc/quaternion.hpp>
+#include <entt/entity/fwd.hpp>
+
+namespace bee
+{
+
+struct Transform;
+
+/// <summary>
+/// Smooths out an entity that is moved by the fixed step systems. The fixed steps work on the simulated pose, the
+/// rest of the frame the Transform holds a blend of the last two steps, so the entity moves every frame whether a
+/// step ran or not. Moving the Transform outside the fixed steps teleports the entity.
+/// </summary>
+struct InterpolatedTransform
+{
+    InterpolatedTransform() = default;
+    explicit InterpolatedTransform(const Transform& transform);
+
+    glm::vec3 previousTranslation{ 0.0f };
+    glm::vec3 currentTranslation{ 0.0f };
+    glm::vec3 renderedTranslation{ 0.0f };
+
+    glm::quat previousRotation = glm::identity<glm::quat>();
+    glm::quat currentRotation = glm::identity<glm::quat>();
+    glm::quat renderedRotation = glm::identity<glm::quat>();
+};
+
+// Puts the simulated poses back into the Transforms, call before the fixed steps of a frame
+void BeginFixedSteps(entt::registry& registry);
+
+// Remembers the poses before a single fixed step
+void BeginFixedStep(entt::registry& registry);
+
+// Blends the last two simulated poses by the fraction of a step left over, call after the fixed steps of a frame
+void InterpolateTransforms(entt::registry& registry, float alpha);
+
+}
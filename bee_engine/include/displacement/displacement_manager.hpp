@@ -8,6 +8,11 @@
 
 namespace bee
 {
+/// <summary>
+/// Keeps a map of how far grass is pushed aside by displacers, in a window of the world around the displacer focus.
+/// The map is anchored to the world and wraps around, so moving the window only touches the texels that enter it.
+/// Only tiles a displacer covers now or covered recently are rewritten, the cost scales with the active displacers.
+/// </summary>
 class DisplacementManager
 {
 public:
@@ -18,26 +23,22 @@ public:
     NON_MOVABLE(DisplacementManager);
 
     void Update(float deltaTime);
+
+    // Transforms world positions into 0..1 over the window, outside it nothing is displaced
     glm::mat4 DisplacementMapTransform() const;
+    // Added to the window coordinate to sample the wrapping map
+    glm::vec2 DisplacementMapOffset() const;
 
     ResourceHandle<bee::Image>& GetTex() { return m_displacementTexture; };
 
-    struct DisplacementWriteParams
-    {
-        // Position relative to the focus component.
-        glm::vec2 position;
-        float radius;
-    };
-
 private:
     class Impl;
     std::unique_ptr<Impl> m_impl;
 
     ResourceHandle<bee::Image> m_displacementTexture;
-    ResourceHandle<bee::Image> m_prevDisplacementTexture;
-    std::shared_ptr<Shader> m_clearCompute;
     std::shared_ptr<Shader> m_displacementWriteCompute;
 
+    // Power of two, the map wraps around with a bitmask
     int32_t m_textureWidth = 512, m_textureHeight = 512;
 };
 }
@@ -1,37 +1,11 @@
 #pragma once
+#include <array>
 #include <cstdint>
-#include <glm/vec2.hpp>
 #include <glm/vec3.hpp>
-#include <visit_struct/visit_struct.hpp>
-
-#include "math/geometry.hpp"
-#include "resources/resource_handle.hpp"
 
 namespace bee
 {
 constexpr uint32_t GRASS_PATCH = 16;
-class Image;
-
-struct CulledGrass{};
-
-struct GrassChunk
-{
-    uint32_t columns{ 1 }, rows{ 1 };
-    uint32_t lod{ 0 };
-    ResourceHandle<bee::Image> heightMapImage{ nullptr };
-    BoundingBox bounds{};
-
-    GrassChunk() = default;
-
-    GrassChunk(uint32_t columns, uint32_t rows, uint32_t lod, ResourceHandle<bee::Image> heightMapImage)
-        : columns(columns), rows(rows), lod(lod), heightMapImage(heightMapImage)
-    {
-        bounds = BoundingBox{glm::vec3{0.0f}, glm::vec3{columns / 2.0f, rows / 2.0f, 1.0f}};
-    }
-
-    uint32_t GrassCount() const { return columns * rows * GRASS_PATCH * GRASS_PATCH; }
-
-};
 
 struct GrassChunkMaterial
 {
@@ -69,5 +43,3 @@ void serialize(A& archive, bee::GrassChunkMaterial& desc)
     archive(cereal::make_nvp("LODAdjustments", desc.lodAdjustments));
 }
 }
-
-VISITABLE_STRUCT(bee::GrassChunk, columns, rows, lod);
@@ -0,0 +1,64 @@
+#pragma once
+#include <array>
+#include <vector>
+#include <glm/glm.hpp>
+
+namespace bee
+{
+class Plane;
+class GrassVisibility;
+
+constexpr uint32_t GRASS_LOD_COUNT = 3;
+
+// Mirrors GrassChunkData in shaders/grass/grass_structures.glsl (std430)
+struct GrassChunkGPU
+{
+    glm::mat4 world{ 1.0f };
+    glm::vec4 boundsMin{ 0.0f };  // World space
+    glm::vec4 boundsMax{ 0.0f };
+};
+
+// Layout of DrawArraysIndirectCommand
+struct GrassDrawCommand
+{
+    uint32_t count = 0;
+    uint32_t instanceCount = 0;
+    uint32_t first = 0;
+    uint32_t baseInstance = 0;
+};
+
+// Mirrors grass_cull in shaders/grass/grass_cull.comp (std140)
+struct GrassCullParams
+{
+    // Frustum and LOD distances are used by GrassVisibility on the CPU
+    // xyz normal pointing inside, w the distance along the normal to the origin
+    std::array<glm::vec4, 6> frustumPlanes{};
+    glm::vec4 cameraPosition{ 0.0f };
+
+    // Start distance of every LOD above 0
+    glm::vec4 lodDistances{ 0.0f };
+
+    // Blade strip and blade instance range of every geometry LOD
+    glm::uvec4 lodFirstVertex{ 0 };
+    glm::uvec4 lodVertexCount{ 0 };
+    glm::uvec4 lodInstanceCount{ 0 };
+    glm::uvec4 lodBaseInstance{ 0 };
+
+    uint32_t chunkCount = 0;
+    uint32_t _padding[3]{};
+};
+
+// Fills the frustum planes of the cull parameters
+void SetGrassCullFrustum(GrassCullParams& params, const std::array<Plane, 6>& frustum);
+
+bool GrassChunkInFrustum(const GrassCullParams& params, glm::vec3 boundsMin, glm::vec3 boundsMax);
+
+// Number of LOD distances the chunk is past, can be GRASS_LOD_COUNT (drawn with the last geometry LOD)
+uint32_t GrassSelectLOD(const GrassCullParams& params, float distance);
+
+// CPU reference of shaders/grass/grass_cull.comp: appends a draw command and a (chunk, LOD) pair per chunk the
+// visibility quadtree marked visible, with the LOD it selected. The GPU appends in any order, compare them as sets.
+void CullGrassChunks(const GrassCullParams& params, const GrassVisibility& visibility, std::vector<GrassDrawCommand>& commands,
+    std::vector<glm::uvec2>& draws);
+
+}
@@ -3,8 +3,8 @@
 #include <array>
 
 #include "glm/vec3.hpp"
-#include <resources/resource_handle.hpp>
-#include <entt/entity/fwd.hpp>
+#include "grass/grass_quality.hpp"
+#include "grass/grass_streaming.hpp"
 
 namespace bee
 {
@@ -14,9 +14,18 @@ public:
     GrassManager();
 
     void Update(float dt);
-    entt::entity CreateChunk(glm::vec3 position, ResourceHandle<Image> heightmap, float terrainHeight);
+
+    // Grass chunks are streamed in around the camera within this area, see GrassStreaming
+    void SetStreamingArea(const GrassStreamingArea& area) { m_streaming.SetArea(area); }
+    void ClearStreamingArea() { m_streaming.ClearArea(); }
+    GrassStreaming& GetStreaming() { return m_streaming; }
+
+    // LOD distances, blade densities and draw distance, adapted to the GPU frame time when enabled
+    void SetQualitySettings(const GrassQualitySettings& settings);
+    GrassQualityController& GetQuality() { return m_quality; }
 
 private:
-    std::array<uint32_t, 3> m_lodRange = { 0, 64, 96 };
+    GrassQualityController m_quality;
+    GrassStreaming m_streaming;
 };
 };
\ No newline at end of file
@@ -0,0 +1,76 @@
+#pragma once
+#include <array>
+#include <cereal/cereal.hpp>
+#include <cereal/types/array.hpp>
+
+#include "grass/grass_culling.hpp"
+
+namespace bee
+{
+
+// Grass LOD setup of a level, loaded from the level JSON
+struct GrassQualitySettings
+{
+    // Distance from the camera at which each LOD after the first starts
+    std::array<float, GRASS_LOD_COUNT> lodDistances{ 0.0f, 64.0f, 96.0f };
+    // Fraction of the blades of every geometry LOD that is drawn
+    std::array<float, GRASS_LOD_COUNT> lodDensities{ 1.0f, 1.0f, 1.0f };
+    // Grass further away than this is not streamed in
+    float drawDistance = 192.0f;
+
+    // Scales the LOD distances and densities to hold the target GPU frame time
+    bool adaptive = true;
+    float targetFrameTime = 16.6f;  // Milliseconds
+    float minScale = 0.5f;
+    float maxScale = 1.0f;
+    float minDensity = 0.25f;
+};
+
+/// <summary>
+/// Applies the grass quality settings and adapts them to the GPU frame time. A single quality scale moves
+/// between the configured bounds: it shrinks the LOD distances and thins out the blades when frames take longer
+/// than the target, and slowly recovers when there is headroom.
+/// </summary>
+class GrassQualityController
+{
+public:
+    GrassQualityController();
+
+    // Resets the adapted scale, unless the settings are the ones already in use
+    void SetSettings(const GrassQualitySettings& settings);
+    const GrassQualitySettings& GetSettings() const { return m_settings; }
+
+    // gpuFrameTime in milliseconds, 0 when no timing is available yet
+    void Update(float gpuFrameTime, float dt);
+
+    float GetScale() const { return m_scale; }
+    float GetSmoothedFrameTime() const { return m_frameTime; }
+    const std::array<float, GRASS_LOD_COUNT>& GetLODDistances() const { return m_lodDistances; }
+    const std::array<float, GRASS_LOD_COUNT>& GetLODDensities() const { return m_lodDensities; }
+
+private:
+    void Apply();
+
+    GrassQualitySettings m_settings{};
+    float m_scale = 1.0f;
+    float m_frameTime = 0.0f;
+    float m_adjustTimer = 0.0f;
+
+    std::array<float, GRASS_LOD_COUNT> m_lodDistances{};
+    std::array<float, GRASS_LOD_COUNT> m_lodDensities{};
+};
+
+template<typename A>
+void serialize(A& archive, bee::GrassQualitySettings& settings)
+{
+    archive(cereal::make_nvp("LODDistances", settings.lodDistances));
+    archive(cereal::make_nvp("LODDensities", settings.lodDensities));
+    archive(cereal::make_nvp("DrawDistance", settings.drawDistance));
+    archive(cereal::make_nvp("Adaptive", settings.adaptive));
+    archive(cereal::make_nvp("TargetFrameTime", settings.targetFrameTime));
+    archive(cereal::make_nvp("MinScale", settings.minScale));
+    archive(cereal::make_nvp("MaxScale", settings.maxScale));
+    archive(cereal::make_nvp("MinDensity", settings.minDensity));
+}
+
+}
@@ -17,6 +17,7 @@ namespace bee
 {
 
 class Shader;
+class Camera;
 
 struct GrassVertex
 {
@@ -31,10 +32,8 @@ public:
     GrassRenderer(const Material::IBL& ibl);
     ~GrassRenderer();
 
-    void OnGrassChunkCreate(entt::registry& registry, entt::entity entity);
-    void OnGrassChunkDestroy(entt::registry& registry, entt::entity entity);
-
-    void Render();
+    // Streams the chunks around the camera, culls them and selects their LOD, then draws all visible grass with one indirect draw
+    void Render(const Camera& camera);
 
     struct GrassMaps
     {
@@ -46,6 +45,10 @@ public:
     GrassChunkMaterial GetMaterial() const { return m_material; }
     void UpdateMaterial(GrassChunkMaterial material);
 
+    // Reads back the draws the cull pass appended during the last Render and compares them with CullGrassChunks.
+    // Returns true when they match, this waits for the GPU.
+    bool CheckCulling();
+
 private:
     class Impl;
     std::unique_ptr<Impl> m_impl;
@@ -53,6 +56,7 @@ private:
     ResourceHandle<Image> m_windNoiseImage;
     GrassMaps m_maps;
     std::shared_ptr<Shader> m_grassCompute;
+    std::shared_ptr<Shader> m_grassCull;
     std::shared_ptr<Shader> m_grassPass;
     const Material::IBL& m_ibl;
     GrassChunkMaterial m_material{};
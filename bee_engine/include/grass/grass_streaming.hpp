@@ -0,0 +1,70 @@
+#pragma once
+#include <vector>
+#include <glm/glm.hpp>
+
+#include "grass/grass_culling.hpp"
+#include "resources/resource_handle.hpp"
+
+namespace bee
+{
+class Image;
+
+// Terrain area covered by grass, split into square chunks
+struct GrassStreamingArea
+{
+    glm::vec2 origin{ 0.0f };  // World position of the outer corner of chunk (0, 0)
+    glm::ivec2 chunkCount{ 0 };
+    float chunkSize = 16.0f;
+    float terrainHeight = 1.0f;
+    ResourceHandle<Image> heightMap{ nullptr };
+};
+
+/// <summary>
+/// Fixed size ring of grass chunk slots centred on the camera. Slot (x, y) holds the chunk whose coordinate
+/// equals (x, y) modulo the ring size, so when the camera crosses a chunk border only the row or column that
+/// left the ring is recycled for the chunks that entered it. Memory depends on the draw distance, not on the terrain size.
+/// </summary>
+class GrassStreaming
+{
+public:
+    struct Slot
+    {
+        glm::ivec2 coordinate{ 0 };
+        bool resident = false;
+    };
+
+    void SetArea(const GrassStreamingArea& area);
+    void ClearArea();
+    const GrassStreamingArea& GetArea() const { return m_area; }
+
+    // Grass further away than this is not streamed in
+    void SetDrawDistance(float distance);
+    float GetDrawDistance() const { return m_drawDistance; }
+
+    // Moves the ring to the camera, returns true when any slot changed chunk
+    bool Update(glm::vec3 cameraPosition);
+
+    const std::vector<Slot>& Slots() const { return m_slots; }
+    // Slots that were given a new chunk by the last update
+    const std::vector<uint32_t>& GeneratedSlots() const { return m_generatedSlots; }
+    uint32_t ResidentCount() const { return m_residentCount; }
+
+    // Placement and bounds of the chunk in a resident slot
+    GrassChunkGPU GenerateChunk(uint32_t slot) const;
+
+private:
+    void Resize();
+
+    GrassStreamingArea m_area{};
+    float m_drawDistance = 192.0f;
+
+    int m_ringSize = 0;
+    glm::ivec2 m_center{ 0 };
+    bool m_dirty = true;
+
+    std::vector<Slot> m_slots;
+    std::vector<uint32_t> m_generatedSlots;
+    uint32_t m_residentCount = 0;
+};
+
+}
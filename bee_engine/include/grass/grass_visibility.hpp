@@ -0,0 +1,71 @@
+#pragma once
+#include <vector>
+#include <glm/glm.hpp>
+
+#include "grass/grass_culling.hpp"
+
+namespace bee
+{
+
+/// <summary>
+/// Quadtree over the grass chunks with a persistent visibility bit and LOD (2 bits) per chunk.
+/// Chunks are reordered so every node covers a contiguous range, which lets whole nodes be
+/// accepted or rejected at once. The bits are updated in place, only the ranges that were visible
+/// last update are cleared, so the cost scales with the visited nodes instead of the chunk count.
+/// The bit layout is read as is by shaders/grass/grass_cull.comp.
+/// </summary>
+class GrassVisibility
+{
+public:
+    struct Node
+    {
+        glm::vec3 boundsMin{ 0.0f };
+        glm::vec3 boundsMax{ 0.0f };
+        uint32_t firstChunk = 0;
+        uint32_t chunkCount = 0;
+
+        // Index of the first of 4 children, 0 for a leaf
+        uint32_t firstChild = 0;
+    };
+
+    // Builds the tree and reorders the chunks into tree order. All chunks start out hidden.
+    void Build(std::vector<GrassChunkGPU>& chunks);
+
+    // Frustum culls the tree and selects the LOD of every visible chunk
+    void Update(const GrassCullParams& params);
+
+    bool IsVisible(uint32_t chunk) const { return (m_visibilityBits[chunk / 32] >> (chunk % 32)) & 1u; }
+    uint32_t GetLOD(uint32_t chunk) const { return (m_lodBits[chunk / 16] >> ((chunk % 16) * 2)) & 3u; }
+
+    // One bit per chunk
+    const std::vector<uint32_t>& VisibilityBits() const { return m_visibilityBits; }
+    // Two bits per chunk, only meaningful for visible chunks
+    const std::vector<uint32_t>& LODBits() const { return m_lodBits; }
+
+    const std::vector<Node>& Nodes() const { return m_nodes; }
+    uint32_t ChunkCount() const { return static_cast<uint32_t>(m_chunkCenters.size()); }
+    uint32_t VisitedNodes() const { return m_visitedNodes; }
+    uint32_t VisibleChunks() const { return m_visibleChunks; }
+
+private:
+    void BuildNode(std::vector<GrassChunkGPU>& chunks, uint32_t index, uint32_t first, uint32_t count);
+    void SetVisible(uint32_t first, uint32_t count, bool visible);
+    void SetLOD(uint32_t chunk, uint32_t lod);
+
+    std::vector<Node> m_nodes;
+    std::vector<glm::vec3> m_chunkCenters;
+    std::vector<glm::vec3> m_chunkBoundsMin;
+    std::vector<glm::vec3> m_chunkBoundsMax;
+
+    std::vector<uint32_t> m_visibilityBits;
+    std::vector<uint32_t> m_lodBits;
+
+    // Chunk ranges (first, count) set visible by the last update
+    std::vector<glm::uvec2> m_visibleRanges;
+    std::vector<uint32_t> m_stack;
+
+    uint32_t m_visitedNodes = 0;
+    uint32_t m_visibleChunks = 0;
+};
+
+}
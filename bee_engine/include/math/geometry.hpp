@@ -21,11 +21,6 @@ constexpr glm::quat YUP_TO_ZUP = glm::quat(0.707107f, 0.707107f, 0.0f, 0.0f);
 
 }
 
-// Cascaded matrices calculations 
-std::vector<glm::vec4> GetCascadeCornersWorldSpace(const glm::mat4& projview);
-glm::mat4 GetLightSpaceMatrix(const float nearPlane, const float farPlane, glm::vec3 lightDir, const Camera& camera);
-std::vector<glm::mat4> GetLightSpaceMatrices(const Camera& camera, glm::vec3 lightDir, std::vector<float> cascadeLevels);
-
 //Axis aligned 3D bounding box
 class BoundingBox {
 public:
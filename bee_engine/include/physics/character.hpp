@@ -0,0 +1,31 @@
+#pragma once
+
+#include <entt/entity/fwd.hpp>
+
+#include <jolt/Jolt.h>
+#include <jolt/Physics/Character/CharacterVirtual.h>
+
+namespace bee
+{
+
+struct Transform;
+struct RigidBody;
+
+/// <summary>
+/// Moves an entity with a JPH::CharacterVirtual instead of letting its RigidBody move freely. Every fixed step is a
+/// single shape sweep against the static world, terrain height field and props alike. The character flies: it slides
+/// along what it hits, has no ground, no slope limit and no stair stepping. Contacts are cached between steps.
+/// </summary>
+struct CharacterComponent
+{
+    JPH::Ref<JPH::CharacterVirtual> character;
+};
+
+// Creates a sphere character at the Transform of the entity, replacing the character it had
+void AddSphereCharacter(entt::registry& registry, entt::entity entity, float radius);
+
+// Integrates the rigid body like UpdateRigidBody, then moves the character by its velocity.
+// The velocity loses the part that pushed into what the character hit, CharacterVirtual does not change it itself.
+void UpdateCharacter(CharacterComponent& character, RigidBody& rigidBody, Transform& transform, float dt);
+
+}
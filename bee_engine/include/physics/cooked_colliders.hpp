@@ -0,0 +1,54 @@
+#pragma once
+
+#include <cstdint>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include <jolt/Jolt.h>
+#include <jolt/Geometry/Triangle.h>
+#include <jolt/Physics/Collision/Shape/Shape.h>
+
+#include "core/fileio.hpp"
+
+namespace bee
+{
+
+/// <summary>
+/// Collision shapes of a model cooked into a file, so loading a collider restores a built tree instead of building it
+/// again. A cooked file shipped next to the model (<model>.colliders) is read first, otherwise the one in the save
+/// directory, named after a hash of the model path. Shapes are looked up by a hash of their source triangles, edited
+/// models only rebuild the colliders that changed. Shapes that had to be built are written back to the save directory
+/// by Save, copying that file next to the model ships it.
+/// </summary>
+class CookedColliders
+{
+public:
+    // Reads the cooked file of the model at the path in the directory, or the one in the save directory
+    CookedColliders(FileIO::Directory directory, const std::string& modelPath);
+
+    // Mesh shape of the triangles, restored from the cooked file or built
+    JPH::Shape::ShapeResult GetMeshShape(const JPH::TriangleList& triangles);
+
+    // Writes the cooked file when shapes were built since it was read
+    void Save();
+
+private:
+    // Span of a cooked shape in m_file
+    struct Range
+    {
+        size_t offset = 0;
+        size_t size = 0;
+    };
+
+    // Reads the cooked shapes of the file, false when it is missing or outdated
+    bool Read(FileIO::Directory directory, const std::string& path);
+
+    std::string m_path;
+    std::vector<char> m_file;
+    std::unordered_map<uint64_t, Range> m_cooked;
+    std::unordered_map<uint64_t, std::string> m_built;
+    std::vector<uint64_t> m_used;
+};
+
+}
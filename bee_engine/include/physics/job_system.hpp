@@ -0,0 +1,34 @@
+#pragma once
+
+#include <jolt/Jolt.h>
+#include <jolt/Core/FixedSizeFreeList.h>
+#include <jolt/Core/JobSystemWithBarrier.h>
+
+namespace bee
+{
+
+class ThreadPool;
+
+/// <summary>
+/// Runs Jolt's jobs on the engine thread pool, so physics and engine tasks share one set of workers instead of
+/// two pools competing for the same cores. The thread waiting on a barrier helps out with the barrier's jobs.
+/// </summary>
+class PhysicsJobSystem final : public JPH::JobSystemWithBarrier
+{
+public:
+    PhysicsJobSystem(ThreadPool& threadPool, JPH::uint maxJobs, JPH::uint maxBarriers);
+
+    virtual int GetMaxConcurrency() const override;
+    virtual JobHandle CreateJob(const char* inName, JPH::ColorArg inColor, const JobFunction& inJobFunction, JPH::uint32 inNumDependencies = 0) override;
+
+protected:
+    virtual void QueueJob(Job* inJob) override;
+    virtual void QueueJobs(Job** inJobs, JPH::uint inNumJobs) override;
+    virtual void FreeJob(Job* inJob) override;
+
+private:
+    ThreadPool& m_threadPool;
+    JPH::FixedSizeFreeList<Job> m_jobs;
+};
+
+}
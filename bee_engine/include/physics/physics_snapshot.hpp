@@ -0,0 +1,35 @@
+#pragma once
+
+#include <jolt/Jolt.h>
+#include <jolt/Physics/PhysicsSystem.h>
+#include <jolt/Physics/StateRecorderImpl.h>
+
+namespace bee
+{
+
+/// <summary>
+/// State of the Jolt world at one point in time: body motion, contacts, constraints and the global settings.
+/// Restoring happens in place, so the world has to hold the same bodies as when it was saved.
+/// Shapes and body creation settings are not part of it, see StaticBodyBatch for those.
+/// </summary>
+class PhysicsSnapshot
+{
+public:
+    // Replaces the saved state, the recorder is reused between saves
+    void Save(const JPH::PhysicsSystem& physicsSystem, JPH::EStateRecorderState state = JPH::EStateRecorderState::All);
+
+    // Returns false when nothing was saved or the world no longer matches the saved state
+    bool Restore(JPH::PhysicsSystem& physicsSystem);
+
+    // Bit for bit comparison of two saved states
+    bool IsEqual(PhysicsSnapshot& other);
+
+    bool IsEmpty() const { return m_empty; }
+    size_t GetSize() { return m_empty ? 0 : m_recorder.GetDataSize(); }
+
+private:
+    JPH::StateRecorderImpl m_recorder;
+    bool m_empty = true;
+};
+
+}
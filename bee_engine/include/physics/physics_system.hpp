@@ -1,9 +1,12 @@
 #pragma once
 
 #include <cstdarg>
+#include <functional>
 #include <memory>
 
 #include <jolt/Jolt.h>
+#include <jolt/Core/JobSystem.h>
+#include <jolt/Core/TempAllocator.h>
 #include <jolt/Physics/PhysicsSettings.h>
 #include <jolt/Physics/PhysicsSystem.h>
 
@@ -11,6 +14,9 @@
 #include "rendering/debug_render.hpp"
 
 #include "layers.hpp"
+#include "physics_snapshot.hpp"
+#include "sensors.hpp"
+#include "shape_cache.hpp"
 #include "tools/log.hpp"
 
 class BPLayerInterfaceImpl final : public JPH::BroadPhaseLayerInterface 
@@ -52,7 +58,9 @@ struct ColliderComponent
     JPH::BodyID body{};
 };
 
+// Creates static bodies for the colliders of the entity and its children, see StaticBodyBatch to add many at once
 void InitColliderTransforms(entt::registry& registry, entt::entity entity);
+// Moves the colliders and sensors of the entity and its children to their current Transforms
 void UpdateColliderTransforms(entt::registry& registry, entt::entity entity);
 
 class PhysicsSystem
@@ -62,12 +70,55 @@ public:
     PhysicsSystem();
     ~PhysicsSystem();
 
+    // Advances the Jolt world by a number of fixed steps, in one multi-threaded update
+    void Update(float fixedTimeStep, uint32_t steps);
+
+    ShapeCache& GetShapeCache() { return m_shapeCache; }
+
+    // Scratch memory of the update, free to use on the main thread outside of it
+    JPH::TempAllocator& GetTempAllocator() { return *m_tempAllocator; }
+
+    // Sensor overlaps of the last update, entities destroyed since then are left out
+    const std::vector<SensorEvent>& GetSensorEvents() const { return m_sensorEvents; }
+
+    // Saves the state of the world, restoring it rewinds the bodies in place.
+    // Only the Jolt world is covered, ECS components such as Transform and RigidBody are left as they are.
+    void SaveSnapshot();
+    bool RestoreSnapshot();
+    const PhysicsSnapshot& GetSnapshot() const { return m_snapshot; }
+
+    // Saves a snapshot after every update that completes this many steps since the last one, 0 turns it off
+    void SetSnapshotInterval(uint32_t steps) { m_snapshotInterval = steps; m_stepsSinceSnapshot = 0; }
+
+    // Runs the same steps twice from the current state and compares the results bit for bit. A step runs the
+    // gameplay of one fixed step and calls Update for it. The state outside of the Jolt world that the steps change
+    // is written by saveState and read back by restoreState, in the same order, so it is compared and rewound too.
+    // The world is back in its current state afterwards.
+    bool CheckDeterminism(uint32_t steps, const std::function<void(uint32_t step)>& step,
+        const std::function<void(JPH::StateRecorder&)>& saveState, const std::function<void(JPH::StateRecorder&)>& restoreState);
+
     void DrawBodies();
     void OnDestroyCollider(entt::registry& registry, entt::entity entity);
+    void OnDestroySensor(entt::registry& registry, entt::entity entity);
+    void OnDestroySensorTarget(entt::registry& registry, entt::entity entity);
+    void OnUpdateTransform(entt::registry& registry, entt::entity entity);
 
     std::unique_ptr<JPH::PhysicsSystem> m_joltPhysicsSystem;
 
 private:
+    void DestroyBody(JPH::BodyID body);
+    void MoveSensorTargets(float deltaTime);
+    void Step(float fixedTimeStep, uint32_t steps);
+
+    ShapeCache m_shapeCache;
+    SensorContactListener m_sensorListener;
+    std::vector<SensorEvent> m_sensorEvents;
+    PhysicsSnapshot m_snapshot;
+    uint32_t m_snapshotInterval = 0;
+    uint32_t m_stepsSinceSnapshot = 0;
+    std::unique_ptr<JPH::TempAllocator> m_tempAllocator;
+    std::unique_ptr<JPH::JobSystem> m_jobSystem;
+
     BPLayerInterfaceImpl m_broadPhaseLayerInterface;
     ObjectVsBroadPhaseLayerFilterImpl m_objectVsBroadphaseLayerFilter;
     ObjectLayerPairFilterImpl m_objectVsObjectLayerFilter;
@@ -0,0 +1,85 @@
+#pragma once
+
+#include <cstdint>
+#include <mutex>
+#include <unordered_map>
+#include <vector>
+#include <entt/entity/fwd.hpp>
+
+#include <jolt/Jolt.h>
+#include <jolt/Physics/Body/BodyID.h>
+#include <jolt/Physics/Collision/ContactListener.h>
+
+namespace bee
+{
+
+// Static trigger volume on the COLLECTABLE layer, bodies overlapping it are reported as SensorEvents.
+// Static bodies on the COLLECTABLE layer added through a StaticBodyBatch are sensors as well.
+struct SensorComponent
+{
+    JPH::BodyID body{};
+};
+
+// Kinematic body that follows the Transform of its entity, sensors only detect moving bodies
+struct SensorTargetComponent
+{
+    JPH::BodyID body{};
+};
+
+struct SensorEvent
+{
+    enum class Type
+    {
+        Enter,  // Started overlapping during the last physics update
+        Stay,   // Still overlapping, reported every update after the enter
+        Exit    // Stopped overlapping, or one of the bodies was removed
+    };
+
+    Type type;
+    entt::entity sensor;
+    entt::entity other;
+};
+
+// Creates a sphere sensor at the world position of the entity
+void AddSphereSensor(entt::registry& registry, entt::entity entity, float radius);
+
+// Creates a sphere sensor target that is moved to the entity every physics update
+void AddSphereSensorTarget(entt::registry& registry, entt::entity entity, float radius);
+
+/// <summary>
+/// Tracks the overlaps of sensors during the physics update. Jolt calls it from the physics jobs, the overlaps are
+/// handed out as one batch of events after the update. Bodies keep the entity they belong to in their user data.
+/// </summary>
+class SensorContactListener final : public JPH::ContactListener
+{
+public:
+    void OnContactAdded(const JPH::Body& inBody1, const JPH::Body& inBody2, const JPH::ContactManifold& inManifold,
+        JPH::ContactSettings& ioSettings) override;
+    void OnContactPersisted(const JPH::Body& inBody1, const JPH::Body& inBody2, const JPH::ContactManifold& inManifold,
+        JPH::ContactSettings& ioSettings) override;
+    void OnContactRemoved(const JPH::SubShapeIDPair& inSubShapePair) override;
+
+    // Replaces the events with the enters and exits since the last flush, followed by a stay for every other overlap
+    void Flush(std::vector<SensorEvent>& events);
+
+    // Forgets every overlap without reporting exits, for when the contacts were replaced by a restored state
+    void Clear();
+
+private:
+    struct Overlap
+    {
+        entt::entity sensor{};
+        entt::entity other{};
+        uint32_t contacts = 0;  // Contacts are tracked per sub shape pair
+        bool entered = false;
+    };
+
+    static uint64_t GetKey(JPH::BodyID sensor, JPH::BodyID other);
+    void AddContact(const JPH::Body& inBody1, const JPH::Body& inBody2, bool persisted);
+
+    std::mutex m_mutex;
+    std::unordered_map<uint64_t, Overlap> m_overlaps;
+    std::vector<SensorEvent> m_changes;
+};
+
+}
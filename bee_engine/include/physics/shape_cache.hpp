@@ -0,0 +1,84 @@
+#pragma once
+
+#include <cstdint>
+#include <mutex>
+#include <unordered_map>
+#include <glm/glm.hpp>
+
+#include <jolt/Jolt.h>
+#include <jolt/Physics/Collision/Shape/Shape.h>
+
+namespace bee
+{
+
+/// <summary>
+/// Shares scaled shapes between bodies that use the same source shape at (nearly) the same scale, so a field of
+/// props made from a few models holds a few shapes instead of one per instance.
+/// Scales are quantized in log2 space, the cached shape may differ from the requested scale by up to SCALE_ERROR.
+/// Safe to use from multiple threads.
+/// </summary>
+class ShapeCache
+{
+public:
+    // Quantization steps per doubling of the scale
+    static constexpr float SCALE_STEPS = 64.0f;
+    static constexpr float SCALE_ERROR = 0.0055f;  // ~2^(0.5 / SCALE_STEPS) - 1
+
+    struct Stats
+    {
+        uint64_t hits = 0;
+        uint64_t misses = 0;
+        size_t shapes = 0;
+        size_t memoryBytes = 0;  // Of the cached shapes themselves, not their source shapes
+
+        float HitRate() const { return hits + misses == 0 ? 0.0f : static_cast<float>(hits) / static_cast<float>(hits + misses); }
+    };
+
+    // The source shape scaled by the quantized scale. Falls back to the source shape when it can't be scaled.
+    JPH::RefConst<JPH::Shape> GetScaled(const JPH::Shape* shape, glm::vec3 scale);
+
+    // Shares the shape under a hash of what it was built from, such as the triangles of a cooked collider. Returns the
+    // shape added earlier with the same hash, or this one when it is the first. Files can refer to a shape by its hash.
+    JPH::Ref<JPH::Shape> AddContentShape(uint64_t hash, JPH::Shape* shape);
+
+    // Hash the shape was added with, 0 when it was not added
+    uint64_t GetContentHash(const JPH::Shape* shape) const;
+
+    // The shape added with this hash, null when there is none
+    JPH::Ref<JPH::Shape> FindByContentHash(uint64_t hash) const;
+
+    // Drops the shapes nothing outside the cache uses anymore
+    void Prune();
+    void Clear();
+
+    Stats GetStats() const;
+
+private:
+    struct Key
+    {
+        const JPH::Shape* shape = nullptr;
+        glm::ivec3 scale{ 0 };  // Quantized, the lowest bit holds the sign
+
+        bool operator==(const Key& other) const { return shape == other.shape && scale == other.scale; }
+    };
+
+    struct KeyHash
+    {
+        size_t operator()(const Key& key) const;
+    };
+
+    struct Entry
+    {
+        JPH::RefConst<JPH::Shape> source;  // Keeps the key pointer from being reused by another shape
+        JPH::RefConst<JPH::Shape> scaled;
+        size_t memoryBytes = 0;
+    };
+
+    mutable std::mutex m_mutex;
+    std::unordered_map<Key, Entry, KeyHash> m_shapes;
+    std::unordered_map<uint64_t, JPH::Ref<JPH::Shape>> m_contentShapes;
+    std::unordered_map<const JPH::Shape*, uint64_t> m_contentHashes;  // Of the shapes in m_contentShapes
+    Stats m_stats{};
+};
+
+}
@@ -0,0 +1,73 @@
+#pragma once
+
+#include <string>
+#include <vector>
+#include <glm/glm.hpp>
+#include <glm/gtc/quaternion.hpp>
+#include <entt/entity/fwd.hpp>
+
+#include <jolt/Jolt.h>
+#include <jolt/Physics/Collision/Shape/Shape.h>
+#include <jolt/Physics/Collision/ObjectLayer.h>
+
+#include "core/fileio.hpp"
+
+namespace JPH
+{
+class BodyCreationSettings;
+}
+
+namespace bee
+{
+
+/// <summary>
+/// Gathers static bodies and adds them to the physics system in one go. Shapes are scaled on the thread pool and
+/// the bodies are inserted with a single AddBodiesPrepare/AddBodiesFinalize, which builds their broad phase tree
+/// once instead of inserting every body separately.
+/// Every body gets a ColliderComponent on its entity, replacing the body it had before.
+/// The bodies can be stored as a snapshot, which is restored instead of scaling the shapes again. Snapshots hold the
+/// scaled shapes and refer to the source shapes by ShapeCache content hash, the hash of their cooked triangles.
+/// </summary>
+class StaticBodyBatch
+{
+public:
+    // The shape is scaled when the batch is committed
+    void Add(entt::entity entity, const JPH::Shape* shape, glm::vec3 scale, glm::vec3 position, glm::quat rotation, JPH::ObjectLayer layer);
+
+    // Adds the ColliderComponent shapes of the entity and its children, at their world transforms
+    void AddColliders(entt::registry& registry, entt::entity entity);
+
+    void Commit(entt::registry& registry);
+
+    // Restores the bodies from a snapshot saved by a previous commit of the same entries, skipping the shape scaling.
+    // Without a matching snapshot the bodies are built as usual and a new snapshot is saved. Batches with shapes that
+    // have no content hash are committed without a snapshot.
+    void Commit(entt::registry& registry, FileIO::Directory directory, const std::string& snapshotPath);
+
+    size_t Size() const { return m_entries.size(); }
+
+private:
+    std::vector<JPH::BodyCreationSettings> CreateSettings() const;
+    bool RestoreSnapshot(FileIO::Directory directory, const std::string& path, uint64_t key, std::vector<JPH::BodyCreationSettings>& settings) const;
+    void SaveSnapshot(FileIO::Directory directory, const std::string& path, uint64_t key, const std::vector<JPH::BodyCreationSettings>& settings) const;
+
+    // Identifies the entries by their transforms, layers and shape content hashes, entities are not stable between
+    // runs. 0 when a shape has no content hash.
+    uint64_t GetKey() const;
+
+    void AddBodies(entt::registry& registry, std::vector<JPH::BodyCreationSettings>& settings);
+
+    struct Entry
+    {
+        entt::entity entity;
+        JPH::RefConst<JPH::Shape> shape;
+        glm::vec3 scale;
+        glm::vec3 position;
+        glm::quat rotation;
+        JPH::ObjectLayer layer;
+    };
+
+    std::vector<Entry> m_entries;
+};
+
+}
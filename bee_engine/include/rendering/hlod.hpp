@@ -0,0 +1,98 @@
+#pragma once
+#include <glm/glm.hpp>
+#include <vector>
+#include <entt/entity/entity.hpp>
+
+#include "resources/resource_handle.hpp"
+#include "resources/mesh/mesh_loader.hpp"
+
+namespace bee
+{
+
+struct HLODSettings
+{
+    // World space size of a cluster cell
+    float cellSize = 64.0f;
+
+    // Size of the vertex clustering grid used to simplify the merged mesh, 0 disables simplification
+    float simplifyGridSize = 0.5f;
+
+    // Resolution of a single material tile in the base color atlas
+    uint32_t atlasTileSize = 128;
+
+    // Cells with fewer props than this are left alone, merging them does not save draw calls
+    uint32_t minPropsPerCell = 2;
+};
+
+// Cell that a world position falls into, on the horizontal (XY) plane
+glm::ivec2 HLODCellCoordinate(glm::vec3 position, float cellSize);
+
+// Sub-rectangle (offset in xy, scale in zw) of the atlas texture reserved for a tile
+glm::vec4 HLODAtlasTileRect(uint32_t tileIndex, uint32_t tilesPerSide, uint32_t tileSize);
+
+// Copies an RGBA8 image into a tile of an RGBA8 atlas, resampled to the tile size and multiplied by a colour factor.
+// Without source pixels the tile is filled with the factor.
+void HLODWriteAtlasTile(std::vector<uint8_t>& atlas, uint32_t tilesPerSide, uint32_t tileSize, uint32_t tileIndex,
+    const uint8_t* pixels, uint32_t width, uint32_t height, glm::vec4 factor);
+
+// Appends src to dst, transforming positions and normals to world space
+// and remapping the UVs into the atlas tile rect. UVs outside [0, 1] are clamped,
+// tiling textures are not representable in an atlas tile.
+void HLODAppendMesh(MeshLoader::MeshData& dst, const MeshLoader::MeshData& src, const glm::mat4& transform, glm::vec4 uvRect);
+
+// Vertex clustering simplification: vertices are snapped to a grid of the given size and merged.
+// Triangles that collapse are removed. Vertices are only merged with others of the same atlas tile
+// (tileIds per vertex) so the UVs stay inside their tile.
+void HLODSimplify(MeshLoader::MeshData& mesh, const std::vector<uint32_t>& tileIds, float gridSize);
+
+// One mesh that goes into a cluster, in world space
+struct HLODSource
+{
+    glm::mat4 transform;
+    ResourceHandle<Mesh> mesh;
+    ResourceHandle<Material> material;
+};
+
+struct HLODCluster;
+
+// Merges and simplifies the sources into a single mesh with a base color atlas material.
+// Reads mesh and texture data back from the GPU, so this is only meant for level generation.
+HLODCluster BakeHLODCluster(const std::vector<HLODSource>& sources, std::string_view name, const HLODSettings& settings);
+
+// Cache key of a cell: the meshes, transforms and base colours of its sources and the settings.
+// 0 when a source mesh has no path to identify it by, such a cell is always baked.
+uint64_t HLODCellKey(const std::vector<HLODSource>& sources, const HLODSettings& settings);
+
+// As BakeHLODCluster, but the proxy is kept in the save directory under the cell key and only baked when it is not there
+HLODCluster LoadOrBakeHLODCluster(const std::vector<HLODSource>& sources, std::string_view name, const HLODSettings& settings);
+
+/// <summary>
+/// A merged, simplified proxy of all static props in a cell.
+/// Drawn instead of the props while the camera is further than the HLOD distance.
+/// </summary>
+struct HLODCluster
+{
+    ResourceHandle<Mesh> mesh;
+    ResourceHandle<Material> material;
+
+    // World space bounds of the merged props
+    glm::vec3 minBounds = glm::vec3(0.0f);
+    glm::vec3 maxBounds = glm::vec3(0.0f);
+
+    // Root entities of the merged props
+    std::vector<entt::entity> members;
+
+    // HLODCellKey of the sources it was baked from, 0 when it is not cached
+    uint64_t key = 0;
+
+    // Set every frame by whoever decides which representation is drawn
+    bool active = false;
+};
+
+// Placed on the root entity of a prop that is part of a cluster
+struct HLODMember
+{
+    entt::entity cluster = entt::null;
+};
+
+}
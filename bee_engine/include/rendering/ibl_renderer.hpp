@@ -14,13 +14,15 @@ public:
     NON_COPYABLE(IBLRenderer);
     NON_MOVABLE(IBLRenderer);
 
-    void Render(std::shared_ptr<Image> envCubemap, const Material::IBL& ibl);
+    // Filters the environment into the IBL maps. With a source hash the maps are cached on disk under it and
+    // loaded from there next time. The BRDF LUT does not depend on the environment and is only made once.
+    void Render(std::shared_ptr<Image> envCubemap, const Material::IBL& ibl, uint64_t sourceHash = 0);
 
     uint32_t SpecularMipCount() const { return m_specularMipCount; }
 
     void SetTextureSizeDiffuse(uint32_t size) { m_textureSizeDiffuse = size; }
-    void SetTextureSizeSpecular(uint32_t size) { m_textureSizeDiffuse = size; }
-    void SetTextureSizeLut(uint32_t size) { m_textureSizeDiffuse = size; }
+    void SetTextureSizeSpecular(uint32_t size) { m_textureSizeSpecular = size; }
+    void SetTextureSizeLut(uint32_t size) { m_textureSizeLut = size; }
 
 private:
     class Impl;
@@ -0,0 +1,51 @@
+#pragma once
+#include <glm/glm.hpp>
+#include <memory>
+
+namespace bee
+{
+class Image;
+
+// Octahedral mapping of the full sphere of view directions onto the unit square.
+// Mirrored in shaders/impostor/impostor_common.glsl, keep both in sync.
+glm::vec2 OctahedralEncode(glm::vec3 direction);
+glm::vec3 OctahedralDecode(glm::vec2 uv);
+
+// View direction (object space, pointing from the object to the viewer) baked into a given frame of the atlas
+glm::vec3 ImpostorFrameDirection(uint32_t frameX, uint32_t frameY, uint32_t framesPerSide);
+
+// Right/up vectors of the billboard that faces the given view direction.
+// The bake and the billboard use the same convention, so frames line up when blending.
+void ImpostorBillboardBasis(glm::vec3 viewDirection, glm::vec3& right, glm::vec3& up);
+
+/// <summary>
+/// Baked multi-view representation of a model.
+/// The atlas is a grid of framesPerSide x framesPerSide views, laid out by octahedral direction.
+/// </summary>
+struct ImpostorAtlas
+{
+    std::shared_ptr<Image> albedo;  // RGB albedo, A coverage
+    std::shared_ptr<Image> normal;  // Object space normal packed in [0, 1], A coverage
+    std::shared_ptr<Image> depth;   // Depth along the view direction, [0, 1] maps to [-radius, radius]
+
+    uint32_t framesPerSide = 8;
+    uint32_t frameResolution = 256;
+
+    // Object space bounding sphere of the baked model
+    glm::vec3 center = glm::vec3(0.0f);
+    float radius = 1.0f;
+};
+
+/// <summary>
+/// Lets a model instance be swapped to its impostor when it is far away.
+/// Placed on the root entity of an instantiated model.
+/// </summary>
+struct Impostor
+{
+    std::shared_ptr<ImpostorAtlas> atlas;
+
+    // Set every frame by whoever decides which representation is drawn
+    bool active = false;
+};
+
+}
@@ -0,0 +1,45 @@
+#pragma once
+#include "render.hpp"
+#include "resources/resource_handle.hpp"
+#include "resources/material/material.hpp"
+#include "rendering/impostor.hpp"
+
+namespace bee
+{
+class Model;
+
+/// <summary>
+/// Bakes octahedral impostor atlases for models and draws instanced impostor billboards.
+/// Baking only renders into offscreen framebuffers, so it can run before the window is shown.
+/// </summary>
+class ImpostorRenderer
+{
+public:
+    ImpostorRenderer(const Material::IBL& ibl);
+    ~ImpostorRenderer();
+    NON_COPYABLE(ImpostorRenderer);
+    NON_MOVABLE(ImpostorRenderer);
+
+    // Returns the atlas of the model. The first bake is written to the save directory, keyed on the model file and the
+    // frame settings, and later runs load it from there.
+    std::shared_ptr<ImpostorAtlas> GetOrBake(ResourceHandle<Model> model);
+
+    // Bakes albedo, normal and depth atlases of the LOD0 meshes of the model
+    std::shared_ptr<ImpostorAtlas> Bake(const Model& model, uint32_t framesPerSide, uint32_t frameResolution);
+
+    void Render(const std::vector<Renderer::ImpostorInfo>& impostorsToDraw);
+
+    void SetFramesPerSide(uint32_t frames) { m_framesPerSide = frames; }
+    void SetFrameResolution(uint32_t resolution) { m_frameResolution = resolution; }
+
+private:
+    class Impl;
+    std::unique_ptr<Impl> m_impl;
+
+    const Material::IBL& m_ibl;
+
+    uint32_t m_framesPerSide = 8;
+    uint32_t m_frameResolution = 256;
+};
+
+}
@@ -0,0 +1,64 @@
+#pragma once
+#include <glm/glm.hpp>
+#include <vector>
+
+namespace bee
+{
+class ThreadPool;
+
+// Range of clusters (inclusive) touched by a light
+struct LightClusterBounds
+{
+    glm::uvec3 min{ 0 };
+    glm::uvec3 max{ 0 };
+    bool visible = false;
+};
+
+/// <summary>
+/// Bins point lights into a grid of view frustum cells (froxels): screen tiles in x and y,
+/// exponentially distributed depth slices in z. The result is a compact list of light indices
+/// per cluster, so shading only has to loop over the lights that can reach a fragment.
+/// Mirrored in shaders/light_clusters.glsl, keep both in sync.
+/// </summary>
+class LightClusterGrid
+{
+public:
+    LightClusterGrid(glm::uvec3 dimensions);
+
+    // Bins the lights, given as view space spheres (xyz position, w range).
+    // With a thread pool the depth slices are binned in parallel.
+    void Build(const std::vector<glm::vec4>& viewSpaceLights, const glm::mat4& projection, float nearPlane, float farPlane, ThreadPool* threadPool = nullptr);
+
+    // Clusters covered by a view space sphere, conservative
+    LightClusterBounds ComputeBounds(glm::vec4 viewSpaceLight, const glm::mat4& projection) const;
+
+    uint32_t DepthSlice(float viewDepth) const;
+    uint32_t ClusterIndex(uint32_t x, uint32_t y, uint32_t z) const { return (z * m_dimensions.y + y) * m_dimensions.x + x; }
+
+    // Depth slice = log(depth) * scale + bias
+    float SliceScale() const { return m_sliceScale; }
+    float SliceBias() const { return m_sliceBias; }
+
+    glm::uvec3 Dimensions() const { return m_dimensions; }
+    uint32_t ClusterCount() const { return m_dimensions.x * m_dimensions.y * m_dimensions.z; }
+
+    // Per cluster: x offset into the light indices, y number of lights
+    const std::vector<glm::uvec2>& Clusters() const { return m_clusters; }
+    const std::vector<uint32_t>& LightIndices() const { return m_lightIndices; }
+
+private:
+    void CountSlices(uint32_t firstSlice, uint32_t lastSlice);
+    void FillSlices(uint32_t firstSlice, uint32_t lastSlice);
+
+    glm::uvec3 m_dimensions;
+    float m_nearPlane = 0.1f;
+    float m_farPlane = 1000.0f;
+    float m_sliceScale = 1.0f;
+    float m_sliceBias = 0.0f;
+
+    std::vector<LightClusterBounds> m_lightBounds;
+    std::vector<glm::uvec2> m_clusters;
+    std::vector<uint32_t> m_lightIndices;
+};
+
+}
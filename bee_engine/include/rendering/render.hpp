@@ -4,6 +4,7 @@
 #include <resources/resource_handle.hpp>
 #include <visit_struct/visit_struct.hpp>
 #include <rendering/render_components.hpp>
+#include "rendering/shadow_cascades.hpp"
 #include "resources/image/image.hpp"
 
 namespace bee
@@ -15,6 +16,8 @@ class GrassRenderer;
 class TerrainRenderer;
 class PostProcessManager;
 class Skybox;
+class ImpostorRenderer;
+struct ImpostorAtlas;
 
 struct DebugData
 {
@@ -42,6 +45,7 @@ private:
     std::unique_ptr<Skybox> m_skybox;
     std::unique_ptr<UIRenderer> m_ui;
     std::unique_ptr<IBLRenderer> m_ibl;
+    std::unique_ptr<ImpostorRenderer> m_impostorRenderer;
 
     DebugData m_debugFlags{};
 
@@ -51,6 +55,7 @@ private:
         std::shared_ptr<Mesh> mesh;
         std::shared_ptr<Material> material;
         MeshRenderer* meshRenderer;
+        bool dynamicShadowCaster;
     };
 
     //Internal type for renderer use
@@ -59,26 +64,40 @@ private:
         Light light;
     };
 
+    //Internal type for renderer use
+    struct ImpostorInfo {
+        glm::mat4 transform;
+        std::shared_ptr<ImpostorAtlas> atlas;
+    };
+
     std::vector<ObjectInfo> m_objectsToDraw{};
     std::vector<LightInfo> m_lightsToDraw{};
+    std::vector<ImpostorInfo> m_impostorsToDraw{};
 
     float m_ditherDistance{ 2.0f };
+    bool m_shadowCaching{ true };
+    CascadeSettings m_cascadeSettings{};
+    float m_gpuFrameTime{ 0.0f };
 
 public:
     friend ModelRenderer;
+    friend ImpostorRenderer;
     Renderer();
     ~Renderer();
 
     GrassRenderer& GetGrassRenderer() { return *m_grassRenderer; }
     PostProcessManager& GetPostProcessManager() { return *m_postProcessor; }
     ModelRenderer& GetModelRenderer() { return *m_modelRenderer; }
+    ImpostorRenderer& GetImpostorRenderer() { return *m_impostorRenderer; }
 
     //Queues a mesh to be rendered at the end of this frame
+    //Dynamic shadow casters are redrawn into the shadow maps every frame, static ones are cached
     void QueueMesh(
         const glm::mat4& transform,
         ResourceHandle<Mesh> mesh, 
         ResourceHandle<Material> material,
-        MeshRenderer* meshRenderer
+        MeshRenderer* meshRenderer,
+        bool dynamicShadowCaster = false
     );
     
     void QueueLight(
@@ -86,6 +105,12 @@ public:
         const Light& light
     );
 
+    //Queues a baked impostor billboard, used instead of the meshes of distant models
+    void QueueImpostor(
+        const glm::mat4& transform,
+        std::shared_ptr<ImpostorAtlas> atlas
+    );
+
     void Render();
 
     //TODO: move to post processing?
@@ -104,8 +129,17 @@ public:
     void SetDitherDistance(float distance) { m_ditherDistance = distance; }
     float& GetDitherDistance() { return m_ditherDistance; }
 
+    // Static shadow casters are only redrawn when the light or the cascade bounds change
+    bool& GetShadowCaching() { return m_shadowCaching; }
+
+    // Cascade splits, resolution and snapping of the directional light shadows
+    CascadeSettings& GetCascadeSettings() { return m_cascadeSettings; }
+
     DebugData& GetDebugFlags() { return m_debugFlags; }
 
+    // GPU time of a recent frame in milliseconds, a few frames behind. 0 until the first result is in.
+    float GetGPUFrameTime() const { return m_gpuFrameTime; }
+
     static const int m_maxDirLights = 4;
 };
 
@@ -18,6 +18,13 @@ namespace bee
 
 struct TagNoDraw {};
 
+// Marks a model that moves, so it is not baked into the cached shadow maps. Set on the root, the game copies it to
+// every entity below it.
+struct DynamicShadowCaster {};
+
+// Set on the meshes of a model while its impostor or HLOD proxy is drawn in its place
+struct TagReplacedByProxy {};
+
 struct Light
 {
     enum class Type
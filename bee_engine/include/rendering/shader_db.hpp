@@ -21,6 +21,7 @@ public:
         SKYBOX,
         GRASS,
         GRASS_COMPUTE,
+        GRASS_CULL,
         SHADOW,
         TONEMAPPING,
         FILTER_IBL,
@@ -38,7 +39,9 @@ public:
         WRITE_DISPLACMENTS,
         GAUSSIAN_9TAP_FILTER,
         DOF_COMPOSITE,
-        POPULATE_3DTEX_PERLIN,
+        IMPOSTOR,
+        IMPOSTOR_BAKE,
+        WIND_CHECK,
     };
 
     ShaderDB();
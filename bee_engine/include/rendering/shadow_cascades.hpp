@@ -0,0 +1,88 @@
+#pragma once
+#include <glm/glm.hpp>
+#include <array>
+
+namespace bee
+{
+
+// Matches the layers of the shadow map arrays and bee_cascadePlaneDistances in shaders/uniforms.glsl
+constexpr uint32_t MAX_SHADOW_CASCADES = 4;
+
+enum class CascadeSplitScheme
+{
+    Uniform,
+    Logarithmic,
+    // Blend of logarithmic and uniform, weighted by the split lambda
+    Practical
+};
+
+struct CascadeSettings
+{
+    CascadeSplitScheme scheme = CascadeSplitScheme::Practical;
+
+    // Practical scheme only: 1 is fully logarithmic, 0 fully uniform
+    float splitLambda = 0.8f;
+
+    // Distance from the camera covered by the cascades, capped by the camera far plane
+    float shadowDistance = 500.0f;
+
+    uint32_t cascadeCount = MAX_SHADOW_CASCADES;
+    uint32_t resolution = 2048;
+
+    // The cascade center moves in steps of this many texels. One texel removes shimmering,
+    // larger steps keep the matrix unchanged for longer (at the cost of some resolution).
+    uint32_t snapTexels = 1;
+};
+
+// Camera inputs of the fit, kept separate from Camera so the fit can be used and tested on its own
+struct CascadeCamera
+{
+    glm::mat4 inverseView = glm::mat4(1.0f);
+    float fieldOfView = glm::radians(60.0f);
+    float aspectRatio = 1.0f;
+    float nearPlane = 0.1f;
+    float farPlane = 1000.0f;
+};
+
+struct ShadowCascade
+{
+    glm::mat4 viewProjection = glm::mat4(1.0f);
+
+    // World space bounding sphere of the frustum slice
+    glm::vec3 center = glm::vec3(0.0f);
+    float radius = 0.0f;
+
+    // View depth range of the slice
+    float nearSplit = 0.0f;
+    float farSplit = 0.0f;
+
+    // World space size of a shadow map texel
+    float texelSize = 0.0f;
+};
+
+// Far distance of every cascade, the last one equals farPlane. Entries past count are left at farPlane.
+std::array<float, MAX_SHADOW_CASCADES> ComputeCascadeSplits(CascadeSplitScheme scheme, float lambda, float nearPlane, float farPlane, uint32_t count);
+
+// Smallest sphere around the [nearSplit, farSplit] slice of the camera frustum.
+// Its radius only depends on the split distances and the projection, so it does not change when the camera turns.
+glm::vec4 CascadeBoundingSphere(const CascadeCamera& camera, float nearSplit, float farSplit);
+
+// Light view with an orientation that only depends on the light direction (pointing towards the light)
+glm::mat4 CascadeLightView(glm::vec3 lightDirection);
+
+// Orthographic light matrix around the bounding sphere of a slice, with the center snapped to whole texels.
+// The depth range is clamped to the caster bounds, so depth precision is not spent on empty space.
+// Pass casterMin > casterMax when the bounds are unknown, the range then extends far towards the light.
+ShadowCascade FitCascade(const CascadeCamera& camera, float nearSplit, float farSplit, glm::vec3 lightDirection,
+    glm::vec3 casterMin, glm::vec3 casterMax, uint32_t resolution, uint32_t snapTexels);
+
+// Splits the camera frustum and fits all cascades. Entries past settings.cascadeCount are left default.
+std::array<ShadowCascade, MAX_SHADOW_CASCADES> FitCascades(const CascadeCamera& camera, glm::vec3 lightDirection,
+    glm::vec3 casterMin, glm::vec3 casterMax, const CascadeSettings& settings);
+
+// Fits cascades for a set of cameras and lights and checks that every frustum slice fits inside its cascade, that no
+// caster towards the light is clipped, that turning the camera keeps the texel size and that moving it keeps the
+// texel grid in place. Logs the first failure.
+bool CheckCascadeFit(const CascadeSettings& settings);
+
+}
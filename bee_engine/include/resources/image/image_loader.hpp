@@ -10,6 +10,8 @@ enum class ImageFormat {
     RGBA8,
     //Single channel image (byte)
     R8,
+    //Two colour channels (byte)
+    RG8,
     //Four colour channels (float)
     RGBA32F,
     //Single channel image (float)
@@ -17,7 +19,9 @@ enum class ImageFormat {
     //Three colour channels (byte) in sRGB colour space
     SRGB8,
     //Four colour channels (float) in sRGB colour space
-    SRGBA8
+    SRGBA8,
+    //Single channel image (unsigned short, normalized)
+    R16
 };
 
 class ImageLoader
@@ -0,0 +1,32 @@
+#pragma once
+#include <string>
+#include <platform/opengl/open_gl.hpp>
+
+namespace bee
+{
+
+// Layout of a texture cached in the save directory as a KTX 1.1 file
+struct CachedTextureLayout
+{
+    GLenum target;          // GL_TEXTURE_2D or GL_TEXTURE_CUBE_MAP
+    GLenum internalFormat;  // Format of the texture when uploaded
+    GLenum format;          // GL_RED, GL_RG, GL_RGB or GL_RGBA
+    GLenum type;            // GL_UNSIGNED_BYTE, GL_HALF_FLOAT or GL_FLOAT
+    uint32_t size;
+    uint32_t mipCount;
+
+    uint32_t FaceCount() const { return target == GL_TEXTURE_CUBE_MAP ? 6 : 1; }
+    GLenum FaceTarget(uint32_t face) const { return target == GL_TEXTURE_CUBE_MAP ? GL_TEXTURE_CUBE_MAP_POSITIVE_X + face : target; }
+
+    // Rows are padded to 4 bytes, as GL packs them by default and KTX requires
+    uint32_t FaceBytes(uint32_t level) const;
+};
+
+// Fills the texture from the cache file, returns false when there is none or it does not match the layout.
+// Textures with immutable storage are filled in place, others are allocated by the upload.
+bool LoadCachedTexture(const std::string& path, const CachedTextureLayout& layout, GLuint texture);
+
+// Reads every face and mip level back and writes them to the cache file, this waits for the GPU
+void SaveCachedTexture(const std::string& path, const CachedTextureLayout& layout, GLuint texture);
+
+}
@@ -1,6 +1,7 @@
 #pragma once
 
 #include "resources/resource_handle.hpp"
+#include "resources/mesh/mesh_loader.hpp"
 #include <glm/glm.hpp>
 
 namespace bee
@@ -9,6 +10,9 @@ namespace bee
 namespace mesh_utils
 {
 	void GenerateDisplacementData(ResourceHandle<Mesh> mesh, glm::mat4 modelMatrix, glm::vec3 minBounds, glm::vec3 maxBounds, float trunkPercentage, float distanceMaxBend);
+
+	// Reads the vertex and index data of a mesh LOD back from the GPU. Slow, meant for baking
+	MeshLoader::MeshData ReadMeshData(ResourceHandle<Mesh> mesh, uint32_t lod = 0);
 }
 
 }
\ No newline at end of file
@@ -5,6 +5,7 @@
 
 namespace bee
 {
+class TerrainHeightfield;
 
 struct TerrainChunk
 {
@@ -13,8 +14,11 @@ struct TerrainChunk
     int width   = 0;
     int height  = 0;
     ResourceHandle<Image> heightmap = {};
-    float tesselationFactor     = 1;
-    float tesselationDistance   = 0;
+    std::shared_ptr<const TerrainHeightfield> heightfield = {};  // CPU copy of the heightmap
+    float unitsPerTile          = 1;
+    float tesselationFactor     = 1;    // Maximum tessellation factor of a patch edge
+    float lodDistance           = 0;    // Range of the finest LOD level, every coarser level doubles it
+    float tessellationPixels    = 8;    // Screen space length a tessellated edge aims for
     float heightModifier        = 8;
     float normalScale           = 1;
 };
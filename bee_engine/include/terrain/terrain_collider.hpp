@@ -1,33 +1,49 @@
 #pragma once
 #include <code_utils/bee_utils.hpp>
 #include <cstdint>
+#include <memory>
 #include <glm/mat4x4.hpp>
 #include <glm/fwd.hpp>
 
-#include "core/fileio.hpp"
+#include <jolt/Jolt.h>
+#include <jolt/Physics/Body/BodyID.h>
+#include <jolt/Physics/Collision/Shape/Shape.h>
 
 namespace bee
 {
+class TerrainHeightfield;
+
+/// <summary>
+/// Terrain collision. Adds the heightfield to the physics system as a static Jolt height field body, so queries
+/// and bodies see the ground. The compressed shape is cached on disk, keyed by the heightfield and the terrain
+/// dimensions, and restored from there on the next load. Direct height sampling stays available for gameplay.
+/// </summary>
 class TerrainCollider
 {
 public:
-    TerrainCollider(bee::FileIO::Directory directory, const std::string& heightMapPath);
+    // The world to heightfield mapping is computed once, the terrain is not expected to move
+    TerrainCollider(std::shared_ptr<const TerrainHeightfield> heightfield, const glm::mat4& terrainWorld, glm::vec2 terrainSize, float heightModifier);
     ~TerrainCollider();
 
+    // Terrain height below a position, 0 outside the terrain
     float SampleHeightInWorld(glm::vec3 worldPosition) const;
+    void SampleHeightsInWorld(const glm::vec3* worldPositions, float* heights, size_t count) const;
+
+    const TerrainHeightfield& GetHeightfield() const { return *m_heightfield; }
+    JPH::BodyID GetBody() const { return m_body; }
 
 private:
     NON_COPYABLE(TerrainCollider);
     NON_MOVABLE(TerrainCollider);
 
-    uint8_t* m_heightMap;
-    int32_t m_heightMapWidth;
-    int32_t m_heightMapHeight;
+    JPH::ShapeRefC LoadOrBuildShape(glm::vec2 terrainSize, glm::vec3 scale) const;
+    JPH::ShapeRefC BuildShape(glm::vec2 terrainSize, glm::vec3 scale) const;
+    void CreateBody(const glm::mat4& terrainWorld, glm::vec2 terrainSize);
 
-    mutable glm::mat4 m_heightMapTransform;
-    mutable bool m_initialized{ false };
+    std::shared_ptr<const TerrainHeightfield> m_heightfield;
+    glm::mat4 m_worldToUV;
+    float m_heightModifier;
 
-    glm::mat4 GetHeightMapTransform() const;
+    JPH::BodyID m_body{};
 };
 }
-
@@ -0,0 +1,72 @@
+#pragma once
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <vector>
+#include <glm/glm.hpp>
+
+#include "core/fileio.hpp"
+#include "resources/resource_handle.hpp"
+
+namespace bee
+{
+
+class Image;
+
+/// <summary>
+/// Terrain heights decoded once from the heightmap, shared by everything that needs them on the CPU.
+/// Heights are normalized to 0..1 and sampled like the GPU samples the heightmap texture: bilinear between texel
+/// centres, clamped to the edge. A min/max pyramid answers height range queries over any area in constant time.
+/// </summary>
+class TerrainHeightfield
+{
+public:
+    TerrainHeightfield(uint32_t width, uint32_t height, std::vector<uint16_t> samples);
+
+    // Decodes the red channel of the image at 16 bits, the channel the terrain shaders sample.
+    // Logs an error and returns a flat heightfield on failure.
+    static std::shared_ptr<const TerrainHeightfield> FromFile(FileIO::Directory directory, const std::string& path);
+
+    // Uploads the samples as the R16 heightmap texture the terrain shaders sample, so the file is decoded only once.
+    // The path is kept on the handle for serialization.
+    ResourceHandle<Image> CreateImage(const std::string& path) const;
+
+    uint32_t GetWidth() const { return m_width; }
+    uint32_t GetHeight() const { return m_height; }
+
+    // Hash of the samples, identifies the heightfield in files derived from it
+    uint64_t GetHash() const { return m_hash; }
+
+    float GetTexel(uint32_t x, uint32_t y) const { return static_cast<float>(m_samples[y * m_width + x]) * m_normalize; }
+
+    // Normalized height at a texture coordinate
+    float Sample(glm::vec2 uv) const;
+    void Sample(const glm::vec2* uvs, float* heights, size_t count) const;
+
+    // Conservative normalized min (x) and max (y) height of the area between two texture coordinates
+    glm::vec2 GetRange(glm::vec2 uvMin, glm::vec2 uvMax) const;
+
+private:
+    struct RangeLevel
+    {
+        uint32_t width = 0;
+        uint32_t height = 0;
+        std::vector<uint16_t> min;
+        std::vector<uint16_t> max;
+    };
+
+    void BuildRangeLevels();
+
+    uint32_t m_width = 0;
+    uint32_t m_height = 0;
+    glm::vec2 m_size{ 0.0f };
+    glm::vec2 m_maxTexel{ 0.0f };
+    float m_normalize = 1.0f / 65535.0f;
+    std::vector<uint16_t> m_samples;
+    uint64_t m_hash = 0;
+
+    // Level n holds the range of blocks of 2^n by 2^n texels
+    std::vector<RangeLevel> m_rangeLevels;
+};
+
+}
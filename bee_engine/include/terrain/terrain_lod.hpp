@@ -0,0 +1,72 @@
+#pragma once
+#include <array>
+#include <vector>
+#include <glm/glm.hpp>
+
+namespace bee
+{
+class Plane;
+class TerrainHeightfield;
+
+constexpr uint32_t TERRAIN_MAX_LOD_LEVELS = 8;
+// Quads along one side of the shared grid patch, halved for nodes drawn with their parent's detail
+constexpr uint32_t TERRAIN_PATCH_RESOLUTION = 16;
+
+// Mirrors TerrainNode in shaders/tessellation/tess.vert (std430)
+struct TerrainNodeGPU
+{
+    glm::vec4 area{ 0.0f };  // xy local min corner, z size, w LOD level
+};
+
+struct TerrainLODSettings
+{
+    glm::vec2 terrainMin{ 0.0f };  // Local space
+    glm::vec2 terrainMax{ 0.0f };
+    float maxHeight = 1.0f;
+    const TerrainHeightfield* heightfield = nullptr;  // Tightens the node height bounds, 0..maxHeight without it
+    float leafSize = 16.0f;        // Size of the finest nodes
+    float lodDistance = 50.0f;     // Range of the finest level, doubles every level
+    float morphRatio = 0.7f;       // Fraction of a level's range after which it starts morphing into the next
+
+    bool operator==(const TerrainLODSettings& other) const;
+    bool operator!=(const TerrainLODSettings& other) const { return !(*this == other); }
+};
+
+/// <summary>
+/// Continuous distance-dependent LOD (CDLOD) over an implicit quadtree of terrain nodes.
+/// Every level covers twice the distance of the previous one. Nodes in range of the next finer level are split,
+/// quadrants out of that range are drawn with the parent's grid (half resolution patch). Vertices morph into the
+/// grid of the next coarser level towards the end of their range, so there are no seams between levels.
+/// </summary>
+class TerrainLOD
+{
+public:
+    void Configure(const TerrainLODSettings& settings);
+    const TerrainLODSettings& GetSettings() const { return m_settings; }
+
+    // Selects the nodes to draw around a local space eye, frustum culled in world space.
+    // Full nodes use the full resolution patch, half nodes the half resolution one.
+    void Select(glm::vec3 eye, const glm::mat4& world, const std::array<Plane, 6>& frustum,
+        std::vector<TerrainNodeGPU>& fullNodes, std::vector<TerrainNodeGPU>& halfNodes) const;
+
+    // Every node of one level, independent of the camera
+    void SelectLevel(uint32_t level, std::vector<TerrainNodeGPU>& nodes) const;
+
+    uint32_t GetLevelCount() const { return m_levelCount; }
+    float GetNodeSize(uint32_t level) const { return m_settings.leafSize * static_cast<float>(1u << level); }
+
+    // Distance range over which the vertices of every level morph, x start, y end
+    const std::array<glm::vec2, TERRAIN_MAX_LOD_LEVELS>& GetMorphRanges() const { return m_morphRanges; }
+
+private:
+    glm::vec2 GetHeightRange(glm::vec2 min, float size) const;
+    bool SelectNode(glm::vec2 min, uint32_t level, glm::vec3 eye, const glm::mat4& world, const std::array<Plane, 6>& frustum,
+        std::vector<TerrainNodeGPU>& fullNodes, std::vector<TerrainNodeGPU>& halfNodes) const;
+
+    TerrainLODSettings m_settings{};
+    uint32_t m_levelCount = 0;
+    std::array<float, TERRAIN_MAX_LOD_LEVELS> m_ranges{};
+    std::array<glm::vec2, TERRAIN_MAX_LOD_LEVELS> m_morphRanges{};
+};
+
+}
@@ -2,6 +2,7 @@
 
 #include <entt/entity/fwd.hpp>
 #include <memory>
+#include <glm/glm.hpp>
 
 #include "resources/resource_handle.hpp"
 #include "resources/material/material.hpp"
@@ -9,6 +10,7 @@
 namespace bee
 {
     struct DebugData;
+    class Camera;
 
 
     class TerrainRenderer
@@ -18,9 +20,14 @@ public:
     ~TerrainRenderer();
     void Submit(entt::entity entity);
     void CleanUp(entt::entity entity);
-    void Render();
+    // Selects the quadtree nodes around the camera and draws them
+    void Render(const Camera& camera);
+    // Camera independent, so cached shadow maps stay valid while the camera moves
     void DepthOnlyRender(std::shared_ptr<Shader> depthOnlyShader);
 
+    // World space bounds of all chunks, including the heightmap displacement. False when there is no terrain.
+    bool GetBounds(glm::vec3& minBounds, glm::vec3& maxBounds) const;
+
 private:
     class Impl;
     std::unique_ptr<Impl> m_impl;
@@ -139,6 +139,16 @@ private:
 	A m_archive;
 };
 
+// Loads a named value that older files may not contain yet, keeping the current value when it is missing
+template<typename A, typename T>
+void LoadOptional(A& archive, const char* name, T& value)
+{
+	try {
+		archive(cereal::make_nvp(name, value));
+	}
+	catch (const cereal::Exception&) {}
+}
+
 using JSONSaver = SaveVisitor<cereal::JSONOutputArchive>;
 using JSONLoader = LoadVisitor<cereal::JSONInputArchive>;
 
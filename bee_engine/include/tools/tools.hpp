@@ -23,6 +23,14 @@ inline uint32_t HashCombine(uint32_t lhs, uint32_t rhs)
     return lhs;
 }
 
+// 64 bit FNV-1a, stable between runs so it can key files on disk
+inline uint64_t HashBytes(const void* data, size_t size, uint64_t hash = 14695981039346656037ull)
+{
+    const auto* bytes = static_cast<const unsigned char*>(data);
+    for (size_t i = 0; i < size; i++) hash = (hash ^ bytes[i]) * 1099511628211ull;
+    return hash;
+}
+
 inline glm::vec3 to_vec3(const glm::vec2& vec) { return glm::vec3(vec.x, vec.y, 0.0f); }
 
 inline glm::vec3 to_vec3(std::vector<double> array) { return glm::vec3((float)array[0], (float)array[1], (float)array[2]); }
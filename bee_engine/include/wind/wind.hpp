@@ -1,6 +1,7 @@
 #pragma once
 
 #include "resources/resource_handle.hpp"
+#include "wind/wind_field.hpp"
 
 namespace bee
 {
@@ -21,13 +22,24 @@ public:
 	ResourceHandle<Image3D> GetWindImage();
 	WindAmbient GetWindParameters();
 
+	// CPU copy of the wind texture
+	const WindField& GetWindField() const { return m_field; }
+
+	// Wind push at a noise coordinate and time in seconds, as ambientWindMovement() in shaders/wind.glsl
+	glm::vec3 GetWindMovement(glm::vec2 coordinate, float time) const;
+
+	// Evaluates ambientWindMovement() on the GPU over a grid of coordinates and compares it with GetWindMovement.
+	// Reads the time from the camera buffer, so a frame has to be rendered first. Waits for the GPU.
+	bool CheckShader();
+
 private:
 	class Impl;
     std::unique_ptr<Impl> m_impl;
 
 	WindAmbient m_ambientWind;
+	WindField m_field;
 	ResourceHandle<Image3D> m_wind;
 };
 
 
-}
\ No newline at end of file
+}
@@ -0,0 +1,39 @@
+#pragma once
+#include <cstdint>
+#include <vector>
+#include <glm/glm.hpp>
+
+namespace bee
+{
+
+// Texels along every side of the wind field volume
+constexpr uint32_t WIND_FIELD_SIZE = 64;
+// Noise cells along every side, the noise repeats after this many so the volume tiles
+constexpr uint32_t WIND_FIELD_PERIOD = 8;
+// Noise coordinate units per second the wind moves through the depth of the volume, as in shaders/wind.glsl
+constexpr float WIND_FIELD_EVOLUTION = 0.01f;
+
+/// <summary>
+/// Small tileable volume of two channel gradient noise (RG8) that drives the ambient wind. The texels are generated
+/// on the CPU and uploaded by WindMap, so sampling here returns what the shaders read from the wind texture.
+/// Octaves and scrolling mirror shaders/wind.glsl.
+/// </summary>
+class WindField
+{
+public:
+    explicit WindField(uint32_t seed = 0);
+
+    // RG8 texels, x fastest, then y, then z
+    const std::vector<uint8_t>& GetTexels() const { return m_texels; }
+
+    // Trilinear sample with repeat wrapping of the volume at a texture coordinate, in -1..1
+    glm::vec2 Sample(glm::vec3 uvw) const;
+
+    // Both octaves, as windNoise() in shaders/wind.glsl
+    glm::vec2 SampleOctaves(glm::vec3 coordinate) const;
+
+private:
+    std::vector<uint8_t> m_texels;
+};
+
+}
@@ -43,6 +43,16 @@ JPH::PhysicsSystem &EngineClass::PhysicsSystem()
   return *m_physicsSystem->m_joltPhysicsSystem;
 }
 
+ShapeCache& EngineClass::PhysicsShapeCache()
+{
+  return m_physicsSystem->GetShapeCache();
+}
+
+const std::vector<SensorEvent>& EngineClass::PhysicsSensorEvents()
+{
+  return m_physicsSystem->GetSensorEvents();
+}
+
 void EngineClass::Initialize(Mode mode) 
 {
     Log::Initialize();
@@ -102,6 +112,7 @@ void EngineClass::Run(std::function<void(float)> mainLoop)
 
         mainLoop(dt);
 
+        m_physicsSystem->Update(m_time->GetFixedTimeStep().count() / 1000.0f, m_time->GetFixedStepsNeeded());
         m_grassManager->Update(dt);
         m_displacementManager->Update(dt);
 
@@ -124,6 +135,10 @@ void bee::EngineClass::RenderSystems()
 ThreadPool &bee::EngineClass::ThreadPool()
 {
     if (!m_pool)
-        m_pool = std::make_unique<bee::ThreadPool>(4);
+    {
+        // Shared by engine tasks and physics jobs, one hardware thread is left for the main thread
+        const unsigned int threads = std::thread::hardware_concurrency();
+        m_pool = std::make_unique<bee::ThreadPool>(threads > 1 ? threads - 1 : 1);
+    }
     return *m_pool;
 }
@@ -19,4 +19,11 @@ void bee::Time::Tick()
         m_fixedTimeAccumulator -= m_fixedTimestep;
         m_physicsStepsNecessary++;
     }
+
+    //Drop the time a hitch left over the cap, gameplay and physics both read the capped count
+    if (m_physicsStepsNecessary > m_maxFixedSteps)
+    {
+        m_physicsStepsNecessary = m_maxFixedSteps;
+        m_fixedTimeAccumulator = DeltaMS(0.0f);
+    }
 }
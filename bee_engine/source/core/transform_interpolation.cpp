@@ -0,0 +1,53 @@
+#include <precompiled/engine_precompiled.hpp>
+#include "core/transform_interpolation.hpp"
+
+#include "core/transform.hpp"
+#include <entt/entity/registry.hpp>
+
+bee::InterpolatedTransform::InterpolatedTransform(const Transform& transform)
+    : previousTranslation(transform.Translation), currentTranslation(transform.Translation), renderedTranslation(transform.Translation),
+      previousRotation(transform.Rotation), currentRotation(transform.Rotation), renderedRotation(transform.Rotation)
+{
+}
+
+void bee::BeginFixedSteps(entt::registry& registry)
+{
+    for (auto&& [entity, transform, interpolated] : registry.view<Transform, InterpolatedTransform>().each())
+    {
+        // Anything other than the blend written last frame was placed there on purpose, it is not blended from the old pose
+        if (transform.Translation != interpolated.renderedTranslation || transform.Rotation != interpolated.renderedRotation)
+        {
+            interpolated = InterpolatedTransform(transform);
+            continue;
+        }
+
+        transform.SetTranslation(interpolated.currentTranslation);
+        transform.SetRotation(interpolated.currentRotation);
+    }
+}
+
+void bee::BeginFixedStep(entt::registry& registry)
+{
+    for (auto&& [entity, transform, interpolated] : registry.view<Transform, InterpolatedTransform>().each())
+    {
+        interpolated.previousTranslation = transform.Translation;
+        interpolated.previousRotation = transform.Rotation;
+    }
+}
+
+void bee::InterpolateTransforms(entt::registry& registry, float alpha)
+{
+    alpha = glm::clamp(alpha, 0.0f, 1.0f);
+
+    for (auto&& [entity, transform, interpolated] : registry.view<Transform, InterpolatedTransform>().each())
+    {
+        interpolated.currentTranslation = transform.Translation;
+        interpolated.currentRotation = transform.Rotation;
+
+        interpolated.renderedTranslation = glm::mix(interpolated.previousTranslation, interpolated.currentTranslation, alpha);
+        interpolated.renderedRotation = glm::slerp(interpolated.previousRotation, interpolated.currentRotation, alpha);
+
+        transform.SetTranslation(interpolated.renderedTranslation);
+        transform.SetRotation(interpolated.renderedRotation);
+    }
+}
@@ -3,170 +3,342 @@
 
 #include <platform/opengl/open_gl.hpp>
 
-#include <core/time.hpp>
 #include "core/ecs.hpp"
 #include "core/engine.hpp"
 #include "core/fileio.hpp"
 #include "core/transform.hpp"
 #include "displacement/displacer.hpp"
-#include "platform/opengl/gl_uniform.hpp"
 #include "platform/opengl/shader_gl.hpp"
+#include "platform/opengl/uniforms_gl.hpp"
 #include "rendering/shader_db.hpp"
 #include "resources/resource_manager.hpp"
 #include "resources/image/image_gl.hpp"
 #include "resources/image/image_loader.hpp"
 #include "tools/log.hpp"
 
+namespace
+{
+// Texels along one side of a tile, matches the work group size of write_displacement.comp
+constexpr int32_t DISPLACEMENT_TILE_SIZE = 16;
+// Seconds a displaced texel takes to fade back to neutral, with some margin for long frames
+constexpr float DISPLACEMENT_RECOVERY_TIME = 0.5f;
+
+uint64_t TileKey(glm::ivec2 tile) { return (static_cast<uint64_t>(static_cast<uint32_t>(tile.x)) << 32) | static_cast<uint32_t>(tile.y); }
+glm::ivec2 TileFromKey(uint64_t key) { return glm::ivec2(static_cast<int32_t>(key >> 32), static_cast<int32_t>(key & 0xFFFFFFFF)); }
+
+glm::ivec2 FloorDiv(glm::ivec2 value, int32_t divisor)
+{
+    return glm::ivec2(glm::floor(glm::vec2(value) / static_cast<float>(divisor)));
+}
+}
+
 class bee::DisplacementManager::Impl
 {
 public:
-    Uniform<std::array<DisplacementWriteParams, 16>> m_displacementParams;
+    // Mirrors DisplacementTile in shaders/displacement/write_displacement.comp (std430)
+    struct DisplacementTileGPU
+    {
+        glm::ivec2 tile{ 0 };
+        uint32_t displacerOffset = 0;
+        uint32_t displacerCount = 0;
+    };
+
+    // Mirrors DisplacementWriteParams in shaders/displacement/write_displacement.comp (std430)
+    struct DisplacerGPU
+    {
+        glm::vec2 position{ 0.0f };  // Relative to the focus
+        float radius = 0.0f;
+        float padding = 0.0f;
+    };
 
     void SetupTexture(ResourceHandle<bee::Image>, int32_t width, int32_t height);
-    void ClearTexture(ResourceHandle<bee::Image>, int32_t width, int32_t height, std::shared_ptr<bee::Shader> clearCompute);
+    void AddTiles(glm::ivec2 tileMin, glm::ivec2 tileMax);
+    void AddEnteringTiles(glm::ivec2 windowSize);
+    template <typename T>
+    void Upload(GLuint buffer, size_t& capacity, const std::vector<T>& data);
+
+    // Tile rectangle (min xy, max zw) each displacer covered last update
+    std::unordered_map<entt::entity, glm::ivec4> m_footprints;
+    std::unordered_map<entt::entity, glm::ivec4> m_nextFootprints;
+    // Displacers touching every world tile, rebuilt each update
+    std::unordered_map<uint64_t, std::vector<uint32_t>> m_spatialHash;
+    // Seconds until a tile displacers left has faded back to neutral
+    std::unordered_map<uint64_t, float> m_recovering;
+    std::vector<uint64_t> m_dirtyTiles;
+
+    std::vector<DisplacerGPU> m_displacers;
+    std::vector<uint32_t> m_displacerIndices;
+    std::vector<DisplacementTileGPU> m_tiles;
+
+    GLuint m_tilesSSBO = 0;
+    GLuint m_displacersSSBO = 0;
+    GLuint m_displacerIndicesSSBO = 0;
+    size_t m_tilesCapacity = 0;
+    size_t m_displacersCapacity = 0;
+    size_t m_displacerIndicesCapacity = 0;
+
+    // World texels covered by the map, the window follows the focus
+    bool m_windowValid = false;
+    glm::ivec2 m_windowMin{ 0 };
+    glm::ivec2 m_previousWindowMin{ 0 };
+    float m_texelSize = 1.0f;
 };
 
 bee::DisplacementManager::DisplacementManager() : m_impl(std::make_unique<Impl>())
 {
-    m_clearCompute = Engine.ShaderDB()[ShaderDB::Type::CLEAR_TEX];
+    assert((m_textureWidth & (m_textureWidth - 1)) == 0 && (m_textureHeight & (m_textureHeight - 1)) == 0);
+    assert(m_textureWidth % DISPLACEMENT_TILE_SIZE == 0 && m_textureHeight % DISPLACEMENT_TILE_SIZE == 0);
+
     m_displacementWriteCompute = Engine.ShaderDB()[ShaderDB::Type::WRITE_DISPLACMENTS];
 
     m_displacementTexture = Engine.Resources().Images().FromRawData(nullptr, ImageFormat::RGBA8, m_textureWidth, m_textureHeight);
-    m_prevDisplacementTexture = Engine.Resources().Images().FromRawData(nullptr, ImageFormat::RGBA8, m_textureWidth, m_textureHeight);
-
     m_impl->SetupTexture(m_displacementTexture, m_textureWidth, m_textureHeight);
-    m_impl->SetupTexture(m_prevDisplacementTexture, m_textureWidth, m_textureHeight);
 
-    m_impl->m_displacementParams.SetName("Displacement params buffer");
+    glCreateBuffers(1, &m_impl->m_tilesSSBO);
+    glCreateBuffers(1, &m_impl->m_displacersSSBO);
+    glCreateBuffers(1, &m_impl->m_displacerIndicesSSBO);
+    LabelGL(GL_BUFFER, m_impl->m_tilesSSBO, "Displacement tiles");
+    LabelGL(GL_BUFFER, m_impl->m_displacersSSBO, "Displacers");
+    LabelGL(GL_BUFFER, m_impl->m_displacerIndicesSSBO, "Displacer indices");
 }
 
 bee::DisplacementManager::~DisplacementManager()
 {
+    glDeleteBuffers(1, &m_impl->m_tilesSSBO);
+    glDeleteBuffers(1, &m_impl->m_displacersSSBO);
+    glDeleteBuffers(1, &m_impl->m_displacerIndicesSSBO);
 }
 
 void bee::DisplacementManager::Update(float deltaTime)
 {
-    PushDebugGL("Displacement pass");
     auto displacerView{ Engine.ECS().Registry.view<const Displacer, const Transform>()};
     auto displacerFocusView{ Engine.ECS().Registry.view<DisplacerFocus, const Transform>()};
+    if (displacerFocusView.size_hint() == 0) return;
+
+    PushDebugGL("Displacement pass");
+
+    entt::entity displacerFocusEntity = *displacerFocusView.begin();
+    auto [displacerFocus, focusTransform] { displacerFocusView.get(displacerFocusEntity) };
+
+    const float angle = glm::eulerAngles(focusTransform.GetRotation()).z;
+    const glm::vec3 focusPosition = focusTransform.GetTranslation();
+    const glm::ivec2 windowSize(m_textureWidth, m_textureHeight);
 
-    glm::vec3 displacementFocusPos{};
-    float displacementInfluenceSize{};
-    float angle{};
+    // A new texel size moves every texel, start over
+    const float texelSize = displacerFocus.influenceSize / static_cast<float>(m_textureWidth);
+    if (texelSize != m_impl->m_texelSize)
+    {
+        m_impl->m_texelSize = texelSize;
+        m_impl->m_windowValid = false;
+    }
+
+    // 1. Move the window with the focus, texels entering it are cleared.
+    m_impl->m_previousWindowMin = m_impl->m_windowMin;
+    m_impl->m_windowMin = glm::ivec2(glm::floor(glm::vec2(focusPosition) / texelSize)) - windowSize / 2;
+    const glm::ivec2 windowTileMin = FloorDiv(m_impl->m_windowMin, DISPLACEMENT_TILE_SIZE);
+    const glm::ivec2 windowTileMax = FloorDiv(m_impl->m_windowMin + windowSize - 1, DISPLACEMENT_TILE_SIZE);
 
-    if (displacerFocusView.size_hint() > 0)
+    m_impl->m_dirtyTiles.clear();
+    const glm::ivec2 windowMove = glm::abs(m_impl->m_windowMin - m_impl->m_previousWindowMin);
+    if (!m_impl->m_windowValid || windowMove.x >= windowSize.x || windowMove.y >= windowSize.y)
+    {
+        // Nothing from the previous window is kept
+        m_impl->m_previousWindowMin = m_impl->m_windowMin - windowSize * 2;
+        m_impl->m_recovering.clear();
+        m_impl->AddTiles(windowTileMin, windowTileMax);
+        m_impl->m_windowValid = true;
+    }
+    else
     {
-        entt::entity displacerFocusEntity = *displacerFocusView.begin();
-        auto [displacerFocus, focusTransform] { displacerFocusView.get(displacerFocusEntity) };
+        m_impl->AddEnteringTiles(windowSize);
+    }
 
-        angle = glm::eulerAngles(focusTransform.GetRotation()).z;
+    // 2. Tiles displacers left keep fading until they are neutral again.
+    for (auto it = m_impl->m_recovering.begin(); it != m_impl->m_recovering.end();)
+    {
+        it->second -= deltaTime;
+        const glm::ivec2 tile = TileFromKey(it->first);
+        const bool inWindow = glm::all(glm::greaterThanEqual(tile, windowTileMin)) && glm::all(glm::lessThanEqual(tile, windowTileMax));
+        if (it->second <= 0.0f || !inWindow)
+        {
+            it = m_impl->m_recovering.erase(it);
+            continue;
+        }
 
-        glm::mat4 focusWorld = focusTransform.World();
-        glm::mat4 inverseFocusWorld = glm::inverse(focusWorld);
-        displacementFocusPos = *reinterpret_cast<const glm::vec3*>(&focusWorld[3][0]);
-        displacementInfluenceSize = displacerFocus.influenceSize;
+        m_impl->m_dirtyTiles.push_back(it->first);
+        ++it;
+    }
+
+    // 3. Hash the displacers by the tiles they cover, both their previous and current footprints are rewritten.
+    m_impl->m_spatialHash.clear();
+    m_impl->m_displacers.clear();
+    m_impl->m_nextFootprints.clear();
+    for (auto displacerEntity : displacerView)
+    {
+        auto [terrainDisplacer, displacerTransform] = displacerView.get(displacerEntity);
+
+        const glm::mat4 displacerWorld{ displacerTransform.World() };
+        const glm::vec2 position = glm::vec2(displacerWorld[3]) - glm::vec2(focusPosition);
 
-        std::vector<DisplacementWriteParams> displacementParams{};
+        // The shape reaches one radius past a segment that extends one radius from the displacer
+        const float reach = terrainDisplacer.radius * 2.0f + texelSize;
+        const glm::vec2 worldPosition = glm::vec2(displacerWorld[3]);
+        const glm::ivec2 texelMin = glm::ivec2(glm::floor((worldPosition - reach) / texelSize));
+        const glm::ivec2 texelMax = glm::ivec2(glm::floor((worldPosition + reach) / texelSize));
+        const glm::ivec4 footprint(FloorDiv(texelMin, DISPLACEMENT_TILE_SIZE), FloorDiv(texelMax, DISPLACEMENT_TILE_SIZE));
 
-        for (auto displacerEntity : displacerView)
+        const uint32_t index = static_cast<uint32_t>(m_impl->m_displacers.size());
+        m_impl->m_displacers.push_back({ position, terrainDisplacer.radius });
+        m_impl->m_nextFootprints[displacerEntity] = footprint;
+
+        const glm::ivec2 tileMin = glm::max(glm::ivec2(footprint.x, footprint.y), windowTileMin);
+        const glm::ivec2 tileMax = glm::min(glm::ivec2(footprint.z, footprint.w), windowTileMax);
+        for (int32_t y = tileMin.y; y <= tileMax.y; y++)
         {
-            if (displacementParams.size() == m_impl->m_displacementParams->size())
+            for (int32_t x = tileMin.x; x <= tileMax.x; x++)
             {
-                Log::Warn("Maximum amount of displacers reached (" + std::to_string(m_impl->m_displacementParams->size()) + ")");
-                break;
+                const uint64_t key = TileKey(glm::ivec2(x, y));
+                m_impl->m_spatialHash[key].push_back(index);
+                m_impl->m_recovering[key] = DISPLACEMENT_RECOVERY_TIME;
+                m_impl->m_dirtyTiles.push_back(key);
             }
+        }
+    }
 
-            auto [terrainDisplacer, displacerTransform] = displacerView.get(displacerEntity);
+    for (const auto& [entity, footprint] : m_impl->m_footprints)
+    {
+        m_impl->AddTiles(glm::max(glm::ivec2(footprint.x, footprint.y), windowTileMin),
+                         glm::min(glm::ivec2(footprint.z, footprint.w), windowTileMax));
+    }
+    std::swap(m_impl->m_footprints, m_impl->m_nextFootprints);
 
-            // Get world position of current displacer.
-            glm::mat4 displacerWorld{ displacerTransform.World() };
-            glm::vec4 position{ displacerWorld[3][0], displacerWorld[3][1],
-                               displacerWorld[3][2], 1.0 };
+    // 4. Every dirty tile once, with the displacers touching it.
+    std::sort(m_impl->m_dirtyTiles.begin(), m_impl->m_dirtyTiles.end());
+    m_impl->m_dirtyTiles.erase(std::unique(m_impl->m_dirtyTiles.begin(), m_impl->m_dirtyTiles.end()), m_impl->m_dirtyTiles.end());
 
-            // Convert world position of displacer to local position of the focus displacer.
-            position = inverseFocusWorld * position;
+    m_impl->m_tiles.clear();
+    m_impl->m_displacerIndices.clear();
+    for (uint64_t key : m_impl->m_dirtyTiles)
+    {
+        Impl::DisplacementTileGPU tile{};
+        tile.tile = TileFromKey(key);
+        tile.displacerOffset = static_cast<uint32_t>(m_impl->m_displacerIndices.size());
 
-            DisplacementWriteParams param;
-            // Set UV position coordinates.
-            param.position = glm::vec2{ position.x, position.y };
-            param.radius = terrainDisplacer.radius;
-            displacementParams.emplace_back(param);
+        const auto displacers = m_impl->m_spatialHash.find(key);
+        if (displacers != m_impl->m_spatialHash.end())
+        {
+            m_impl->m_displacerIndices.insert(m_impl->m_displacerIndices.end(), displacers->second.begin(), displacers->second.end());
+            tile.displacerCount = static_cast<uint32_t>(displacers->second.size());
         }
 
-        glm::vec3 displacerFocusVelocity{ displacementFocusPos - displacerFocus.previousPosition };
-        glm::vec2 vel2d{ glm::vec4(displacerFocusVelocity.x, displacerFocusVelocity.y, 0.0f, 0.0f) };
+        m_impl->m_tiles.push_back(tile);
+    }
 
-        // Steps:
-        // 1. Copy displacement to GPU memory (patch UBO).
-        std::copy(displacementParams.begin(), displacementParams.end(), m_impl->m_displacementParams.get()->begin());
-        m_impl->m_displacementParams.Patch();
+    displacerFocus.previousPosition = focusPosition;
 
-        // 2. Copy current displacement into the previousDisplacement.
-        std::swap(m_prevDisplacementTexture, m_displacementTexture);
+    if (m_impl->m_tiles.empty())
+    {
+        PopDebugGL();
+        return;
+    }
 
-        // 3. Clear the current displacement surface.
-        m_impl->ClearTexture(m_displacementTexture, m_textureWidth, m_textureWidth, m_clearCompute);
+    // 5. Rewrite the dirty tiles in place.
+    m_impl->Upload(m_impl->m_tilesSSBO, m_impl->m_tilesCapacity, m_impl->m_tiles);
+    m_impl->Upload(m_impl->m_displacersSSBO, m_impl->m_displacersCapacity, m_impl->m_displacers);
+    m_impl->Upload(m_impl->m_displacerIndicesSSBO, m_impl->m_displacerIndicesCapacity, m_impl->m_displacerIndices);
+
+    m_displacementWriteCompute->Activate();
+    glUniform2i(m_displacementWriteCompute->GetParameter("u_windowMin")->GetLocation(), m_impl->m_windowMin.x, m_impl->m_windowMin.y);
+    glUniform2i(m_displacementWriteCompute->GetParameter("u_previousWindowMin")->GetLocation(), m_impl->m_previousWindowMin.x,
+                m_impl->m_previousWindowMin.y);
+    m_displacementWriteCompute->GetParameter("u_focusPosition")->SetValue(glm::vec2(focusPosition));
+    m_displacementWriteCompute->GetParameter("u_texelSize")->SetValue(texelSize);
+    m_displacementWriteCompute->GetParameter("u_deltaTime")->SetValue(deltaTime);
+    m_displacementWriteCompute->GetParameter("u_angle")->SetValue(angle - glm::pi<float>() / 2.0f);
+    m_displacementWriteCompute->GetParameter("u_influenceSize")->SetValue(displacerFocus.influenceSize);
+
+    glBindBufferBase(GL_SHADER_STORAGE_BUFFER, DISPLACEMENT_TILES_SSBO_LOCATION, m_impl->m_tilesSSBO);
+    glBindBufferBase(GL_SHADER_STORAGE_BUFFER, DISPLACERS_SSBO_LOCATION, m_impl->m_displacersSSBO);
+    glBindBufferBase(GL_SHADER_STORAGE_BUFFER, DISPLACER_INDICES_SSBO_LOCATION, m_impl->m_displacerIndicesSSBO);
+
+    glBindImageTexture(1, m_displacementTexture.Retrieve()->handle, 0, GL_FALSE, 0, GL_READ_WRITE, GL_RGBA8);
+    glDispatchCompute(static_cast<GLuint>(m_impl->m_tiles.size()), 1, 1);
+    glMemoryBarrier(GL_SHADER_IMAGE_ACCESS_BARRIER_BIT | GL_TEXTURE_FETCH_BARRIER_BIT);
 
-        // 4. Write displacements into the current surface.
-        auto seconds = Engine.GetTime().GetTotalTime().count() / 1000.0f;
+    PopDebugGL();
+}
 
-        m_displacementWriteCompute->Activate();
-        m_displacementWriteCompute->GetParameter("u_time")->SetValue(seconds);
-        m_displacementWriteCompute->GetParameter("u_deltaTime")->SetValue(deltaTime);
-        m_displacementWriteCompute->GetParameter("u_velocity")->SetValue(vel2d);
-        m_displacementWriteCompute->GetParameter("u_angle")->SetValue(angle - glm::pi<float>() / 2.0f);
-        m_displacementWriteCompute->GetParameter("u_influenceSize")->SetValue(displacementInfluenceSize);
-        m_displacementWriteCompute->GetParameter("u_displacementCount")->SetValue(static_cast<int32_t>(displacementParams.size()));
+glm::mat4 bee::DisplacementManager::DisplacementMapTransform() const
+{
+    glm::mat4 matrix{ glm::identity<glm::mat4>() };
+    if (m_impl->m_windowValid)
+    {
+        const glm::vec2 windowSize = glm::vec2(m_textureWidth, m_textureHeight) * m_impl->m_texelSize;
+        matrix = glm::scale(matrix, glm::vec3{ 1.0f / windowSize, 1.0f });
+        matrix = glm::translate(matrix, -glm::vec3{ glm::vec2(m_impl->m_windowMin) * m_impl->m_texelSize, 0.0f });
+    }
 
+    return matrix;
+}
 
-        glBindBufferBase(GL_UNIFORM_BUFFER, 10, m_impl->m_displacementParams.buffer);
+glm::vec2 bee::DisplacementManager::DisplacementMapOffset() const
+{
+    const glm::ivec2 mapSize(m_textureWidth, m_textureHeight);
+    return glm::vec2(m_impl->m_windowMin & (mapSize - 1)) / glm::vec2(mapSize);
+}
 
-        glActiveTexture(GL_TEXTURE0);
-        glBindTexture(GL_TEXTURE_2D, m_prevDisplacementTexture.Retrieve()->handle);
+void bee::DisplacementManager::Impl::AddTiles(glm::ivec2 tileMin, glm::ivec2 tileMax)
+{
+    for (int32_t y = tileMin.y; y <= tileMax.y; y++)
+    {
+        for (int32_t x = tileMin.x; x <= tileMax.x; x++)
+            m_dirtyTiles.push_back(TileKey(glm::ivec2(x, y)));
+    }
+}
+
+void bee::DisplacementManager::Impl::AddEnteringTiles(glm::ivec2 windowSize)
+{
+    const glm::ivec2 windowMax = m_windowMin + windowSize - 1;
+    const glm::ivec2 previousMax = m_previousWindowMin + windowSize - 1;
+
+    // Columns, then rows, that were not part of the previous window
+    for (int axis = 0; axis < 2; axis++)
+    {
+        if (m_windowMin[axis] == m_previousWindowMin[axis]) continue;
 
-        glBindImageTexture(1, m_displacementTexture.Retrieve()->handle, 0, GL_FALSE, 0, GL_WRITE_ONLY, GL_RGBA8);
-        glDispatchCompute(m_textureWidth / 16, m_textureHeight / 16, 1);
-        glMemoryBarrier(GL_SHADER_IMAGE_ACCESS_BARRIER_BIT);
+        glm::ivec2 texelMin = m_windowMin;
+        glm::ivec2 texelMax = windowMax;
+        if (m_windowMin[axis] > m_previousWindowMin[axis])
+            texelMin[axis] = previousMax[axis] + 1;
+        else
+            texelMax[axis] = m_previousWindowMin[axis] - 1;
 
-        displacerFocus.previousPosition = displacementFocusPos;
+        AddTiles(FloorDiv(texelMin, DISPLACEMENT_TILE_SIZE), FloorDiv(texelMax, DISPLACEMENT_TILE_SIZE));
     }
-    PopDebugGL();
 }
 
-glm::mat4 bee::DisplacementManager::DisplacementMapTransform() const
+template <typename T>
+void bee::DisplacementManager::Impl::Upload(GLuint buffer, size_t& capacity, const std::vector<T>& data)
 {
-    glm::mat4 matrix{ glm::identity<glm::mat4>() };
-    auto displacerFocusView{ Engine.ECS().Registry.view<DisplacerFocus, const Transform>() };
-    if (displacerFocusView.size_hint() > 0)
+    // Never empty, the buffer is bound even when there is nothing in it
+    if (data.size() > capacity || capacity == 0)
     {
-        entt::entity displacerFocusEntity = *displacerFocusView.begin();
-        auto [displacerFocus, focusTransform] { displacerFocusView.get(displacerFocusEntity) };
-        matrix = glm::translate(matrix, glm::vec3{ 0.5f });
-        matrix = glm::scale(matrix, 1.0f / glm::vec3{ displacerFocus.influenceSize });
-
-        matrix = glm::translate(matrix, -focusTransform.GetTranslation());
+        capacity = glm::max(glm::max(data.size(), capacity * 2), size_t(64));
+        glNamedBufferData(buffer, sizeof(T) * capacity, nullptr, GL_DYNAMIC_DRAW);
     }
 
-    return matrix;
+    if (!data.empty()) glNamedBufferSubData(buffer, 0, sizeof(T) * data.size(), data.data());
 }
 
 void bee::DisplacementManager::Impl::SetupTexture(ResourceHandle<bee::Image> handle , int32_t width, int32_t height)
 {
     glBindTexture(GL_TEXTURE_2D, handle.Retrieve()->handle);
 
-    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
-    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+    // The map wraps around the world, filtering across its edge reads the neighbouring world texels
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_REPEAT);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_REPEAT);
     glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
     glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
 
     glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA, width, height, 0, GL_RGBA, GL_UNSIGNED_BYTE, nullptr);
 }
-
-void bee::DisplacementManager::Impl::ClearTexture(ResourceHandle<bee::Image> handle, int32_t width, int32_t height, std::shared_ptr<bee::Shader> clearCompute)
-{
-    clearCompute->Activate();
-    clearCompute->GetParameter("clearColor")->SetValue(glm::vec4{ 0.5f, 0.5f, 0.5f, 1.0f });
-    glBindImageTexture(0, handle.Retrieve()->handle, 0, GL_FALSE, 0, GL_WRITE_ONLY, GL_RGBA8);
-    glDispatchCompute(width / 16, height / 16, 1);
-    glMemoryBarrier(GL_SHADER_IMAGE_ACCESS_BARRIER_BIT);
-}
@@ -0,0 +1,64 @@
+#include <precompiled/engine_precompiled.hpp>
+#include "grass/grass_culling.hpp"
+#include "grass/grass_visibility.hpp"
+
+#include "math/geometry.hpp"
+
+void bee::SetGrassCullFrustum(GrassCullParams& params, const std::array<Plane, 6>& frustum)
+{
+    for (size_t i = 0; i < frustum.size(); i++)
+    {
+        // GetSignedDistance is dot(point, normal) - w
+        params.frustumPlanes[i] = glm::vec4(frustum[i].GetNormal(), -frustum[i].GetSignedDistance(glm::vec3(0.0f)));
+    }
+}
+
+bool bee::GrassChunkInFrustum(const GrassCullParams& params, glm::vec3 boundsMin, glm::vec3 boundsMax)
+{
+    // Same test as BoundingBox::FrustumTest, the corner furthest along the normal has to be inside every plane
+    for (const auto& plane : params.frustumPlanes)
+    {
+        const glm::vec3 normal = glm::vec3(plane);
+        const glm::vec3 corner = glm::mix(boundsMin, boundsMax, glm::vec3(glm::greaterThan(normal, glm::vec3(0.0f))));
+        if (glm::dot(corner, normal) - plane.w < 0.0f)
+            return false;
+    }
+    return true;
+}
+
+uint32_t bee::GrassSelectLOD(const GrassCullParams& params, float distance)
+{
+    uint32_t lod = 0;
+    for (uint32_t i = 0; i < GRASS_LOD_COUNT; i++)
+    {
+        if (distance > params.lodDistances[i])
+            lod = i + 1;
+    }
+    return lod;
+}
+
+void bee::CullGrassChunks(const GrassCullParams& params, const GrassVisibility& visibility, std::vector<GrassDrawCommand>& commands,
+    std::vector<glm::uvec2>& draws)
+{
+    commands.clear();
+    draws.clear();
+
+    const uint32_t chunkCount = glm::min(params.chunkCount, visibility.ChunkCount());
+    for (uint32_t i = 0; i < chunkCount; i++)
+    {
+        if (!visibility.IsVisible(i))
+            continue;
+
+        const uint32_t lod = visibility.GetLOD(i);
+        const uint32_t geometry = glm::min(lod, GRASS_LOD_COUNT - 1);
+
+        GrassDrawCommand command{};
+        command.first = params.lodFirstVertex[geometry];
+        command.count = params.lodVertexCount[geometry];
+        command.instanceCount = params.lodInstanceCount[geometry];
+        command.baseInstance = params.lodBaseInstance[geometry];
+
+        commands.push_back(command);
+        draws.emplace_back(i, lod);
+    }
+}
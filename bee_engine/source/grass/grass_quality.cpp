@@ -0,0 +1,79 @@
+#include <precompiled/engine_precompiled.hpp>
+#include "grass/grass_quality.hpp"
+
+namespace
+{
+// Seconds between quality adjustments, gives the new settings time to show up in the GPU timings
+constexpr float GRASS_ADJUST_INTERVAL = 0.25f;
+// Frame time band around the target in which the quality is left alone
+constexpr float GRASS_OVER_BUDGET = 1.05f;
+constexpr float GRASS_UNDER_BUDGET = 0.85f;
+// Quality drops quickly when over budget and recovers slowly, to avoid oscillating around the target
+constexpr float GRASS_MAX_DECREASE = 0.1f;
+constexpr float GRASS_INCREASE = 0.02f;
+
+bool SameSettings(const bee::GrassQualitySettings& a, const bee::GrassQualitySettings& b)
+{
+    return a.lodDistances == b.lodDistances && a.lodDensities == b.lodDensities && a.drawDistance == b.drawDistance &&
+        a.adaptive == b.adaptive && a.targetFrameTime == b.targetFrameTime && a.minScale == b.minScale &&
+        a.maxScale == b.maxScale && a.minDensity == b.minDensity;
+}
+}
+
+bee::GrassQualityController::GrassQualityController()
+{
+    Apply();
+}
+
+void bee::GrassQualityController::SetSettings(const GrassQualitySettings& settings)
+{
+    GrassQualitySettings clamped = settings;
+    clamped.minScale = glm::clamp(clamped.minScale, 0.05f, 1.0f);
+    clamped.maxScale = glm::max(clamped.maxScale, clamped.minScale);
+    clamped.minDensity = glm::clamp(clamped.minDensity, 0.0f, 1.0f);
+
+    // Setting the same values again, like regenerating the grass does, keeps the adapted scale
+    if (SameSettings(clamped, m_settings)) return;
+    m_settings = clamped;
+
+    // Start at full quality, the controller lowers it once timings come in
+    m_scale = m_settings.adaptive ? m_settings.maxScale : 1.0f;
+    m_frameTime = 0.0f;
+    m_adjustTimer = 0.0f;
+    Apply();
+}
+
+void bee::GrassQualityController::Update(float gpuFrameTime, float dt)
+{
+    if (!m_settings.adaptive || gpuFrameTime <= 0.0f || m_settings.targetFrameTime <= 0.0f) return;
+
+    // Smoothed so a single slow frame does not change the grass
+    m_frameTime = m_frameTime == 0.0f ? gpuFrameTime : glm::mix(m_frameTime, gpuFrameTime, 0.1f);
+
+    m_adjustTimer += dt;
+    if (m_adjustTimer < GRASS_ADJUST_INTERVAL) return;
+    m_adjustTimer = 0.0f;
+
+    const float target = m_settings.targetFrameTime;
+    float scale = m_scale;
+    if (m_frameTime > target * GRASS_OVER_BUDGET)
+        scale -= glm::min(m_scale * (1.0f - target / m_frameTime), GRASS_MAX_DECREASE);
+    else if (m_frameTime < target * GRASS_UNDER_BUDGET)
+        scale += GRASS_INCREASE;
+
+    scale = glm::clamp(scale, m_settings.minScale, m_settings.maxScale);
+    if (scale == m_scale) return;
+
+    m_scale = scale;
+    Apply();
+}
+
+void bee::GrassQualityController::Apply()
+{
+    for (uint32_t i = 0; i < GRASS_LOD_COUNT; i++)
+    {
+        m_lodDistances[i] = glm::max(m_settings.lodDistances[i], 0.0f) * m_scale;
+        m_lodDensities[i] = glm::clamp(m_settings.lodDensities[i], 0.0f, 1.0f);
+        m_lodDensities[i] = glm::max(m_lodDensities[i] * glm::min(m_scale, 1.0f), glm::min(m_settings.minDensity, m_lodDensities[i]));
+    }
+}
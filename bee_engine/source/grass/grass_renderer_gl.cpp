@@ -1,10 +1,15 @@
 #include <precompiled/engine_precompiled.hpp>
 #include "grass/grass_renderer.hpp"
 
+#include <numeric>
+
 #include "core/engine.hpp"
 #include <platform/opengl/open_gl.hpp>
 #include "core/ecs.hpp"
 #include "grass/grass_chunk.hpp"
+#include "grass/grass_culling.hpp"
+#include "grass/grass_manager.hpp"
+#include "grass/grass_visibility.hpp"
 #include <core/transform.hpp>
 #include "rendering/render_components.hpp"
 #include "platform/opengl/shader_gl.hpp"
@@ -28,18 +33,43 @@ public:
 
     GLuint m_grassBladeVBO;
     GLuint m_grassBladeVAO;
-    std::array<std::pair<GLuint, GLuint>, 3> m_LODIndex;
-    std::array<GLuint, 3> m_SSBOs;
+    std::array<std::pair<GLuint, GLuint>, GRASS_LOD_COUNT> m_LODIndex;
+
+    // Blade data of all LODs in one buffer, every LOD starts at its base instance
+    GLuint m_bladeSSBO = 0;
+    std::array<uint32_t, GRASS_LOD_COUNT> m_LODBaseInstance{};
+    std::array<uint32_t, GRASS_LOD_COUNT> m_LODInstanceCount{};
+
+    // Chunk of every streaming slot, generated when a chunk enters the ring
+    std::vector<GrassChunkGPU> m_slotChunks;
+
+    // Resident chunk records read by the cull pass, gathered from the slots when the ring moves
+    GLuint m_chunksSSBO = 0;
+    std::vector<GrassChunkGPU> m_chunks;
+    ResourceHandle<Image> m_heightMapImage{ nullptr };
+
+    // Chunk visibility and LOD, kept in the order of m_chunks and uploaded every frame
+    GrassVisibility m_visibility;
+    GLuint m_visibilitySSBO = 0;
+
+    // Written by the cull pass: indirect commands, (chunk, LOD) per command and the number of commands
+    GLuint m_drawCommandsBuffer = 0;
+    GLuint m_drawsSSBO = 0;
+    GLuint m_drawCountSSBO = 0;
+    uint32_t m_drawCapacity = 0;
 
     Uniform<GrassChunkMaterial> m_materialBuffer;
+    Uniform<GrassCullParams> m_cullBuffer;
 
     void CreateGrassBladeGeom();
+    void UpdateChunks(glm::vec3 cameraPosition);
 };
 
 bee::GrassRenderer::GrassRenderer(const Material::IBL& ibl) : m_impl(std::make_unique<Impl>()), m_ibl(ibl)
 {
     m_grassPass = Engine.ShaderDB()[ShaderDB::Type::GRASS];
     m_grassCompute = Engine.ShaderDB()[ShaderDB::Type::GRASS_COMPUTE];
+    m_grassCull = Engine.ShaderDB()[ShaderDB::Type::GRASS_CULL];
     m_noiseImage = Engine.Resources().Images().FromFile(FileIO::Directory::Asset, "textures/noiseTexture.png", ImageFormat::RGBA8);
     m_windNoiseImage = Engine.Resources().Images().FromFile(FileIO::Directory::Asset, "textures/wind_noise.png", ImageFormat::RGBA8);
 
@@ -50,8 +80,6 @@ bee::GrassRenderer::GrassRenderer(const Material::IBL& ibl) : m_impl(std::make_u
 
     m_impl->CreateGrassBladeGeom();
 
-    bee::Engine.ECS().Registry.on_construct<GrassChunk>().connect<&GrassRenderer::OnGrassChunkCreate>(*this);
-
     struct
     {
         glm::vec4 position;
@@ -68,54 +96,120 @@ bee::GrassRenderer::GrassRenderer(const Material::IBL& ibl) : m_impl(std::make_u
     glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
     glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
 
-    for(size_t i = 0; i < m_impl->m_SSBOs.size(); ++i)
+    // Generate the blade data of every LOD into its own range of the blade buffer
+    GLint offsetAlignment = 0;
+    glGetIntegerv(GL_SHADER_STORAGE_BUFFER_OFFSET_ALIGNMENT, &offsetAlignment);
+    const uint32_t instanceAlignment = std::max(1u, static_cast<uint32_t>(offsetAlignment) / static_cast<uint32_t>(sizeof(instanceData)));
+
+    uint32_t totalInstances = 0;
+    for (size_t i = 0; i < GRASS_LOD_COUNT; ++i)
     {
         const uint32_t density = 16 >> i;
-        uint32_t grassCount = density * density * GRASS_PATCH * GRASS_PATCH;
+        m_impl->m_LODBaseInstance[i] = (totalInstances + instanceAlignment - 1) / instanceAlignment * instanceAlignment;
+        m_impl->m_LODInstanceCount[i] = density * density * GRASS_PATCH * GRASS_PATCH;
+        totalInstances = m_impl->m_LODBaseInstance[i] + m_impl->m_LODInstanceCount[i];
+    }
+
+    glCreateBuffers(1, &m_impl->m_bladeSSBO);
+    LabelGL(GL_BUFFER, m_impl->m_bladeSSBO, "[G] Grass Blades");
+    glNamedBufferData(m_impl->m_bladeSSBO, sizeof(instanceData) * totalInstances, nullptr, GL_STATIC_DRAW);
 
-        glGenBuffers(1, &m_impl->m_SSBOs[i]);
-        glBindBuffer(GL_SHADER_STORAGE_BUFFER, m_impl->m_SSBOs[i]);
-        glBindBufferBase(GL_SHADER_STORAGE_BUFFER, 0, m_impl->m_SSBOs[i]);
-        glBufferData(GL_SHADER_STORAGE_BUFFER, sizeof(instanceData) * grassCount, nullptr,
-                     GL_STATIC_DRAW);
+    for(size_t i = 0; i < GRASS_LOD_COUNT; ++i)
+    {
+        const uint32_t density = 16 >> i;
 
+        glBindBufferRange(GL_SHADER_STORAGE_BUFFER, GRASS_LOCATION, m_impl->m_bladeSSBO,
+                          sizeof(instanceData) * m_impl->m_LODBaseInstance[i], sizeof(instanceData) * m_impl->m_LODInstanceCount[i]);
 
         glBindImageTexture(NOISE_TEXTURE_UNIT, m_noiseImage.Retrieve()->handle, 0, GL_FALSE, 0, GL_READ_ONLY, GL_RGBA8);
 
         m_grassCompute->Activate();
         glDispatchCompute(density, density, 1);
-
-        glBindBufferBase(GL_SHADER_STORAGE_BUFFER, 0, 0);
-        glBindTexture(GL_TEXTURE_2D, 0);
     }
 
+    glBindBufferBase(GL_SHADER_STORAGE_BUFFER, GRASS_LOCATION, 0);
+    glBindTexture(GL_TEXTURE_2D, 0);
+
+    glCreateBuffers(1, &m_impl->m_chunksSSBO);
+    glCreateBuffers(1, &m_impl->m_visibilitySSBO);
+    glCreateBuffers(1, &m_impl->m_drawCommandsBuffer);
+    glCreateBuffers(1, &m_impl->m_drawsSSBO);
+    glCreateBuffers(1, &m_impl->m_drawCountSSBO);
+    LabelGL(GL_BUFFER, m_impl->m_chunksSSBO, "[G] Grass Chunks");
+    LabelGL(GL_BUFFER, m_impl->m_visibilitySSBO, "[G] Grass Visibility");
+    LabelGL(GL_BUFFER, m_impl->m_drawCommandsBuffer, "[G] Grass Draw Commands");
+    LabelGL(GL_BUFFER, m_impl->m_drawsSSBO, "[G] Grass Draws");
+    LabelGL(GL_BUFFER, m_impl->m_drawCountSSBO, "[G] Grass Draw Count");
+    glNamedBufferData(m_impl->m_drawCountSSBO, sizeof(uint32_t), nullptr, GL_DYNAMIC_DRAW);
+
+    m_impl->m_cullBuffer.SetName("[G] Grass Cull Params");
 }
 
 bee::GrassRenderer::~GrassRenderer()
 {
     glDeleteBuffers(1, &m_impl->m_grassBladeVBO);
     glDeleteVertexArrays(1, &m_impl->m_grassBladeVAO);
-    for(size_t i = 0; i < m_impl->m_SSBOs.size(); ++i)
-        glDeleteBuffers(1, &m_impl->m_SSBOs[i]);
-
-    bee::Engine.ECS().Registry.on_construct<GrassChunk>().disconnect<&GrassRenderer::OnGrassChunkCreate>(*this);
+    glDeleteBuffers(1, &m_impl->m_bladeSSBO);
+    glDeleteBuffers(1, &m_impl->m_chunksSSBO);
+    glDeleteBuffers(1, &m_impl->m_visibilitySSBO);
+    glDeleteBuffers(1, &m_impl->m_drawCommandsBuffer);
+    glDeleteBuffers(1, &m_impl->m_drawsSSBO);
+    glDeleteBuffers(1, &m_impl->m_drawCountSSBO);
 }
 
-void bee::GrassRenderer::OnGrassChunkCreate(entt::registry& registry, entt::entity entity)
+void bee::GrassRenderer::Render(const Camera& camera)
 {
-}
+    m_impl->UpdateChunks(camera.GetPosition());
 
-void bee::GrassRenderer::OnGrassChunkDestroy(entt::registry& registry, entt::entity entity)
-{ 
-}
+    const uint32_t chunkCount = static_cast<uint32_t>(m_impl->m_chunks.size());
+    if (chunkCount == 0) return;
 
-void bee::GrassRenderer::Render()
-{
     PushDebugGL("Grass pass");
 
-    // Create view of all chunks.
-    auto grassChunkView = bee::Engine.ECS().Registry.view<const GrassChunk, const bee::Transform>(entt::exclude<CulledGrass>);
+    // 1. Cull the chunk quadtree and select the LOD of the visible chunks, then append one indirect draw per visible chunk on the GPU
+    auto& params = *m_impl->m_cullBuffer.get();
+    SetGrassCullFrustum(params, camera.GetFrustum());
+    params.cameraPosition = glm::vec4(camera.GetPosition(), 1.0f);
 
+    // Blades are stored so that any prefix covers the whole chunk, lower densities draw fewer instances
+    const auto& quality = Engine.GetGrassManager().GetQuality();
+    for (uint32_t i = 0; i < GRASS_LOD_COUNT; ++i)
+    {
+        const float density = quality.GetLODDensities()[i];
+        params.lodDistances[i] = quality.GetLODDistances()[i];
+        params.lodFirstVertex[i] = m_impl->m_LODIndex[i].first;
+        params.lodVertexCount[i] = m_impl->m_LODIndex[i].second;
+        params.lodInstanceCount[i] = static_cast<uint32_t>(static_cast<float>(m_impl->m_LODInstanceCount[i]) * density);
+        params.lodBaseInstance[i] = m_impl->m_LODBaseInstance[i];
+    }
+    params.chunkCount = chunkCount;
+    m_impl->m_cullBuffer.Patch();
+
+    auto& visibility = m_impl->m_visibility;
+    visibility.Update(params);
+
+    const auto& visibilityBits = visibility.VisibilityBits();
+    const auto& lodBits = visibility.LODBits();
+    glNamedBufferSubData(m_impl->m_visibilitySSBO, 0, sizeof(uint32_t) * visibilityBits.size(), visibilityBits.data());
+    glNamedBufferSubData(m_impl->m_visibilitySSBO, sizeof(uint32_t) * visibilityBits.size(), sizeof(uint32_t) * lodBits.size(), lodBits.data());
+
+    // Commands past the visible count stay zeroed and draw nothing
+    const uint32_t zero = 0;
+    glClearNamedBufferData(m_impl->m_drawCommandsBuffer, GL_R32UI, GL_RED_INTEGER, GL_UNSIGNED_INT, &zero);
+    glClearNamedBufferData(m_impl->m_drawCountSSBO, GL_R32UI, GL_RED_INTEGER, GL_UNSIGNED_INT, &zero);
+
+    glBindBufferBase(GL_UNIFORM_BUFFER, GRASS_CULL_LOCATION, m_impl->m_cullBuffer.buffer);
+    glBindBufferBase(GL_SHADER_STORAGE_BUFFER, GRASS_CHUNKS_LOCATION, m_impl->m_chunksSSBO);
+    glBindBufferBase(GL_SHADER_STORAGE_BUFFER, GRASS_VISIBILITY_LOCATION, m_impl->m_visibilitySSBO);
+    glBindBufferBase(GL_SHADER_STORAGE_BUFFER, GRASS_DRAW_COMMANDS_LOCATION, m_impl->m_drawCommandsBuffer);
+    glBindBufferBase(GL_SHADER_STORAGE_BUFFER, GRASS_DRAWS_LOCATION, m_impl->m_drawsSSBO);
+    glBindBufferBase(GL_SHADER_STORAGE_BUFFER, GRASS_DRAW_COUNT_LOCATION, m_impl->m_drawCountSSBO);
+
+    m_grassCull->Activate();
+    glDispatchCompute((chunkCount + 63) / 64, 1, 1);
+    glMemoryBarrier(GL_COMMAND_BARRIER_BIT | GL_SHADER_STORAGE_BARRIER_BIT);
+
+    // 2. Draw all visible chunks at once
     m_grassPass->Activate();
 
     glDisable(GL_CULL_FACE);
@@ -158,81 +252,122 @@ void bee::GrassRenderer::Render()
 
     m_grassPass->GetParameter("u_terrainTransform")->SetValue(terrainTransformMatrix);
     m_grassPass->GetParameter("u_displacementTransform")->SetValue(displacementTransformMatrix);
+    m_grassPass->GetParameter("u_displacementOffset")->SetValue(Engine.DisplacementManager().DisplacementMapOffset());
     m_grassPass->GetParameter("u_heightModifier")->SetValue(terrainChunk.heightModifier);
     m_grassPass->GetParameter("u_tiling")->SetValue(glm::vec2{ std::max(terrainChunk.width, terrainChunk.height) * 0.5f });
     m_grassPass->GetParameter("u_dither_distance")->SetValue(Engine.Renderer().GetDitherDistance());
 
-    glBindVertexArray(m_impl->m_grassBladeVAO);
-
-    //Pick the first camera (TODO: add option to set a camera or a camera entity)
-    auto cameraView = Engine.ECS().Registry.view<Transform, CameraComponent>();
-
-    std::vector<std::tuple<const GrassChunk*, const Transform*>> chunks{};
-    for (auto grassChunkEntity : grassChunkView)
+    if (m_impl->m_heightMapImage.Valid())
     {
-        auto pair = grassChunkView[grassChunkEntity];
-        chunks.emplace_back(&std::get<0>(pair), &std::get<1>(pair));
+        glActiveTexture(GL_TEXTURE0 + HEIGHT_MAP_TEXTURE_UNIT);
+
+        glBindTexture(GL_TEXTURE_2D, m_impl->m_heightMapImage.Retrieve()->handle);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_BORDER);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_BORDER);
     }
-    auto cameraTransform = Engine.ECS().Registry.get<Transform>(cameraView.front());
 
-    // Sort based on distance to the camera
-    std::sort(chunks.begin(), chunks.end(), [cameraTransform](const std::tuple<const GrassChunk*, const Transform*>& a, const std::tuple<const GrassChunk*, const Transform*>& b)
-        {
-            glm::vec3 positionCamera = cameraTransform.GetTranslation();
-            float distanceA = glm::distance(positionCamera, std::get<1>(a)->GetTranslation());
-            float distanceB = glm::distance(positionCamera, std::get<1>(b)->GetTranslation());
-            return distanceA < distanceB;
-        });
+    glActiveTexture(GL_TEXTURE0 + SPECULAR_SAMPER_LOCATION);
+    glBindTexture(GL_TEXTURE_CUBE_MAP, m_ibl.specular->handle);
+    glUniform1i(SPECULAR_SAMPER_LOCATION, SPECULAR_SAMPER_LOCATION);
 
+    glBindBufferBase(GL_SHADER_STORAGE_BUFFER, GRASS_LOCATION, m_impl->m_bladeSSBO);
 
-    // Iterate view for rendering.
-    for (auto grassChunkEntity : chunks)
-    {
-        // Grab data from entity and draw to screen.
-        auto [chunk, transform] = grassChunkEntity;
+    glBindVertexArray(m_impl->m_grassBladeVAO);
+    glBindBuffer(GL_DRAW_INDIRECT_BUFFER, m_impl->m_drawCommandsBuffer);
+    glMultiDrawArraysIndirect(GL_TRIANGLE_STRIP, nullptr, static_cast<GLsizei>(chunkCount), 0);
 
-        glm::mat4 world = transform->World();
+    glBindBuffer(GL_DRAW_INDIRECT_BUFFER, 0);
+    glBindVertexArray(0);
+    glBindBufferBase(GL_SHADER_STORAGE_BUFFER, GRASS_LOCATION, 0);
 
-        if (chunk->heightMapImage.Valid())
-        {
-            glActiveTexture(GL_TEXTURE0 + HEIGHT_MAP_TEXTURE_UNIT);
+    glEnable(GL_CULL_FACE);
 
-            glBindTexture(GL_TEXTURE_2D, chunk->heightMapImage.Retrieve()->handle);
-            glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
-            glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
-            glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_BORDER);
-            glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_BORDER);
-        }
+    PopDebugGL();
+}
 
-        glActiveTexture(GL_TEXTURE0 + SPECULAR_SAMPER_LOCATION);
-        glBindTexture(GL_TEXTURE_CUBE_MAP, m_ibl.specular->handle);
-        glUniform1i(SPECULAR_SAMPER_LOCATION, SPECULAR_SAMPER_LOCATION);
+bool bee::GrassRenderer::CheckCulling()
+{
+    if (m_impl->m_chunks.empty())
+    {
+        Log::Warn("Grass cull check skipped, no grass chunks were rendered");
+        return false;
+    }
 
+    std::vector<GrassDrawCommand> expectedCommands;
+    std::vector<glm::uvec2> expectedDraws;
+    CullGrassChunks(*m_impl->m_cullBuffer.get(), m_impl->m_visibility, expectedCommands, expectedDraws);
 
-        uint32_t validIndex = std::clamp(chunk->lod, 0u, static_cast<uint32_t>(m_impl->m_LODIndex.size() - 1));
-        auto indexRange = m_impl->m_LODIndex.at(validIndex);
+    uint32_t drawCount = 0;
+    glGetNamedBufferSubData(m_impl->m_drawCountSSBO, 0, sizeof(drawCount), &drawCount);
+    if (drawCount != expectedDraws.size() || drawCount > m_impl->m_drawCapacity)
+    {
+        Log::Warn("Grass cull mismatch: the GPU appended {} draws, the CPU reference {}", drawCount, expectedDraws.size());
+        return false;
+    }
 
-        glBindBuffer(GL_SHADER_STORAGE_BUFFER, m_impl->m_SSBOs[validIndex]);
-        glBindBufferBase(GL_SHADER_STORAGE_BUFFER, 0, m_impl->m_SSBOs[validIndex]);
+    std::vector<GrassDrawCommand> commands(drawCount);
+    std::vector<glm::uvec2> draws(drawCount);
+    glGetNamedBufferSubData(m_impl->m_drawCommandsBuffer, 0, sizeof(GrassDrawCommand) * drawCount, commands.data());
+    glGetNamedBufferSubData(m_impl->m_drawsSSBO, 0, sizeof(glm::uvec2) * drawCount, draws.data());
 
+    // The GPU appends in any order, the reference in chunk order
+    std::vector<uint32_t> order(drawCount);
+    std::iota(order.begin(), order.end(), 0);
+    std::sort(order.begin(), order.end(), [&draws](uint32_t a, uint32_t b) { return draws[a].x < draws[b].x; });
 
-        m_grassPass->GetParameter("u_world")->SetValue(world);
-        m_grassPass->GetParameter("u_lodLevel")->SetValue(chunk->lod);
+    for (uint32_t i = 0; i < drawCount; i++)
+    {
+        const uint32_t slot = order[i];
+        if (draws[slot] != expectedDraws[i] || std::memcmp(&commands[slot], &expectedCommands[i], sizeof(GrassDrawCommand)) != 0)
+        {
+            Log::Warn("Grass cull mismatch at chunk {}: the GPU drew LOD {}, the CPU reference chunk {} LOD {}", draws[slot].x,
+                draws[slot].y, expectedDraws[i].x, expectedDraws[i].y);
+            return false;
+        }
+    }
+
+    Log::Info("Grass cull matches the CPU reference, {} of {} chunks drawn", drawCount, m_impl->m_chunks.size());
+    return true;
+}
 
+void bee::GrassRenderer::Impl::UpdateChunks(glm::vec3 cameraPosition)
+{
+    auto& streaming = Engine.GetGrassManager().GetStreaming();
+    if (!streaming.Update(cameraPosition)) return;
 
-        const uint32_t density = 16 >> validIndex;
-        uint32_t grassCount = density * density * GRASS_PATCH * GRASS_PATCH;
+    const auto& slots = streaming.Slots();
+    m_slotChunks.resize(slots.size());
+    for (const uint32_t slot : streaming.GeneratedSlots())
+        m_slotChunks[slot] = streaming.GenerateChunk(slot);
 
-        uint32_t instanceCount = grassCount;
-        glDrawArraysInstanced(GL_TRIANGLE_STRIP, indexRange.first, indexRange.second, instanceCount);
+    m_chunks.clear();
+    for (uint32_t i = 0; i < slots.size(); i++)
+    {
+        if (slots[i].resident)
+            m_chunks.push_back(m_slotChunks[i]);
     }
 
-    glBindVertexArray(0);
-    glBindBufferBase(GL_SHADER_STORAGE_BUFFER, 0, 0);
+    // All chunks of a level share the terrain heightmap
+    m_heightMapImage = streaming.GetArea().heightMap;
 
-    glEnable(GL_CULL_FACE);
+    // Reorders the chunks so every quadtree node covers a contiguous range
+    m_visibility.Build(m_chunks);
 
-    PopDebugGL();
+    // Sized for a full ring, so the buffers are only reallocated when the draw distance grows
+    const uint32_t capacity = static_cast<uint32_t>(slots.size());
+    if (capacity > m_drawCapacity)
+    {
+        m_drawCapacity = capacity;
+        glNamedBufferData(m_chunksSSBO, sizeof(GrassChunkGPU) * m_drawCapacity, nullptr, GL_DYNAMIC_DRAW);
+        glNamedBufferData(m_visibilitySSBO, sizeof(uint32_t) * ((m_drawCapacity + 31) / 32 + (m_drawCapacity + 15) / 16), nullptr, GL_DYNAMIC_DRAW);
+        glNamedBufferData(m_drawCommandsBuffer, sizeof(GrassDrawCommand) * m_drawCapacity, nullptr, GL_DYNAMIC_DRAW);
+        glNamedBufferData(m_drawsSSBO, sizeof(glm::uvec2) * m_drawCapacity, nullptr, GL_DYNAMIC_DRAW);
+    }
+
+    if (!m_chunks.empty())
+        glNamedBufferSubData(m_chunksSSBO, 0, sizeof(GrassChunkGPU) * m_chunks.size(), m_chunks.data());
 }
 
 void bee::GrassRenderer::UpdateMaterial(GrassChunkMaterial material)
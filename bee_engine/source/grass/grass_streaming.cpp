@@ -0,0 +1,93 @@
+#include <precompiled/engine_precompiled.hpp>
+#include "grass/grass_streaming.hpp"
+
+#include <glm/gtc/matrix_transform.hpp>
+
+void bee::GrassStreaming::SetArea(const GrassStreamingArea& area)
+{
+    m_area = area;
+    m_area.chunkSize = glm::max(m_area.chunkSize, 1.0f);
+    Resize();
+}
+
+void bee::GrassStreaming::ClearArea()
+{
+    m_area = GrassStreamingArea{};
+    Resize();
+}
+
+void bee::GrassStreaming::SetDrawDistance(float distance)
+{
+    m_drawDistance = glm::max(distance, 0.0f);
+    Resize();
+}
+
+void bee::GrassStreaming::Resize()
+{
+    // Enough chunks on either side of the camera chunk to cover the draw distance
+    const int radius = static_cast<int>(glm::ceil(m_drawDistance / m_area.chunkSize));
+    m_ringSize = 2 * radius + 1;
+
+    m_slots.assign(static_cast<size_t>(m_ringSize * m_ringSize), Slot{});
+    m_generatedSlots.clear();
+    m_generatedSlots.reserve(m_slots.size());
+    m_residentCount = 0;
+    m_dirty = true;
+}
+
+bool bee::GrassStreaming::Update(glm::vec3 cameraPosition)
+{
+    m_generatedSlots.clear();
+
+    const glm::ivec2 center = glm::ivec2(glm::floor((glm::vec2(cameraPosition) - m_area.origin) / m_area.chunkSize));
+    if (!m_dirty && center == m_center) return false;
+
+    // A resized ring has to be picked up even when no chunk became resident
+    bool changed = m_dirty;
+    m_dirty = false;
+    m_center = center;
+
+    const int radius = m_ringSize / 2;
+    for (int y = center.y - radius; y <= center.y + radius; y++)
+    {
+        for (int x = center.x - radius; x <= center.x + radius; x++)
+        {
+            const int slotX = ((x % m_ringSize) + m_ringSize) % m_ringSize;
+            const int slotY = ((y % m_ringSize) + m_ringSize) % m_ringSize;
+            const uint32_t index = static_cast<uint32_t>(slotY * m_ringSize + slotX);
+            Slot& slot = m_slots[index];
+
+            const glm::ivec2 coordinate(x, y);
+            const bool resident = x >= 0 && y >= 0 && x < m_area.chunkCount.x && y < m_area.chunkCount.y;
+            if (slot.resident == resident && (!resident || slot.coordinate == coordinate)) continue;
+
+            if (slot.resident) m_residentCount--;
+            if (resident)
+            {
+                m_residentCount++;
+                m_generatedSlots.push_back(index);
+            }
+
+            slot.coordinate = coordinate;
+            slot.resident = resident;
+            changed = true;
+        }
+    }
+
+    return changed;
+}
+
+bee::GrassChunkGPU bee::GrassStreaming::GenerateChunk(uint32_t slot) const
+{
+    const Slot& source = m_slots[slot];
+    const glm::vec2 center = m_area.origin + (glm::vec2(source.coordinate) + 0.5f) * m_area.chunkSize;
+
+    // Same bounds GrassManager used to give chunk entities, the blades can reach above the terrain
+    const glm::vec3 extents = glm::vec3(m_area.chunkSize * 0.5f, m_area.chunkSize * 0.5f, glm::max(m_area.terrainHeight * 1.5f, 1.0f));
+
+    GrassChunkGPU chunk{};
+    chunk.world = glm::translate(glm::mat4(1.0f), glm::vec3(center, 0.0f));
+    chunk.boundsMin = glm::vec4(glm::vec3(center, 0.0f) - extents, 1.0f);
+    chunk.boundsMax = glm::vec4(glm::vec3(center, 0.0f) + extents, 1.0f);
+    return chunk;
+}
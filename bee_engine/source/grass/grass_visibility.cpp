@@ -0,0 +1,190 @@
+#include <precompiled/engine_precompiled.hpp>
+#include "grass/grass_visibility.hpp"
+
+#include <algorithm>
+
+namespace
+{
+// Nodes with this many chunks or less are not split further
+constexpr uint32_t GRASS_LEAF_SIZE = 16;
+}
+
+void bee::GrassVisibility::Build(std::vector<GrassChunkGPU>& chunks)
+{
+    const uint32_t count = static_cast<uint32_t>(chunks.size());
+
+    m_nodes.clear();
+    m_visibleRanges.clear();
+    m_visibilityBits.assign((count + 31) / 32, 0u);
+    m_lodBits.assign((count + 15) / 16, 0u);
+    m_visitedNodes = 0;
+    m_visibleChunks = 0;
+
+    if (count > 0)
+    {
+        m_nodes.emplace_back();
+        BuildNode(chunks, 0, 0, count);
+    }
+
+    m_chunkCenters.resize(count);
+    m_chunkBoundsMin.resize(count);
+    m_chunkBoundsMax.resize(count);
+    for (uint32_t i = 0; i < count; i++)
+    {
+        m_chunkCenters[i] = glm::vec3(chunks[i].world[3]);
+        m_chunkBoundsMin[i] = glm::vec3(chunks[i].boundsMin);
+        m_chunkBoundsMax[i] = glm::vec3(chunks[i].boundsMax);
+    }
+}
+
+void bee::GrassVisibility::BuildNode(std::vector<GrassChunkGPU>& chunks, uint32_t index, uint32_t first, uint32_t count)
+{
+    glm::vec3 boundsMin(std::numeric_limits<float>::max());
+    glm::vec3 boundsMax(std::numeric_limits<float>::lowest());
+    for (uint32_t i = first; i < first + count; i++)
+    {
+        // The chunk origin is included so it can be used to bound the LOD distance of the node
+        const glm::vec3 origin = glm::vec3(chunks[i].world[3]);
+        boundsMin = glm::min(boundsMin, glm::min(glm::vec3(chunks[i].boundsMin), origin));
+        boundsMax = glm::max(boundsMax, glm::max(glm::vec3(chunks[i].boundsMax), origin));
+    }
+
+    m_nodes[index].boundsMin = boundsMin;
+    m_nodes[index].boundsMax = boundsMax;
+    m_nodes[index].firstChunk = first;
+    m_nodes[index].chunkCount = count;
+
+    if (count <= GRASS_LEAF_SIZE) return;
+
+    // Split at the median along X, then each half at the median along Y
+    const auto begin = chunks.begin() + first;
+    const auto byAxis = [](int axis)
+    {
+        return [axis](const GrassChunkGPU& a, const GrassChunkGPU& b) { return a.world[3][axis] < b.world[3][axis]; };
+    };
+
+    const uint32_t half = count / 2;
+    std::nth_element(begin, begin + half, begin + count, byAxis(0));
+    std::nth_element(begin, begin + half / 2, begin + half, byAxis(1));
+    std::nth_element(begin + half, begin + half + (count - half) / 2, begin + count, byAxis(1));
+
+    const std::array<uint32_t, 5> splits = { first, first + half / 2, first + half, first + half + (count - half) / 2, first + count };
+
+    // The children are stored next to each other, m_nodes grows while they are built
+    const uint32_t firstChild = static_cast<uint32_t>(m_nodes.size());
+    m_nodes[index].firstChild = firstChild;
+    m_nodes.resize(m_nodes.size() + 4);
+
+    for (uint32_t i = 0; i < 4; i++)
+        BuildNode(chunks, firstChild + i, splits[i], splits[i + 1] - splits[i]);
+}
+
+void bee::GrassVisibility::Update(const GrassCullParams& params)
+{
+    // Only the ranges made visible by the last update have to be cleared
+    for (const auto& range : m_visibleRanges)
+        SetVisible(range.x, range.y, false);
+
+    m_visibleRanges.clear();
+    m_visitedNodes = 0;
+    m_visibleChunks = 0;
+
+    if (m_nodes.empty()) return;
+
+    const glm::vec3 cameraPosition = glm::vec3(params.cameraPosition);
+
+    const auto addRange = [this](uint32_t first, uint32_t count)
+    {
+        SetVisible(first, count, true);
+        m_visibleChunks += count;
+
+        if (!m_visibleRanges.empty() && m_visibleRanges.back().x + m_visibleRanges.back().y == first)
+            m_visibleRanges.back().y += count;
+        else
+            m_visibleRanges.emplace_back(first, count);
+    };
+
+    m_stack.clear();
+    m_stack.push_back(0);
+    while (!m_stack.empty())
+    {
+        const Node& node = m_nodes[m_stack.back()];
+        m_stack.pop_back();
+
+        if (node.chunkCount == 0) continue;
+        m_visitedNodes++;
+
+        bool outside = false;
+        bool inside = true;
+        for (const auto& plane : params.frustumPlanes)
+        {
+            const glm::vec3 normal = glm::vec3(plane);
+            const glm::bvec3 positive = glm::greaterThan(normal, glm::vec3(0.0f));
+            const glm::vec3 furthest = glm::mix(node.boundsMin, node.boundsMax, glm::vec3(positive));
+            const glm::vec3 nearest = glm::mix(node.boundsMax, node.boundsMin, glm::vec3(positive));
+
+            if (glm::dot(furthest, normal) - plane.w < 0.0f)
+            {
+                outside = true;
+                break;
+            }
+            if (glm::dot(nearest, normal) - plane.w < 0.0f)
+                inside = false;
+        }
+
+        if (outside) continue;
+
+        if (!inside && node.firstChild != 0)
+        {
+            for (uint32_t i = 0; i < 4; i++)
+                m_stack.push_back(node.firstChild + i);
+            continue;
+        }
+
+        // When the whole node falls within one LOD band its chunks need no distance check
+        const glm::vec3 nearestOffset = glm::max(glm::max(node.boundsMin - cameraPosition, cameraPosition - node.boundsMax), glm::vec3(0.0f));
+        const glm::vec3 furthestOffset = glm::max(glm::abs(node.boundsMin - cameraPosition), glm::abs(node.boundsMax - cameraPosition));
+        const uint32_t nearLOD = GrassSelectLOD(params, glm::length(nearestOffset));
+        const uint32_t farLOD = GrassSelectLOD(params, glm::length(furthestOffset));
+
+        const uint32_t end = node.firstChunk + node.chunkCount;
+        for (uint32_t chunk = node.firstChunk; chunk < end; chunk++)
+        {
+            // Leaves crossing the frustum are tested chunk by chunk
+            if (!inside)
+            {
+                if (!GrassChunkInFrustum(params, m_chunkBoundsMin[chunk], m_chunkBoundsMax[chunk])) continue;
+                addRange(chunk, 1);
+            }
+
+            SetLOD(chunk, nearLOD == farLOD ? nearLOD : GrassSelectLOD(params, glm::distance(cameraPosition, m_chunkCenters[chunk])));
+        }
+
+        if (inside) addRange(node.firstChunk, node.chunkCount);
+    }
+}
+
+void bee::GrassVisibility::SetVisible(uint32_t first, uint32_t count, bool visible)
+{
+    const uint32_t end = first + count;
+    for (uint32_t chunk = first; chunk < end;)
+    {
+        const uint32_t bit = chunk % 32;
+        const uint32_t bits = glm::min(32 - bit, end - chunk);
+        const uint32_t mask = (bits == 32 ? ~0u : (1u << bits) - 1u) << bit;
+
+        if (visible)
+            m_visibilityBits[chunk / 32] |= mask;
+        else
+            m_visibilityBits[chunk / 32] &= ~mask;
+
+        chunk += bits;
+    }
+}
+
+void bee::GrassVisibility::SetLOD(uint32_t chunk, uint32_t lod)
+{
+    const uint32_t shift = (chunk % 16) * 2;
+    uint32_t& word = m_lodBits[chunk / 16];
+    word = (word & ~(3u << shift)) | (glm::min(lod, 3u) << shift);
+}
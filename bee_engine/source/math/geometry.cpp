@@ -236,105 +236,3 @@ std::array<bee::Plane, 6> bee::Camera::GetFrustum() const
 
     return { nearPlane, farPlane, rightPlane, leftPlane, topPlane, bottomPlane };
 }
-
-std::vector<glm::vec4> bee::GetCascadeCornersWorldSpace(const glm::mat4& projview)
-{
-    const auto inv = glm::inverse(projview);
-
-    std::vector<glm::vec4> frustumCorners;
-    for (uint32_t x = 0; x < 2; ++x)
-    {
-        for (uint32_t y = 0; y < 2; ++y)
-        {
-            for (uint32_t z = 0; z < 2; ++z)
-            {
-                const glm::vec4 pt =
-                    inv * glm::vec4(
-                        2.0f * x - 1.0f,
-                        2.0f * y - 1.0f,
-                        2.0f * z - 1.0f,
-                        1.0f);
-                frustumCorners.push_back(pt / pt.w);
-            }
-        }
-    }
-
-    return frustumCorners;
-}
-
-glm::mat4 bee::GetLightSpaceMatrix(const float nearPlane, const float farPlane, glm::vec3 lightDir, const bee::Camera& camera)
-{
-    const auto proj = glm::perspective(camera.GetFOV(), camera.GetAspectRatio(), nearPlane, farPlane);
-    const auto view = camera.GetView();
-    const auto corners = GetCascadeCornersWorldSpace(proj * view);
-
-    glm::vec3 center = glm::vec3(0, 0, 0);
-    for (const auto& v : corners)
-    {
-        center += glm::vec3(v);
-    }
-    center /= corners.size();
-
-    const auto lightView = glm::lookAt(center + lightDir, center, bee::World::FORWARD);
-
-    float minX = std::numeric_limits<float>::max();
-    float maxX = std::numeric_limits<float>::lowest();
-    float minY = std::numeric_limits<float>::max();
-    float maxY = std::numeric_limits<float>::lowest();
-    float minZ = std::numeric_limits<float>::max();
-    float maxZ = std::numeric_limits<float>::lowest();
-    for (const auto& v : corners)
-    {
-        const auto trf = lightView * v;
-        minX = std::min(minX, trf.x);
-        maxX = std::max(maxX, trf.x);
-        minY = std::min(minY, trf.y);
-        maxY = std::max(maxY, trf.y);
-        minZ = std::min(minZ, trf.z);
-        maxZ = std::max(maxZ, trf.z);
-    }
-
-    // Tune this parameter according to the scene
-    constexpr float zMult = 10.0f;
-    if (minZ < 0)
-    {
-        minZ *= zMult;
-    }
-    else
-    {
-        minZ /= zMult;
-    }
-    if (maxZ < 0)
-    {
-        maxZ /= zMult;
-    }
-    else
-    {
-        maxZ *= zMult;
-    }
-
-    const glm::mat4 lightProjection = glm::ortho(minX, maxX, minY, maxY, minZ, maxZ);
-    return lightProjection * lightView;
-}
-
-std::vector<glm::mat4> bee::GetLightSpaceMatrices(const bee::Camera& camera, glm::vec3 lightDir, std::vector<float> cascadeLevels)
-{
-    std::vector<glm::mat4> ret;
-    for (size_t i = 0; i < cascadeLevels.size() + 1; ++i)
-    {
-        if (i == 0)
-        {
-            ret.push_back(bee::GetLightSpaceMatrix(camera.GetNearPlane(), cascadeLevels[i], lightDir, camera));
-        }
-        else if (i < cascadeLevels.size())
-        {
-            ret.push_back(bee::GetLightSpaceMatrix(cascadeLevels[i - 1], cascadeLevels[i], lightDir, camera));
-        }
-        else
-        {
-            ret.push_back(bee::GetLightSpaceMatrix(cascadeLevels[i - 1], camera.GetFarPlane(), lightDir, camera));
-        }
-    }
-    return ret;
-}
-
@@ -0,0 +1,75 @@
+#include <precompiled/engine_precompiled.hpp>
+#include "physics/character.hpp"
+
+#include "core/engine.hpp"
+#include "core/ecs.hpp"
+#include "core/transform.hpp"
+#include "math/geometry.hpp"
+#include "physics/helpers.hpp"
+#include "physics/layers.hpp"
+#include "physics/physics_system.hpp"
+#include "physics/rigidbody.hpp"
+
+#include <jolt/Physics/Collision/BroadPhase/BroadPhaseLayer.h>
+#include <jolt/Physics/Collision/ObjectLayer.h>
+#include <jolt/Physics/Collision/Shape/SphereShape.h>
+
+void bee::AddSphereCharacter(entt::registry& registry, entt::entity entity, float radius)
+{
+    const Transform* transform = registry.try_get<Transform>(entity);
+    if (transform == nullptr) return;
+
+    JPH::Ref<JPH::CharacterVirtualSettings> settings = new JPH::CharacterVirtualSettings();
+    settings->mShape = new JPH::SphereShape(radius);
+    settings->mUp = GlmToJolt(World::UP);
+
+    // It flies, nothing it touches is ground and no slope is too steep. Every contact lies in front of this plane, so
+    // none supports it, and Jolt skips the steep slope constraints for a max slope angle of zero.
+    settings->mSupportingVolume = JPH::Plane(settings->mUp, 1.0e10f);
+    settings->mMaxSlopeAngle = 0.0f;
+
+    auto& component = registry.emplace_or_replace<CharacterComponent>(entity);
+    component.character = new JPH::CharacterVirtual(settings, GlmToJolt(transform->GetTranslation()), JPH::Quat::sIdentity(),
+        static_cast<JPH::uint64>(entity), &Engine.PhysicsSystem());
+}
+
+void bee::UpdateCharacter(CharacterComponent& character, RigidBody& rigidBody, Transform& transform, float dt)
+{
+    if (character.character == nullptr) return;
+
+    rigidBody.velocity += rigidBody.acceleration * dt;
+    rigidBody.velocity *= 1.0f - glm::min(rigidBody.damping * dt, 1.0f);
+    rigidBody.acceleration = glm::vec3{ 0.0f };
+
+    // Starting from the Transform picks up teleports
+    JPH::CharacterVirtual& virtualCharacter = *character.character;
+    virtualCharacter.SetPosition(GlmToJolt(transform.GetTranslation()));
+    virtualCharacter.SetLinearVelocity(GlmToJolt(rigidBody.velocity));
+
+    // It flies, so there is no gravity, no floor to stick to and no stairs to walk
+    JPH::CharacterVirtual::ExtendedUpdateSettings settings;
+    settings.mStickToFloorStepDown = JPH::Vec3::sZero();
+    settings.mWalkStairsStepUp = JPH::Vec3::sZero();
+
+    // Only the static world blocks it, sensors and moving bodies such as its own sensor target do not
+    JPH::SpecifiedBroadPhaseLayerFilter broadPhaseFilter(BroadPhaseLayers::NON_MOVING);
+    JPH::SpecifiedObjectLayerFilter objectFilter(Layers::NON_MOVING);
+
+    virtualCharacter.ExtendedUpdate(dt, JPH::Vec3::sZero(), settings, broadPhaseFilter, objectFilter, JPH::BodyFilter(), JPH::ShapeFilter(),
+        Engine.GetPhysics().GetTempAllocator());
+
+    // The character slid along what it hit, but Jolt does not slide its velocity with it. Without taking out the
+    // part into the contacts the rigid body keeps accelerating into the wall and the next step pushes against it.
+    JPH::Vec3 velocity = virtualCharacter.GetLinearVelocity();
+    for (const JPH::CharacterVirtual::Contact& contact : virtualCharacter.GetActiveContacts())
+    {
+        if (!contact.mHadCollision || contact.mIsSensorB) continue;
+
+        // The normal points towards the character
+        const float into = velocity.Dot(contact.mContactNormal);
+        if (into < 0.0f) velocity -= into * contact.mContactNormal;
+    }
+
+    rigidBody.velocity = JoltToGlm(velocity);
+    transform.SetTranslation(JoltToGlm(virtualCharacter.GetPosition()));
+}
@@ -0,0 +1,173 @@
+#include <precompiled/engine_precompiled.hpp>
+#include "physics/cooked_colliders.hpp"
+
+#include "core/engine.hpp"
+#include "physics/shape_cache.hpp"
+#include "tools/log.hpp"
+#include "tools/tools.hpp"
+
+#include <jolt/Core/StreamWrapper.h>
+#include <jolt/Physics/Collision/Shape/MeshShape.h>
+
+namespace
+{
+constexpr uint32_t COOKED_COLLIDERS_MAGIC = 0x4C4F4342;  // "BCOL"
+// Bump when the way shapes are built changes, so old cooked files are rebuilt
+constexpr uint32_t COOKED_COLLIDERS_VERSION = 1;
+
+// The binary state of shapes is only valid for the Jolt version and feature set that saved it
+using JPH::uint64;
+constexpr uint64_t JOLT_VERSION_ID = JPH_VERSION_ID;
+
+// File layout: header, then per shape a ShapeEntry followed by its SaveWithChildren stream
+struct CookedHeader
+{
+    uint32_t magic = COOKED_COLLIDERS_MAGIC;
+    uint32_t version = COOKED_COLLIDERS_VERSION;
+    uint64_t joltVersion = JOLT_VERSION_ID;
+    uint32_t shapeCount = 0;
+    uint32_t padding = 0;
+};
+
+struct ShapeEntry
+{
+    uint64_t hash = 0;
+    uint64_t size = 0;
+};
+}
+
+bee::CookedColliders::CookedColliders(FileIO::Directory directory, const std::string& modelPath)
+{
+    // Asset directories can be read only, cooked files are written to the save directory under a name derived from the model
+    const uint64_t pathHash = HashBytes(modelPath.data(), modelPath.size(), HashBytes(&directory, sizeof(directory)));
+    m_path = fmt::format("colliders_{:016x}.bin", pathHash);
+
+    if (Read(directory, modelPath + ".colliders")) return;
+    Read(FileIO::Directory::Save, m_path);
+}
+
+bool bee::CookedColliders::Read(FileIO::Directory directory, const std::string& path)
+{
+    auto& fileIO = Engine.FileIO();
+    if (!fileIO.Exists(directory, path)) return false;
+
+    std::vector<char> file = fileIO.ReadBinaryFile(directory, path);
+
+    CookedHeader header{};
+    if (file.size() < sizeof(header)) return false;
+    std::memcpy(&header, file.data(), sizeof(header));
+
+    const CookedHeader expected{};
+    if (header.magic != expected.magic || header.version != expected.version || header.joltVersion != expected.joltVersion)
+    {
+        Log::Info("Cooked colliders {} are outdated, rebuilding them", path);
+        return false;
+    }
+
+    m_file = std::move(file);
+    m_cooked.clear();
+
+    size_t offset = sizeof(header);
+    for (uint32_t i = 0; i < header.shapeCount; i++)
+    {
+        ShapeEntry entry{};
+        if (offset + sizeof(entry) > m_file.size()) break;
+        std::memcpy(&entry, m_file.data() + offset, sizeof(entry));
+        offset += sizeof(entry);
+
+        if (offset + entry.size > m_file.size()) break;
+        m_cooked[entry.hash] = { offset, static_cast<size_t>(entry.size) };
+        offset += entry.size;
+    }
+
+    return true;
+}
+
+JPH::Shape::ShapeResult bee::CookedColliders::GetMeshShape(const JPH::TriangleList& triangles)
+{
+    const uint64_t hash = HashBytes(triangles.data(), sizeof(JPH::Triangle) * triangles.size());
+    m_used.push_back(hash);
+
+    // Models with the same triangles share their shape, and snapshots of static bodies find it by the hash
+    ShapeCache& shapeCache = Engine.PhysicsShapeCache();
+    if (JPH::Ref<JPH::Shape> shared = shapeCache.FindByContentHash(hash))
+    {
+        JPH::Shape::ShapeResult result;
+        result.Set(shared);
+        return result;
+    }
+
+    auto cooked = m_cooked.find(hash);
+    if (cooked != m_cooked.end())
+    {
+        std::istringstream stream(std::string(m_file.data() + cooked->second.offset, cooked->second.size), std::ios::binary);
+        JPH::StreamInWrapper streamIn(stream);
+
+        JPH::Shape::IDToShapeMap shapeMap;
+        JPH::Shape::IDToMaterialMap materialMap;
+        JPH::Shape::ShapeResult result = JPH::Shape::sRestoreWithChildren(streamIn, shapeMap, materialMap);
+        if (result.IsValid() && !streamIn.IsFailed())
+        {
+            result.Set(shapeCache.AddContentShape(hash, result.Get()));
+            return result;
+        }
+
+        Log::Warn("Could not restore a cooked collider, rebuilding it into {}", m_path);
+    }
+
+    JPH::MeshShapeSettings shapeSettings(triangles);
+    shapeSettings.SetEmbedded();
+    JPH::Shape::ShapeResult result = shapeSettings.Create();
+    if (!result.IsValid()) return result;
+
+    std::ostringstream stream(std::ios::binary);
+    JPH::StreamOutWrapper streamOut(stream);
+    JPH::Shape::ShapeToIDMap shapeMap;
+    JPH::Shape::MaterialToIDMap materialMap;
+    result.Get()->SaveWithChildren(streamOut, shapeMap, materialMap);
+    m_built[hash] = stream.str();
+
+    result.Set(shapeCache.AddContentShape(hash, result.Get()));
+    return result;
+}
+
+void bee::CookedColliders::Save()
+{
+    if (m_built.empty()) return;
+
+    // Only the shapes the model still uses are kept, sorted by their hash
+    std::sort(m_used.begin(), m_used.end());
+    m_used.erase(std::unique(m_used.begin(), m_used.end()), m_used.end());
+
+    std::vector<char> file(sizeof(CookedHeader));
+    CookedHeader header{};
+    for (uint64_t hash : m_used)
+    {
+        const char* data = nullptr;
+        size_t size = 0;
+        if (auto built = m_built.find(hash); built != m_built.end())
+        {
+            data = built->second.data();
+            size = built->second.size();
+        }
+        else if (auto cooked = m_cooked.find(hash); cooked != m_cooked.end())
+        {
+            data = m_file.data() + cooked->second.offset;
+            size = cooked->second.size;
+        }
+        else
+        {
+            continue;
+        }
+
+        const ShapeEntry entry{ hash, size };
+        const char* entryBytes = reinterpret_cast<const char*>(&entry);
+        file.insert(file.end(), entryBytes, entryBytes + sizeof(entry));
+        file.insert(file.end(), data, data + size);
+        header.shapeCount++;
+    }
+
+    std::memcpy(file.data(), &header, sizeof(header));
+    if (Engine.FileIO().WriteBinaryFile(FileIO::Directory::Save, m_path, file))
+        Log::Info("Cooked {} colliders into {}", header.shapeCount, m_path);
+}
@@ -0,0 +1,59 @@
+#include <precompiled/engine_precompiled.hpp>
+#include "physics/job_system.hpp"
+
+#include "tools/thread_pool.hpp"
+
+bee::PhysicsJobSystem::PhysicsJobSystem(ThreadPool& threadPool, JPH::uint maxJobs, JPH::uint maxBarriers)
+    : JobSystemWithBarrier(maxBarriers), m_threadPool(threadPool)
+{
+    m_jobs.Init(maxJobs, maxJobs);
+}
+
+int bee::PhysicsJobSystem::GetMaxConcurrency() const
+{
+    // The pool workers plus the thread waiting for the update
+    return static_cast<int>(m_threadPool.NumberOfThreads()) + 1;
+}
+
+JPH::JobHandle bee::PhysicsJobSystem::CreateJob(const char* inName, JPH::ColorArg inColor, const JobFunction& inJobFunction, JPH::uint32 inNumDependencies)
+{
+    // Jolt frees jobs as soon as they finish, running out means more jobs are in flight than a single update creates
+    JPH::uint32 index = m_jobs.ConstructObject(inName, inColor, this, inJobFunction, inNumDependencies);
+    while (index == JPH::FixedSizeFreeList<Job>::cInvalidObjectIndex)
+    {
+        JPH_ASSERT(false, "No physics jobs available!");
+        std::this_thread::yield();
+        index = m_jobs.ConstructObject(inName, inColor, this, inJobFunction, inNumDependencies);
+    }
+
+    Job* job = &m_jobs.Get(index);
+
+    // Keep a reference, the job is queued below and may complete right away
+    JobHandle handle(job);
+    if (inNumDependencies == 0) QueueJob(job);
+
+    return handle;
+}
+
+void bee::PhysicsJobSystem::QueueJob(Job* inJob)
+{
+    // The task holds a reference until it ran, a barrier may already have executed the job by then
+    inJob->AddRef();
+    m_threadPool.Enqueue(
+        [inJob]
+        {
+            inJob->Execute();
+            inJob->Release();
+        });
+}
+
+void bee::PhysicsJobSystem::QueueJobs(Job** inJobs, JPH::uint inNumJobs)
+{
+    for (JPH::uint i = 0; i < inNumJobs; i++)
+        QueueJob(inJobs[i]);
+}
+
+void bee::PhysicsJobSystem::FreeJob(Job* inJob)
+{
+    m_jobs.DestructObject(inJob);
+}
@@ -0,0 +1,31 @@
+#include <precompiled/engine_precompiled.hpp>
+#include "physics/physics_snapshot.hpp"
+
+#include "tools/log.hpp"
+
+void bee::PhysicsSnapshot::Save(const JPH::PhysicsSystem& physicsSystem, JPH::EStateRecorderState state)
+{
+    m_recorder.Clear();
+    physicsSystem.SaveState(m_recorder, state);
+    m_empty = false;
+}
+
+bool bee::PhysicsSnapshot::Restore(JPH::PhysicsSystem& physicsSystem)
+{
+    if (m_empty) return false;
+
+    m_recorder.Rewind();
+    if (!physicsSystem.RestoreState(m_recorder))
+    {
+        Log::Warn("Could not restore the physics state, the bodies changed since it was saved");
+        return false;
+    }
+
+    return true;
+}
+
+bool bee::PhysicsSnapshot::IsEqual(PhysicsSnapshot& other)
+{
+    if (m_empty || other.m_empty) return m_empty == other.m_empty;
+    return m_recorder.IsEqual(other.m_recorder);
+}
@@ -11,6 +11,8 @@
 #include <jolt/Physics/Body/BodyCreationSettings.h>
 
 #include "physics/helpers.hpp"
+#include "physics/job_system.hpp"
+#include "physics/static_body_batch.hpp"
 #include "physics/debug_renderer.hpp"
 
 BPLayerInterfaceImpl::BPLayerInterfaceImpl()
@@ -106,13 +108,36 @@ static void TraceImpl(const char* inFMT, ...)
 void bee::PhysicsSystem::OnDestroyCollider(entt::registry& registry, entt::entity entity)
 {
 	auto* collider = registry.try_get<ColliderComponent>(entity);
-	if (collider != nullptr && !collider->body.IsInvalid())
-	{
-		auto& bodyInterface = m_joltPhysicsSystem->GetBodyInterface();
+	if (collider != nullptr) DestroyBody(collider->body);
+}
 
-		bodyInterface.RemoveBody(collider->body);
-		bodyInterface.DestroyBody(collider->body);
-	}
+void bee::PhysicsSystem::OnDestroySensor(entt::registry& registry, entt::entity entity)
+{
+	auto* sensor = registry.try_get<SensorComponent>(entity);
+	if (sensor != nullptr) DestroyBody(sensor->body);
+}
+
+void bee::PhysicsSystem::OnDestroySensorTarget(entt::registry& registry, entt::entity entity)
+{
+	auto* target = registry.try_get<SensorTargetComponent>(entity);
+	if (target != nullptr) DestroyBody(target->body);
+}
+
+void bee::PhysicsSystem::OnUpdateTransform(entt::registry& registry, entt::entity entity)
+{
+	// Can run before the Transform marks itself dirty
+	registry.get<Transform>(entity).MarkDirty();
+	UpdateColliderTransforms(registry, entity);
+}
+
+void bee::PhysicsSystem::DestroyBody(JPH::BodyID body)
+{
+	if (body.IsInvalid()) return;
+
+	auto& bodyInterface = m_joltPhysicsSystem->GetBodyInterface();
+
+	bodyInterface.RemoveBody(body);
+	bodyInterface.DestroyBody(body);
 }
 
 bee::PhysicsSystem::PhysicsSystem()
@@ -127,7 +152,11 @@ bee::PhysicsSystem::PhysicsSystem()
 
 	JPH::RegisterTypes();
 
-	// add TempAllocator and JobSystem here if needed
+	// Scratch memory for a single update, allocating it per update would hit the heap every frame
+	m_tempAllocator = std::make_unique<JPH::TempAllocatorImpl>(10 * 1024 * 1024);
+
+	// Physics jobs run on the engine workers, the main thread helps out while it waits for the update
+	m_jobSystem = std::make_unique<PhysicsJobSystem>(Engine.ThreadPool(), JPH::cMaxPhysicsJobs, JPH::cMaxPhysicsBarriers);
 
 	// may need to update later
 	const unsigned int cMaxBodies = 1024 * 64;
@@ -142,7 +171,13 @@ bee::PhysicsSystem::PhysicsSystem()
 	m_joltPhysicsSystem = std::make_unique<JPH::PhysicsSystem>();
 	m_joltPhysicsSystem->Init(cMaxBodies, cNumBodyMutexes, cMaxBodyPairs, cMaxContactConstraints, m_broadPhaseLayerInterface, m_objectVsBroadphaseLayerFilter, m_objectVsObjectLayerFilter);
 
+	// Sensor overlaps are reported to the listener during the update
+	m_joltPhysicsSystem->SetContactListener(&m_sensorListener);
+
 	bee::Engine.ECS().Registry.on_destroy<ColliderComponent>().connect<&PhysicsSystem::OnDestroyCollider>(*this);
+	bee::Engine.ECS().Registry.on_destroy<SensorComponent>().connect<&PhysicsSystem::OnDestroySensor>(*this);
+	bee::Engine.ECS().Registry.on_destroy<SensorTargetComponent>().connect<&PhysicsSystem::OnDestroySensorTarget>(*this);
+	bee::Engine.ECS().Registry.on_update<Transform>().connect<&PhysicsSystem::OnUpdateTransform>(*this);
 
 #if defined(JPH_DEBUG_RENDERER) && defined(BEE_PLATFORM_PC)
 	m_drawSettings.mDrawShape = true;
@@ -158,60 +193,137 @@ bee::PhysicsSystem::~PhysicsSystem()
 	//bee::Engine.ECS().Registry.on_destroy<ColliderComponent>().disconnect<&PhysicsSystem::OnDestroyCollider>(*this);
 
 	m_joltPhysicsSystem.reset();
+	m_jobSystem.reset();
+	m_tempAllocator.reset();
 }
 
-void bee::PhysicsSystem::DrawBodies()
+void bee::PhysicsSystem::Update(float fixedTimeStep, uint32_t steps)
 {
-#if defined(JPH_DEBUG_RENDERER) && defined(BEE_PLATFORM_PC)
-	m_joltPhysicsSystem->DrawBodies(m_drawSettings, JPH::DebugRenderer::sInstance);
-#endif
+	if (steps > 0)
+	{
+		MoveSensorTargets(fixedTimeStep * static_cast<float>(steps));
+		Step(fixedTimeStep, steps);
+
+		m_stepsSinceSnapshot += steps;
+		if (m_snapshotInterval > 0 && m_stepsSinceSnapshot >= m_snapshotInterval)
+			SaveSnapshot();
+	}
+
+	// Without a step the overlaps did not change, the sensors still report what they hold
+	m_sensorListener.Flush(m_sensorEvents);
+
+	const entt::registry& registry = Engine.ECS().Registry;
+	m_sensorEvents.erase(std::remove_if(m_sensorEvents.begin(), m_sensorEvents.end(), [&registry](const SensorEvent& event)
+		{
+			return !registry.valid(event.sensor) || !registry.valid(event.other);
+		}), m_sensorEvents.end());
 }
 
-void bee::InitColliderTransforms(entt::registry& registry, entt::entity entity)
+void bee::PhysicsSystem::Step(float fixedTimeStep, uint32_t steps)
 {
-	Transform* transform = registry.try_get<Transform>(entity);
+	// Every collision step is one fixed step, they share the job setup of a single update
+	const JPH::EPhysicsUpdateError error = m_joltPhysicsSystem->Update(fixedTimeStep * static_cast<float>(steps), static_cast<int>(steps),
+		m_tempAllocator.get(), m_jobSystem.get());
 
-	if (transform != nullptr)
+	if (error != JPH::EPhysicsUpdateError::None)
+		Log::Warn("Physics update ran out of space (error flags {:#x}), increase the physics system limits", static_cast<uint32_t>(error));
+}
+
+void bee::PhysicsSystem::SaveSnapshot()
+{
+	m_snapshot.Save(*m_joltPhysicsSystem);
+	m_stepsSinceSnapshot = 0;
+}
+
+bool bee::PhysicsSystem::RestoreSnapshot()
+{
+	if (!m_snapshot.Restore(*m_joltPhysicsSystem)) return false;
+
+	// The restored contacts are picked up again as they persist
+	m_sensorListener.Clear();
+	m_stepsSinceSnapshot = 0;
+	return true;
+}
+
+bool bee::PhysicsSystem::CheckDeterminism(uint32_t steps, const std::function<void(uint32_t step)>& step,
+	const std::function<void(JPH::StateRecorder&)>& saveState, const std::function<void(JPH::StateRecorder&)>& restoreState)
+{
+	auto save = [this, &saveState](JPH::StateRecorderImpl& recorder)
 	{
-		ColliderComponent* collider = registry.try_get<ColliderComponent>(entity);
+		m_joltPhysicsSystem->SaveState(recorder);
+		saveState(recorder);
+	};
 
-		if (collider != nullptr && collider->shape.GetPtr() != nullptr)
-		{
-			glm::vec3 scale, translation;
-			glm::quat rotation;
+	auto restore = [this, &restoreState](JPH::StateRecorderImpl& recorder)
+	{
+		recorder.Rewind();
+		m_joltPhysicsSystem->RestoreState(recorder);
+		restoreState(recorder);
 
-			Decompose(transform->World(), translation, scale, rotation);
+		// The restored contacts are picked up again as they persist
+		m_sensorListener.Clear();
+	};
 
-			JPH::PhysicsSystem& physicsSystem = Engine.PhysicsSystem();
-			JPH::BodyInterface& bodyInterface = physicsSystem.GetBodyInterface();
-			JPH::BodyCreationSettings bodySettings(collider->shape.GetPtr()->ScaleShape(GlmToJolt(scale)).Get(), GlmToJolt(translation), GlmToJolt(rotation), JPH::EMotionType::Static, Layers::NON_MOVING);
-
-			JPH::Body* body = bodyInterface.CreateBody(bodySettings);
-
-            if (body != nullptr)
-            {
-				if (!collider->body.IsInvalid())
-				{
-					bodyInterface.RemoveBody(collider->body);
-					bodyInterface.DestroyBody(collider->body);
-				}
-
-                bodyInterface.AddBody(body->GetID(), JPH::EActivation::DontActivate);
-                body->SetUserData(static_cast<JPH::uint64>(entity));
-                collider->body = body->GetID();
-            }
-            else
-            {
-                Log::Warn("physics body creation failed");
-                Log::Info("num bodies: {:d}, max bodies: {:d}", physicsSystem.GetNumBodies(), physicsSystem.GetMaxBodies());
-            }
-		}
+	// The test steps must not replace the saved snapshot
+	const uint32_t snapshotInterval = m_snapshotInterval;
+	m_snapshotInterval = 0;
 
-		for (auto iter = transform->begin(); iter != transform->end(); ++iter)
-		{
-			InitColliderTransforms(registry, *iter);
-		}
+	JPH::StateRecorderImpl start, first, second;
+	save(start);
+
+	for (uint32_t i = 0; i < steps; i++) step(i);
+	save(first);
+
+	restore(start);
+	for (uint32_t i = 0; i < steps; i++) step(i);
+	save(second);
+
+	restore(start);
+	m_snapshotInterval = snapshotInterval;
+
+	// Compared here instead of replaying with a validating recorder, Jolt breaks into the debugger on a mismatch
+	const JPH::string firstData = first.GetData(), secondData = second.GetData();
+	const bool deterministic = firstData == secondData;
+	if (deterministic)
+	{
+		Log::Info("Simulation is deterministic over {} steps ({} bytes of state)", steps, firstData.size());
 	}
+	else
+	{
+		const size_t common = std::min(firstData.size(), secondData.size());
+		const size_t offset = std::mismatch(firstData.begin(), firstData.begin() + common, secondData.begin()).first - firstData.begin();
+		Log::Warn("Simulation diverged within {} steps, the saved states first differ at byte {} of {}/{}", steps, offset,
+			firstData.size(), secondData.size());
+	}
+
+	return deterministic;
+}
+
+void bee::PhysicsSystem::MoveSensorTargets(float deltaTime)
+{
+	auto& bodyInterface = m_joltPhysicsSystem->GetBodyInterface();
+
+	// Moving them kinematically keeps them awake, sensors lose track of sleeping bodies
+	auto view = Engine.ECS().Registry.view<Transform, SensorTargetComponent>();
+	for (auto&& [entity, transform, target] : view.each())
+	{
+		if (target.body.IsInvalid()) continue;
+		bodyInterface.MoveKinematic(target.body, GlmToJolt(glm::vec3(transform.World()[3])), JPH::Quat::sIdentity(), deltaTime);
+	}
+}
+
+void bee::PhysicsSystem::DrawBodies()
+{
+#if defined(JPH_DEBUG_RENDERER) && defined(BEE_PLATFORM_PC)
+	m_joltPhysicsSystem->DrawBodies(m_drawSettings, JPH::DebugRenderer::sInstance);
+#endif
+}
+
+void bee::InitColliderTransforms(entt::registry& registry, entt::entity entity)
+{
+	StaticBodyBatch batch;
+	batch.AddColliders(registry, entity);
+	batch.Commit(registry);
 }
 
 void bee::UpdateColliderTransforms(entt::registry& registry, entt::entity entity)
@@ -232,10 +344,19 @@ void bee::UpdateColliderTransforms(entt::registry& registry, entt::entity entity
 			JPH::PhysicsSystem& physicsSystem = Engine.PhysicsSystem();
 			JPH::BodyInterface& bodyInterface = physicsSystem.GetBodyInterface();
 
-			bodyInterface.SetShape(collider->body, collider->shape.GetPtr()->ScaleShape(GlmToJolt(scale)).Get(), false, JPH::EActivation::DontActivate);
+			bodyInterface.SetShape(collider->body, Engine.PhysicsShapeCache().GetScaled(collider->shape.GetPtr(), scale), false, JPH::EActivation::DontActivate);
 			bodyInterface.SetPositionAndRotation(collider->body, GlmToJolt(translation), GlmToJolt(rotation), JPH::EActivation::DontActivate);
 		}
 
+		// Sensors are spheres at the entity position, see AddSphereSensor
+		SensorComponent* sensor = registry.try_get<SensorComponent>(entity);
+
+		if (sensor != nullptr && !sensor->body.IsInvalid())
+		{
+			JPH::BodyInterface& bodyInterface = Engine.PhysicsSystem().GetBodyInterface();
+			bodyInterface.SetPosition(sensor->body, GlmToJolt(glm::vec3(transform->World()[3])), JPH::EActivation::DontActivate);
+		}
+
 		for (auto iter = transform->begin(); iter != transform->end(); ++iter)
 		{
 			UpdateColliderTransforms(registry, *iter);
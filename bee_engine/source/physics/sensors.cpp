@@ -0,0 +1,139 @@
+#include <precompiled/engine_precompiled.hpp>
+#include "physics/sensors.hpp"
+
+#include "core/engine.hpp"
+#include "core/ecs.hpp"
+#include "core/transform.hpp"
+#include "physics/helpers.hpp"
+#include "physics/layers.hpp"
+#include "physics/physics_system.hpp"
+
+#include <jolt/Physics/Body/Body.h>
+#include <jolt/Physics/Body/BodyCreationSettings.h>
+#include <jolt/Physics/Collision/Shape/SphereShape.h>
+
+namespace
+{
+JPH::BodyID CreateSphereBody(entt::entity entity, float radius, glm::vec3 position, JPH::EMotionType motionType, JPH::ObjectLayer layer)
+{
+    JPH::BodyCreationSettings settings(new JPH::SphereShape(radius), GlmToJolt(position), JPH::Quat::sIdentity(), motionType, layer);
+    settings.mUserData = static_cast<JPH::uint64>(entity);
+    settings.mIsSensor = motionType == JPH::EMotionType::Static;
+
+    // A sleeping target is no longer detected by the sensors around it
+    settings.mAllowSleeping = false;
+
+    const JPH::EActivation activation = motionType == JPH::EMotionType::Static ? JPH::EActivation::DontActivate : JPH::EActivation::Activate;
+    return bee::Engine.PhysicsSystem().GetBodyInterface().CreateAndAddBody(settings, activation);
+}
+}
+
+void bee::AddSphereSensor(entt::registry& registry, entt::entity entity, float radius)
+{
+    const Transform* transform = registry.try_get<Transform>(entity);
+    if (transform == nullptr) return;
+
+    const JPH::BodyID body = CreateSphereBody(entity, radius, transform->World()[3], JPH::EMotionType::Static, Layers::COLLECTABLE);
+    if (body.IsInvalid())
+    {
+        Log::Warn("physics sensor creation failed");
+        return;
+    }
+
+    // Removing the previous one destroys its body
+    registry.remove<SensorComponent>(entity);
+    registry.emplace<SensorComponent>(entity, body);
+}
+
+void bee::AddSphereSensorTarget(entt::registry& registry, entt::entity entity, float radius)
+{
+    const Transform* transform = registry.try_get<Transform>(entity);
+    if (transform == nullptr) return;
+
+    const JPH::BodyID body = CreateSphereBody(entity, radius, transform->World()[3], JPH::EMotionType::Kinematic, Layers::MOVING);
+    if (body.IsInvalid())
+    {
+        Log::Warn("physics sensor target creation failed");
+        return;
+    }
+
+    // Removing the previous one destroys its body
+    registry.remove<SensorTargetComponent>(entity);
+    registry.emplace<SensorTargetComponent>(entity, body);
+}
+
+void bee::SensorContactListener::OnContactAdded(const JPH::Body& inBody1, const JPH::Body& inBody2, const JPH::ContactManifold&,
+    JPH::ContactSettings&)
+{
+    AddContact(inBody1, inBody2, false);
+}
+
+void bee::SensorContactListener::OnContactPersisted(const JPH::Body& inBody1, const JPH::Body& inBody2, const JPH::ContactManifold&,
+    JPH::ContactSettings&)
+{
+    AddContact(inBody1, inBody2, true);
+}
+
+void bee::SensorContactListener::AddContact(const JPH::Body& inBody1, const JPH::Body& inBody2, bool persisted)
+{
+    if (!inBody1.IsSensor() && !inBody2.IsSensor()) return;
+
+    const JPH::Body& sensor = inBody1.IsSensor() ? inBody1 : inBody2;
+    const JPH::Body& other = inBody1.IsSensor() ? inBody2 : inBody1;
+    const uint64_t key = GetKey(sensor.GetID(), other.GetID());
+
+    std::lock_guard lock(m_mutex);
+
+    // Persisting contacts are only new after a restored state brought them back
+    auto found = m_overlaps.find(key);
+    if (persisted && found != m_overlaps.end()) return;
+
+    Overlap& overlap = found != m_overlaps.end() ? found->second : m_overlaps[key];
+    if (overlap.contacts++ > 0) return;
+
+    overlap.sensor = static_cast<entt::entity>(sensor.GetUserData());
+    overlap.other = static_cast<entt::entity>(other.GetUserData());
+    overlap.entered = true;
+    m_changes.push_back({ SensorEvent::Type::Enter, overlap.sensor, overlap.other });
+}
+
+void bee::SensorContactListener::OnContactRemoved(const JPH::SubShapeIDPair& inSubShapePair)
+{
+    // The bodies may be gone already, which of them is the sensor follows from the overlaps that were added
+    const JPH::BodyID body1 = inSubShapePair.GetBody1ID();
+    const JPH::BodyID body2 = inSubShapePair.GetBody2ID();
+
+    std::lock_guard lock(m_mutex);
+    auto overlap = m_overlaps.find(GetKey(body1, body2));
+    if (overlap == m_overlaps.end()) overlap = m_overlaps.find(GetKey(body2, body1));
+    if (overlap == m_overlaps.end() || --overlap->second.contacts > 0) return;
+
+    m_changes.push_back({ SensorEvent::Type::Exit, overlap->second.sensor, overlap->second.other });
+    m_overlaps.erase(overlap);
+}
+
+void bee::SensorContactListener::Flush(std::vector<SensorEvent>& events)
+{
+    std::lock_guard lock(m_mutex);
+
+    events.swap(m_changes);
+    m_changes.clear();
+
+    for (auto& [key, overlap] : m_overlaps)
+    {
+        if (!overlap.entered) events.push_back({ SensorEvent::Type::Stay, overlap.sensor, overlap.other });
+        overlap.entered = false;
+    }
+}
+
+void bee::SensorContactListener::Clear()
+{
+    std::lock_guard lock(m_mutex);
+    m_overlaps.clear();
+    m_changes.clear();
+}
+
+uint64_t bee::SensorContactListener::GetKey(JPH::BodyID sensor, JPH::BodyID other)
+{
+    return (static_cast<uint64_t>(sensor.GetIndexAndSequenceNumber()) << 32) | other.GetIndexAndSequenceNumber();
+}
@@ -0,0 +1,138 @@
+#include <precompiled/engine_precompiled.hpp>
+#include "physics/shape_cache.hpp"
+
+#include "physics/helpers.hpp"
+#include "tools/tools.hpp"
+
+size_t bee::ShapeCache::KeyHash::operator()(const Key& key) const
+{
+    const uint64_t values[4] = { reinterpret_cast<uint64_t>(key.shape), static_cast<uint64_t>(key.scale.x),
+        static_cast<uint64_t>(key.scale.y), static_cast<uint64_t>(key.scale.z) };
+    return static_cast<size_t>(HashBytes(values, sizeof(values)));
+}
+
+JPH::RefConst<JPH::Shape> bee::ShapeCache::GetScaled(const JPH::Shape* shape, glm::vec3 scale)
+{
+    // Degenerate scales can't be quantized in log space, those shapes are not shared
+    const glm::vec3 magnitude = glm::abs(scale);
+    if (glm::any(glm::lessThan(magnitude, glm::vec3(1e-6f))))
+    {
+        JPH::Shape::ShapeResult result = shape->ScaleShape(GlmToJolt(scale));
+        return result.IsValid() ? result.Get() : shape;
+    }
+
+    const glm::ivec3 steps = glm::ivec3(glm::round(glm::log2(magnitude) * SCALE_STEPS));
+    const glm::ivec3 negative = glm::ivec3(glm::lessThan(scale, glm::vec3(0.0f)));
+    const Key key{ shape, steps * 2 + negative };
+
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        auto it = m_shapes.find(key);
+        if (it != m_shapes.end())
+        {
+            m_stats.hits++;
+            return it->second.scaled;
+        }
+    }
+
+    // Scaling happens outside the lock, two threads missing on the same key both scale and the first one is kept
+    const glm::vec3 sign = glm::vec3(1.0f) - glm::vec3(negative) * 2.0f;
+    const glm::vec3 quantized = glm::exp2(glm::vec3(steps) / SCALE_STEPS) * sign;
+    JPH::Shape::ShapeResult result = shape->ScaleShape(GlmToJolt(quantized));
+    if (!result.IsValid()) return shape;
+
+    // A unit scale gives back the source shape, that costs nothing extra
+    const JPH::Shape* scaled = result.Get().GetPtr();
+    Entry entry{ shape, scaled, scaled == shape ? 0 : scaled->GetStats().mSizeBytes };
+
+    std::lock_guard<std::mutex> lock(m_mutex);
+    m_stats.misses++;
+    auto [it, inserted] = m_shapes.emplace(key, std::move(entry));
+    if (inserted) m_stats.memoryBytes += it->second.memoryBytes;
+    return it->second.scaled;
+}
+
+JPH::Ref<JPH::Shape> bee::ShapeCache::AddContentShape(uint64_t hash, JPH::Shape* shape)
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+    auto [it, inserted] = m_contentShapes.emplace(hash, shape);
+    if (inserted) m_contentHashes.emplace(shape, hash);
+    return it->second;
+}
+
+uint64_t bee::ShapeCache::GetContentHash(const JPH::Shape* shape) const
+{
+    // The cache keeps the shapes alive, their addresses can't be reused by another shape
+    std::lock_guard<std::mutex> lock(m_mutex);
+    auto it = m_contentHashes.find(shape);
+    return it != m_contentHashes.end() ? it->second : 0;
+}
+
+JPH::Ref<JPH::Shape> bee::ShapeCache::FindByContentHash(uint64_t hash) const
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+    auto it = m_contentShapes.find(hash);
+    return it != m_contentShapes.end() ? it->second : nullptr;
+}
+
+void bee::ShapeCache::Prune()
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+
+    // References the cache itself holds, a shape with no others is unused
+    std::unordered_map<const JPH::Shape*, uint32_t> cacheReferences;
+    for (const auto& [key, entry] : m_shapes)
+    {
+        cacheReferences[entry.source.GetPtr()]++;
+        cacheReferences[entry.scaled.GetPtr()]++;
+    }
+    for (const auto& [hash, shape] : m_contentShapes)
+        cacheReferences[shape.GetPtr()]++;
+
+    for (auto it = m_shapes.begin(); it != m_shapes.end();)
+    {
+        const JPH::Shape* scaled = it->second.scaled.GetPtr();
+        if (scaled->GetRefCount() <= cacheReferences[scaled])
+        {
+            cacheReferences[it->second.source.GetPtr()]--;
+            cacheReferences[scaled]--;
+            m_stats.memoryBytes -= it->second.memoryBytes;
+            it = m_shapes.erase(it);
+        }
+        else
+        {
+            ++it;
+        }
+    }
+
+    for (auto it = m_contentShapes.begin(); it != m_contentShapes.end();)
+    {
+        const JPH::Shape* shape = it->second.GetPtr();
+        if (shape->GetRefCount() <= cacheReferences[shape])
+        {
+            m_contentHashes.erase(shape);
+            it = m_contentShapes.erase(it);
+        }
+        else
+        {
+            ++it;
+        }
+    }
+}
+
+void bee::ShapeCache::Clear()
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+    m_shapes.clear();
+    m_contentHashes.clear();
+    m_contentShapes.clear();
+    m_stats = Stats{};
+}
+
+bee::ShapeCache::Stats bee::ShapeCache::GetStats() const
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+    Stats stats = m_stats;
+    stats.shapes = m_shapes.size();
+    return stats;
+}
@@ -0,0 +1,307 @@
+#include <precompiled/engine_precompiled.hpp>
+#include "physics/static_body_batch.hpp"
+
+#include "core/engine.hpp"
+#include "core/ecs.hpp"
+#include "core/transform.hpp"
+#include "physics/helpers.hpp"
+#include "physics/layers.hpp"
+#include "physics/physics_system.hpp"
+#include "physics/shape_cache.hpp"
+#include "tools/thread_pool.hpp"
+#include "tools/tools.hpp"
+
+#include <jolt/Core/StreamWrapper.h>
+#include <jolt/Physics/Body/BodyCreationSettings.h>
+
+namespace
+{
+// Below this many bodies scaling the shapes on the calling thread is quicker than handing them out
+constexpr size_t PARALLEL_SCALE_THRESHOLD = 64;
+
+constexpr uint32_t SNAPSHOT_MAGIC = 0x53485042;  // "BPHS"
+// Bump when the way the bodies are built changes, so old snapshots are rebuilt
+constexpr uint32_t SNAPSHOT_VERSION = 4;
+
+// The binary state of bodies and shapes is only valid for the Jolt version and feature set that saved it
+using JPH::uint64;
+constexpr uint64_t JOLT_VERSION_ID = JPH_VERSION_ID;
+
+// File layout: header, the content hashes of the source shapes, then the bodies saved with their scaled shapes.
+// Source shapes are written as their index in the hashes, they are owned by the models.
+struct SnapshotHeader
+{
+    uint32_t magic = SNAPSHOT_MAGIC;
+    uint32_t version = SNAPSHOT_VERSION;
+    uint64_t joltVersion = JOLT_VERSION_ID;
+    uint64_t key = 0;
+    uint32_t bodyCount = 0;
+    uint32_t sourceCount = 0;
+};
+}
+
+void bee::StaticBodyBatch::Add(entt::entity entity, const JPH::Shape* shape, glm::vec3 scale, glm::vec3 position, glm::quat rotation, JPH::ObjectLayer layer)
+{
+    m_entries.push_back({ entity, shape, scale, position, rotation, layer });
+}
+
+void bee::StaticBodyBatch::AddColliders(entt::registry& registry, entt::entity entity)
+{
+    Transform* transform = registry.try_get<Transform>(entity);
+    if (transform == nullptr) return;
+
+    ColliderComponent* collider = registry.try_get<ColliderComponent>(entity);
+    if (collider != nullptr && collider->shape.GetPtr() != nullptr)
+    {
+        glm::vec3 scale, translation;
+        glm::quat rotation;
+        Decompose(transform->World(), translation, scale, rotation);
+
+        Add(entity, collider->shape.GetPtr(), scale, translation, rotation, Layers::NON_MOVING);
+    }
+
+    for (auto iter = transform->begin(); iter != transform->end(); ++iter)
+        AddColliders(registry, *iter);
+}
+
+void bee::StaticBodyBatch::Commit(entt::registry& registry)
+{
+    if (m_entries.empty()) return;
+
+    std::vector<JPH::BodyCreationSettings> settings = CreateSettings();
+    AddBodies(registry, settings);
+}
+
+void bee::StaticBodyBatch::Commit(entt::registry& registry, FileIO::Directory directory, const std::string& snapshotPath)
+{
+    if (m_entries.empty()) return;
+
+    // Shapes that are not shared by content hash can't be written to a snapshot
+    const uint64_t key = GetKey();
+    if (key == 0)
+    {
+        Commit(registry);
+        return;
+    }
+
+    std::vector<JPH::BodyCreationSettings> settings;
+    if (RestoreSnapshot(directory, snapshotPath, key, settings))
+    {
+        AddBodies(registry, settings);
+        return;
+    }
+
+    settings = CreateSettings();
+    SaveSnapshot(directory, snapshotPath, key, settings);
+    AddBodies(registry, settings);
+}
+
+std::vector<JPH::BodyCreationSettings> bee::StaticBodyBatch::CreateSettings() const
+{
+    // Scale the shapes, in parallel for larger batches. Instances at the same scale share their shape.
+    std::vector<JPH::RefConst<JPH::Shape>> shapes(m_entries.size());
+    ShapeCache& shapeCache = Engine.PhysicsShapeCache();
+    auto scaleShapes = [this, &shapes, &shapeCache](size_t begin, size_t end)
+    {
+        for (size_t i = begin; i < end; i++)
+        {
+            const Entry& entry = m_entries[i];
+            shapes[i] = shapeCache.GetScaled(entry.shape, entry.scale);
+        }
+    };
+
+    if (m_entries.size() < PARALLEL_SCALE_THRESHOLD)
+    {
+        scaleShapes(0, m_entries.size());
+    }
+    else
+    {
+        ThreadPool& threadPool = Engine.ThreadPool();
+        const size_t taskCount = threadPool.NumberOfThreads() + 1;
+        const size_t perTask = (m_entries.size() + taskCount - 1) / taskCount;
+
+        std::vector<std::future<void>> tasks;
+        for (size_t begin = perTask; begin < m_entries.size(); begin += perTask)
+            tasks.push_back(threadPool.Enqueue(scaleShapes, begin, glm::min(begin + perTask, m_entries.size())));
+
+        scaleShapes(0, glm::min(perTask, m_entries.size()));
+        for (auto& task : tasks) task.wait();
+    }
+
+    std::vector<JPH::BodyCreationSettings> settings;
+    settings.reserve(m_entries.size());
+    for (size_t i = 0; i < m_entries.size(); i++)
+    {
+        const Entry& entry = m_entries[i];
+        JPH::BodyCreationSettings& body = settings.emplace_back(shapes[i], GlmToJolt(entry.position), GlmToJolt(entry.rotation), JPH::EMotionType::Static, entry.layer);
+
+        // Nothing collides with collectables, they only report the bodies passing through them
+        body.mIsSensor = entry.layer == Layers::COLLECTABLE;
+    }
+
+    return settings;
+}
+
+bool bee::StaticBodyBatch::RestoreSnapshot(FileIO::Directory directory, const std::string& path, uint64_t key,
+    std::vector<JPH::BodyCreationSettings>& settings) const
+{
+    auto& fileIO = Engine.FileIO();
+    if (path.empty() || !fileIO.Exists(directory, path)) return false;
+
+    std::vector<char> file = fileIO.ReadBinaryFile(directory, path);
+
+    SnapshotHeader header{};
+    if (file.size() < sizeof(header)) return false;
+    std::memcpy(&header, file.data(), sizeof(header));
+
+    const SnapshotHeader expected{};
+    if (header.magic != expected.magic || header.version != expected.version || header.joltVersion != expected.joltVersion ||
+        header.key != key || header.bodyCount != m_entries.size())
+    {
+        Log::Info("Physics snapshot {} is outdated, rebuilding it", path);
+        return false;
+    }
+
+    const size_t hashesSize = sizeof(uint64_t) * header.sourceCount;
+    if (file.size() < sizeof(header) + hashesSize) return false;
+    std::vector<uint64_t> sourceHashes(header.sourceCount);
+    std::memcpy(sourceHashes.data(), file.data() + sizeof(header), hashesSize);
+
+    // The source shapes take the first ids, the scaled shapes around them are read from the file
+    ShapeCache& shapeCache = Engine.PhysicsShapeCache();
+    JPH::BodyCreationSettings::IDToShapeMap shapeMap;
+    shapeMap.reserve(header.sourceCount);
+    for (uint64_t hash : sourceHashes)
+    {
+        JPH::Ref<JPH::Shape> source = shapeCache.FindByContentHash(hash);
+        if (source == nullptr)
+        {
+            Log::Warn("Physics snapshot {} refers to a shape that is not loaded, rebuilding it", path);
+            return false;
+        }
+        shapeMap.push_back(source);
+    }
+
+    const size_t stateOffset = sizeof(header) + hashesSize;
+    std::istringstream stream(std::string(file.data() + stateOffset, file.size() - stateOffset), std::ios::binary);
+    JPH::StreamInWrapper streamIn(stream);
+    JPH::BodyCreationSettings::IDToMaterialMap materialMap;
+    JPH::BodyCreationSettings::IDToGroupFilterMap groupFilterMap;
+
+    settings.reserve(m_entries.size());
+    for (size_t i = 0; i < m_entries.size(); i++)
+    {
+        JPH::BodyCreationSettings::BCSResult result = JPH::BodyCreationSettings::sRestoreWithChildren(streamIn, shapeMap, materialMap, groupFilterMap);
+        if (!result.IsValid() || streamIn.IsFailed())
+        {
+            Log::Warn("Could not restore physics snapshot {}, rebuilding it", path);
+            settings.clear();
+            return false;
+        }
+        settings.push_back(result.Get());
+    }
+
+    return true;
+}
+
+void bee::StaticBodyBatch::SaveSnapshot(FileIO::Directory directory, const std::string& path, uint64_t key,
+    const std::vector<JPH::BodyCreationSettings>& settings) const
+{
+    if (path.empty()) return;
+
+    // Every source shape gets its id up front, so only the scaled shapes around them are written
+    ShapeCache& shapeCache = Engine.PhysicsShapeCache();
+    JPH::BodyCreationSettings::ShapeToIDMap shapeMap;
+    std::vector<uint64_t> sourceHashes;
+    for (const Entry& entry : m_entries)
+    {
+        if (shapeMap.try_emplace(entry.shape.GetPtr(), static_cast<JPH::uint32>(shapeMap.size())).second)
+            sourceHashes.push_back(shapeCache.GetContentHash(entry.shape));
+    }
+
+    std::ostringstream stream(std::ios::binary);
+    JPH::StreamOutWrapper streamOut(stream);
+    JPH::BodyCreationSettings::MaterialToIDMap materialMap;
+    for (const JPH::BodyCreationSettings& body : settings)
+        body.SaveWithChildren(streamOut, &shapeMap, &materialMap, nullptr);
+    const std::string state = stream.str();
+
+    SnapshotHeader header{};
+    header.key = key;
+    header.bodyCount = static_cast<uint32_t>(settings.size());
+    header.sourceCount = static_cast<uint32_t>(sourceHashes.size());
+
+    std::vector<char> file(sizeof(header) + sizeof(uint64_t) * sourceHashes.size());
+    std::memcpy(file.data(), &header, sizeof(header));
+    std::memcpy(file.data() + sizeof(header), sourceHashes.data(), sizeof(uint64_t) * sourceHashes.size());
+    file.insert(file.end(), state.begin(), state.end());
+
+    if (Engine.FileIO().WriteBinaryFile(directory, path, file))
+        Log::Info("Saved physics snapshot of {} bodies to {}", header.bodyCount, path);
+}
+
+uint64_t bee::StaticBodyBatch::GetKey() const
+{
+    ShapeCache& shapeCache = Engine.PhysicsShapeCache();
+    uint64_t key = HashBytes(&SNAPSHOT_VERSION, sizeof(SNAPSHOT_VERSION));
+    for (const Entry& entry : m_entries)
+    {
+        const uint64_t contentHash = shapeCache.GetContentHash(entry.shape);
+        if (contentHash == 0) return 0;
+
+        const float values[] = {
+            entry.position.x, entry.position.y, entry.position.z,
+            entry.rotation.x, entry.rotation.y, entry.rotation.z, entry.rotation.w,
+            entry.scale.x, entry.scale.y, entry.scale.z };
+        const uint64_t shape[] = { static_cast<uint64_t>(entry.layer), contentHash };
+
+        key = HashBytes(values, sizeof(values), key);
+        key = HashBytes(shape, sizeof(shape), key);
+    }
+
+    return key;
+}
+
+void bee::StaticBodyBatch::AddBodies(entt::registry& registry, std::vector<JPH::BodyCreationSettings>& settings)
+{
+    JPH::PhysicsSystem& physicsSystem = Engine.PhysicsSystem();
+    JPH::BodyInterface& bodyInterface = physicsSystem.GetBodyInterface();
+
+    // 1. Create the bodies, replaced bodies are collected to be removed together.
+    std::vector<JPH::BodyID> bodies;
+    std::vector<JPH::BodyID> replaced;
+    bodies.reserve(m_entries.size());
+    for (size_t i = 0; i < m_entries.size(); i++)
+    {
+        const Entry& entry = m_entries[i];
+        settings[i].mUserData = static_cast<JPH::uint64>(entry.entity);
+
+        JPH::Body* body = bodyInterface.CreateBody(settings[i]);
+        if (body == nullptr)
+        {
+            Log::Warn("physics body creation failed");
+            Log::Info("num bodies: {:d}, max bodies: {:d}", physicsSystem.GetNumBodies(), physicsSystem.GetMaxBodies());
+            break;
+        }
+
+        auto& collider = registry.get_or_emplace<ColliderComponent>(entry.entity);
+        if (!collider.body.IsInvalid()) replaced.push_back(collider.body);
+        collider.body = body->GetID();
+        bodies.push_back(body->GetID());
+    }
+
+    if (!replaced.empty())
+    {
+        bodyInterface.RemoveBodies(replaced.data(), static_cast<int>(replaced.size()));
+        bodyInterface.DestroyBodies(replaced.data(), static_cast<int>(replaced.size()));
+    }
+
+    // 2. Insert them into the broad phase at once.
+    if (!bodies.empty())
+    {
+        JPH::BodyInterface::AddState addState = bodyInterface.AddBodiesPrepare(bodies.data(), static_cast<int>(bodies.size()));
+        bodyInterface.AddBodiesFinalize(bodies.data(), static_cast<int>(bodies.size()), addState, JPH::EActivation::DontActivate);
+    }
+
+    m_entries.clear();
+}
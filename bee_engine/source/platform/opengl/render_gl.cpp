@@ -22,6 +22,7 @@
 #include "platform/opengl/shader_gl.hpp"
 #include "wind/wind.hpp"
 #include <tools/log.hpp>
+#include <tools/tools.hpp>
 
 #include "platform/opengl/gl_uniform.hpp"
 #include "rendering/skybox.hpp"
@@ -34,6 +35,8 @@
 #include "platform/opengl/uniforms_gl.hpp"
 #include "rendering/model_renderer.hpp"
 #include "rendering/ibl_renderer.hpp"
+#include "rendering/impostor_renderer.hpp"
+#include "rendering/light_clusters.hpp"
 #include "rendering/shader_db.hpp"
 
 #define DEBUG_UBO_LOCATION (UBO_LOCATION_COUNT + 1)
@@ -45,8 +48,11 @@ public:
     void CreateFrameBuffers();
     void DeleteFrameBuffers();
     void CreateShadowMaps();
+    void CreateShadowMapArrays(std::array<unsigned int, m_maxDirLights>& maps, std::array<unsigned int, m_maxDirLights * MAX_SHADOW_CASCADES>& fbos, const std::string& label);
     void DeleteShadowMaps();
-    void RenderShadowMaps(TerrainRenderer& terrainRenderer, Uniform<TransformsUBO>& instanceBuffer, const std::vector<ObjectInfo>& objectsToDraw, const std::vector<LightInfo>& lightsToDraw, const Camera& camera);
+    void RenderShadowMaps(TerrainRenderer& terrainRenderer, Uniform<TransformsUBO>& instanceBuffer, const std::vector<ObjectInfo>& objectsToDraw, const std::vector<LightInfo>& lightsToDraw, const Camera& camera, const CascadeSettings& settings, bool useCache);
+    void RenderShadowCasters(Uniform<TransformsUBO>& instanceBuffer, const std::vector<ObjectInfo>& casters);
+    void UploadLightClusters();
 
     int m_width = -1;
     int m_height = -1;
@@ -54,8 +60,9 @@ public:
     static const int m_maxHDR = 2;
     static const int m_additionalRenderTargetCount = 2;
     
-    std::vector<float>  m_shadowCascadeLevels = {};
-    const int m_shadowResolution = 2048;
+    std::array<float, MAX_SHADOW_CASCADES> m_shadowCascadeLevels{};
+    uint32_t m_shadowCascadeCount = MAX_SHADOW_CASCADES;
+    int m_shadowResolution = 2048;
     float m_exposure = 1.0f;
 
     uint32_t m_hdrFramebuffer = 0;
@@ -75,10 +82,38 @@ public:
     uint32_t m_finalDepthbuffer = 0;
 
     uint32_t m_hdrTexture = 0;
-    // TODO: remove hardcoded value
-    std::array<unsigned int, m_maxDirLights * 4> m_shadowFBOs;
+    std::array<unsigned int, m_maxDirLights * MAX_SHADOW_CASCADES> m_shadowFBOs;
     std::array<unsigned int, m_maxDirLights> m_shadowMaps;
 
+    // Static casters are rendered once into these and copied into the sampled maps,
+    // dynamic casters are drawn on top every frame
+    struct ShadowCascadeCache
+    {
+        glm::mat4 matrix{ 1.0f };
+        uint64_t staticSignature = 0;
+        bool valid = false;
+        bool hasDynamicCasters = false;
+    };
+
+    std::array<unsigned int, m_maxDirLights * MAX_SHADOW_CASCADES> m_staticShadowFBOs;
+    std::array<unsigned int, m_maxDirLights> m_staticShadowMaps;
+    std::array<ShadowCascadeCache, m_maxDirLights * MAX_SHADOW_CASCADES> m_shadowCache{};
+    std::vector<ObjectInfo> m_staticCasters;
+    std::vector<ObjectInfo> m_dynamicCasters;
+
+    // Maps every position past the light far plane, which the shader treats as unshadowed.
+    // Used past the last cascade and for lights that do not cast shadows.
+    const glm::mat4 m_noShadowMatrix = glm::mat4(glm::vec4(0.0f), glm::vec4(0.0f), glm::vec4(0.0f), glm::vec4(0.0f, 0.0f, 2.0f, 1.0f));
+
+    // One extra matrix for beyond the last cascade
+    std::array<std::array<glm::mat4, MAX_SHADOW_CASCADES + 1>, m_maxDirLights> m_shadowMatrices{};
+    std::array<glm::vec3, m_maxDirLights> m_shadowLightDirections{};
+
+    // Cosine of the angle the light can turn before the cascades are refitted
+    float m_shadowLightThreshold = 0.99996f;
+    // Caster bounds are rounded out to this grid, moving casters only change the cascade depth range when they cross it
+    float m_shadowBoundsGrid = 16.0f;
+
 
     std::shared_ptr<Vignette> m_vignetteProcess = nullptr;
     std::shared_ptr<Bloom> m_bloomProcess = nullptr;
@@ -88,7 +123,20 @@ public:
     
     Uniform<DirectionalLightsUBO> m_DirectionalLightUBO;
     Uniform<CameraUBO> m_CameraDataUBO;
-    Uniform<PointLightsUBO> m_PointLightUBO;
+
+    // Clustered point lights, no fixed cap on the number of lights
+    LightClusterGrid m_lightClusters{ glm::uvec3(LIGHT_CLUSTERS_X, LIGHT_CLUSTERS_Y, LIGHT_CLUSTERS_Z) };
+    std::vector<point_light_struct> m_pointLights;
+    std::vector<glm::vec4> m_pointLightViewSpheres;
+    GLuint m_pointLightsSSBO = 0;
+    GLuint m_lightClustersSSBO = 0;
+    GLuint m_lightIndicesSSBO = 0;
+
+    // GPU time of a frame, the queries are read back a few frames later so the CPU never waits on them
+    static const uint32_t m_frameQueryCount = 4;
+    std::array<GLuint, m_frameQueryCount> m_frameQueries{};
+    uint32_t m_frameQueryIndex = 0;
+    uint32_t m_frameQueriesIssued = 0;
 
 
     bool m_shouldBlit = true;
@@ -105,6 +153,7 @@ bee::Renderer::Renderer()
     m_modelRenderer = std::make_unique<ModelRenderer>(m_debugFlags, m_ibl->SpecularMipCount());
     m_grassRenderer = std::make_unique<GrassRenderer>(m_modelRenderer->GetIBL());
     m_terrainRenderer = std::make_unique<TerrainRenderer>(m_debugFlags, m_modelRenderer->GetIBL(), m_ibl->SpecularMipCount());
+    m_impostorRenderer = std::make_unique<ImpostorRenderer>(m_modelRenderer->GetIBL());
     m_ui = std::make_unique<UIRenderer>();
     m_postProcessor = std::make_unique<PostProcessManager>();
 
@@ -116,12 +165,7 @@ bee::Renderer::Renderer()
     m_postProcessor->Reorder({ PostProcess::Type::Vignette, PostProcess::Type::DepthOfField, PostProcess::Type::Bloom });
 
 
-    const float farPlane = 1000;
-    m_impl->m_shadowCascadeLevels = {
-        farPlane / 50.0f,
-        farPlane / 25.0f,
-        farPlane / 10.0f,
-        farPlane / 2.0f };
+    for (auto& matrices : m_impl->m_shadowMatrices) matrices.fill(m_impl->m_noShadowMatrix);
 
     m_impl->CreateFrameBuffers();
     m_impl->CreateShadowMaps();
@@ -142,7 +186,15 @@ bee::Renderer::Renderer()
     //Lights
     m_impl->m_DirectionalLightUBO.SetName("Dir Lights UBO (size:" + std::to_string(sizeof(DirectionalLightsUBO)) + ")");
     glBindBufferBase(GL_UNIFORM_BUFFER, DIRECTIONAL_LIGHTS_UBO_LOCATION, m_impl->m_DirectionalLightUBO.buffer);
-    glBindBufferBase(GL_UNIFORM_BUFFER, LIGHTS_UBO_LOCATION, m_impl->m_PointLightUBO.buffer);
+
+    glCreateBuffers(1, &m_impl->m_pointLightsSSBO);
+    glCreateBuffers(1, &m_impl->m_lightClustersSSBO);
+    glCreateBuffers(1, &m_impl->m_lightIndicesSSBO);
+    LabelGL(GL_BUFFER, m_impl->m_pointLightsSSBO, "Point Lights SSBO");
+    LabelGL(GL_BUFFER, m_impl->m_lightClustersSSBO, "Light Clusters SSBO");
+    LabelGL(GL_BUFFER, m_impl->m_lightIndicesSSBO, "Light Indices SSBO");
+
+    glCreateQueries(GL_TIME_ELAPSED, Impl::m_frameQueryCount, m_impl->m_frameQueries.data());
 
     //Setup shadow map sampler values
     Engine.ShaderDB()[ShaderDB::Type::FORWARD]->Activate();
@@ -159,6 +211,11 @@ bee::Renderer::~Renderer()
 {
     m_impl->DeleteFrameBuffers();
     m_impl->DeleteShadowMaps();
+
+    glDeleteBuffers(1, &m_impl->m_pointLightsSSBO);
+    glDeleteBuffers(1, &m_impl->m_lightClustersSSBO);
+    glDeleteBuffers(1, &m_impl->m_lightIndicesSSBO);
+    glDeleteQueries(Impl::m_frameQueryCount, m_impl->m_frameQueries.data());
 }
 
 void bee::Renderer::Impl::CreateFrameBuffers()
@@ -323,8 +380,12 @@ void bee::Renderer::Impl::DeleteFrameBuffers()
 
 void bee::Renderer::Impl::DeleteShadowMaps()
 {
-    glDeleteTextures(6, m_shadowMaps.data());
-    glDeleteFramebuffers(6, m_shadowFBOs.data());
+    glDeleteTextures(static_cast<GLsizei>(m_shadowMaps.size()), m_shadowMaps.data());
+    glDeleteFramebuffers(static_cast<GLsizei>(m_shadowFBOs.size()), m_shadowFBOs.data());
+    glDeleteTextures(static_cast<GLsizei>(m_staticShadowMaps.size()), m_staticShadowMaps.data());
+    glDeleteFramebuffers(static_cast<GLsizei>(m_staticShadowFBOs.size()), m_staticShadowFBOs.data());
+
+    for (auto& cache : m_shadowCache) cache.valid = false;
 }
 
 void bee::Renderer::SetAmbientFactor(float ambientFactor) {
@@ -332,12 +393,12 @@ void bee::Renderer::SetAmbientFactor(float ambientFactor) {
     m_impl->m_CameraDataUBO.Patch();
 }
 
-void bee::Renderer::QueueMesh(const glm::mat4& transform, ResourceHandle<Mesh> mesh, ResourceHandle<Material> material, MeshRenderer* meshRenderer)
+void bee::Renderer::QueueMesh(const glm::mat4& transform, ResourceHandle<Mesh> mesh, ResourceHandle<Material> material, MeshRenderer* meshRenderer, bool dynamicShadowCaster)
 {
     //Avoid invalid handles from being submitted
     if (auto mesh_ptr = mesh.Retrieve()) if (auto mat_ptr = material.Retrieve()) {
         m_objectsToDraw.emplace_back(
-            ObjectInfo { transform, mesh_ptr, mat_ptr, meshRenderer }
+            ObjectInfo { transform, mesh_ptr, mat_ptr, meshRenderer, dynamicShadowCaster }
         );
     }
 }
@@ -349,6 +410,11 @@ void bee::Renderer::QueueLight(const glm::mat4& transform, const Light& light)
     );
 }
 
+void bee::Renderer::QueueImpostor(const glm::mat4& transform, std::shared_ptr<ImpostorAtlas> atlas)
+{
+    if (atlas) m_impostorsToDraw.emplace_back(ImpostorInfo{ transform, atlas });
+}
+
 void bee::Renderer::SetFog(glm::vec4 fogColor, float fogNear, float fogFar)
 {
     m_impl->m_CameraDataUBO->bee_FogNear = fogNear;
@@ -360,21 +426,38 @@ void bee::Renderer::SetFog(glm::vec4 fogColor, float fogNear, float fogFar)
 void bee::Renderer::SetSkybox(ResourceHandle<Image> skyboxImage)
 {
     m_skybox = std::make_unique<Skybox>(skyboxImage, Engine.ShaderDB()[ShaderDB::Type::SKYBOX]);
-    m_ibl->Render(m_skybox->GetSkyboxCubemap(), m_modelRenderer->GetIBL());
+
+    // Skyboxes loaded from an asset are filtered once, later runs load the maps from the IBL cache
+    uint64_t sourceHash = 0;
+    const std::string path = skyboxImage.GetPath();
+    if (!path.empty() && Engine.FileIO().Exists(FileIO::Directory::Asset, path))
+    {
+        const std::vector<char> source = Engine.FileIO().ReadBinaryFile(FileIO::Directory::Asset, path);
+        sourceHash = HashBytes(source.data(), source.size());
+    }
+
+    m_ibl->Render(m_skybox->GetSkyboxCubemap(), m_modelRenderer->GetIBL(), sourceHash);
 }
 
 void bee::Renderer::Impl::CreateShadowMaps()
+{
+    // The sampled shadow maps and a persistent copy holding only the static casters
+    CreateShadowMapArrays(m_shadowMaps, m_shadowFBOs, "[R] Shadow Map");
+    CreateShadowMapArrays(m_staticShadowMaps, m_staticShadowFBOs, "[R] Static Shadow Map");
+}
+
+void bee::Renderer::Impl::CreateShadowMapArrays(std::array<unsigned int, m_maxDirLights>& maps, std::array<unsigned int, m_maxDirLights * MAX_SHADOW_CASCADES>& fbos, const std::string& label)
 {
     for (int i = 0; i < m_maxDirLights; i++)
     {
         const int size = m_shadowResolution;
 
         // Shadows being made
-        glGenTextures(1, &m_shadowMaps[i]);
-        glBindTexture(GL_TEXTURE_2D_ARRAY, m_shadowMaps[i]);
-        LabelGL(GL_TEXTURE, m_shadowMaps[i], ("[R] Shadow Map" + std::to_string(i)).c_str());
+        glGenTextures(1, &maps[i]);
+        glBindTexture(GL_TEXTURE_2D_ARRAY, maps[i]);
+        LabelGL(GL_TEXTURE, maps[i], (label + std::to_string(i)).c_str());
 
-        glTexImage3D(GL_TEXTURE_2D_ARRAY, 0, GL_DEPTH_COMPONENT32F, size, size, int(m_shadowCascadeLevels.size()) + 1, 
+        glTexImage3D(GL_TEXTURE_2D_ARRAY, 0, GL_DEPTH_COMPONENT32F, size, size, int(MAX_SHADOW_CASCADES) + 1, 
             0, GL_DEPTH_COMPONENT, GL_FLOAT, nullptr);
 
         glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
@@ -386,13 +469,13 @@ void bee::Renderer::Impl::CreateShadowMaps()
         float borderColor[] = {1.0, 1.0, 1.0, 1.0};
         glTexParameterfv(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_BORDER_COLOR, borderColor);
 
-        auto numOfCascades = m_shadowCascadeLevels.size();
+        auto numOfCascades = MAX_SHADOW_CASCADES;
         for (size_t j = 0; j < numOfCascades; j++)
         {
-            glGenFramebuffers(1, &m_shadowFBOs[i * numOfCascades + j]);
-            glBindFramebuffer(GL_FRAMEBUFFER, m_shadowFBOs[i * numOfCascades + j]);
-            LabelGL(GL_FRAMEBUFFER, m_shadowFBOs[i * numOfCascades + j], ("[R] Shadow Map FBO" + std::to_string(i * numOfCascades + j)).c_str());
-            glFramebufferTextureLayer(GL_FRAMEBUFFER, GL_DEPTH_ATTACHMENT, m_shadowMaps[i], 0, j);
+            glGenFramebuffers(1, &fbos[i * numOfCascades + j]);
+            glBindFramebuffer(GL_FRAMEBUFFER, fbos[i * numOfCascades + j]);
+            LabelGL(GL_FRAMEBUFFER, fbos[i * numOfCascades + j], (label + " FBO" + std::to_string(i * numOfCascades + j)).c_str());
+            glFramebufferTextureLayer(GL_FRAMEBUFFER, GL_DEPTH_ATTACHMENT, maps[i], 0, j);
             // Check that our framebuffer is OK
             if (glCheckFramebufferStatus(GL_FRAMEBUFFER) != GL_FRAMEBUFFER_COMPLETE) assert(false);
         }
@@ -402,15 +485,93 @@ void bee::Renderer::Impl::CreateShadowMaps()
     }
 }
 
+void bee::Renderer::Impl::UploadLightClusters()
+{
+    PushDebugGL("Upload light clusters");
+
+    // Storage buffers can not be empty when bound, so always upload at least one element
+    const auto upload = [](GLuint buffer, GLuint binding, const void* data, size_t size)
+    {
+        static const uint32_t empty[4] = {};
+        glNamedBufferData(buffer, size > 0 ? size : sizeof(empty), size > 0 ? data : empty, GL_DYNAMIC_DRAW);
+        glBindBufferBase(GL_SHADER_STORAGE_BUFFER, binding, buffer);
+    };
+
+    const auto& clusters = m_lightClusters.Clusters();
+    const auto& indices = m_lightClusters.LightIndices();
+
+    upload(m_pointLightsSSBO, POINT_LIGHTS_SSBO_LOCATION, m_pointLights.data(), m_pointLights.size() * sizeof(point_light_struct));
+    upload(m_lightClustersSSBO, LIGHT_CLUSTERS_SSBO_LOCATION, clusters.data(), clusters.size() * sizeof(glm::uvec2));
+    upload(m_lightIndicesSSBO, LIGHT_INDICES_SSBO_LOCATION, indices.data(), indices.size() * sizeof(uint32_t));
+
+    PopDebugGL();
+}
+
 void bee::Renderer::Impl::RenderShadowMaps(TerrainRenderer& terrainRenderer, Uniform<TransformsUBO>& instanceBuffer, 
     const std::vector<ObjectInfo>& objectsToDraw, 
-    const std::vector<LightInfo>& lightsToDraw, const Camera& camera)
+    const std::vector<LightInfo>& lightsToDraw, const Camera& camera, const CascadeSettings& settings, bool useCache)
 {
- 
+    if (static_cast<int>(settings.resolution) != m_shadowResolution)
+    {
+        DeleteShadowMaps();
+        m_shadowResolution = static_cast<int>(settings.resolution);
+        CreateShadowMaps();
+    }
+
+    // Split the casters, keeping the material/mesh order for instancing.
+    // The signature hashes the transform and mesh of every static caster. The per caster hashes are summed, as the
+    // draw sort is not stable and equal keys can swap places between frames.
+    m_staticCasters.clear();
+    m_dynamicCasters.clear();
+    uint64_t staticSignature = 0;
+
+    glm::vec3 casterMin = glm::vec3(std::numeric_limits<float>::max());
+    glm::vec3 casterMax = glm::vec3(std::numeric_limits<float>::lowest());
+    terrainRenderer.GetBounds(casterMin, casterMax);
+
+    for (auto& object : objectsToDraw)
+    {
+        const BoundingBox bounds = object.mesh->bounds.ApplyTransform(object.transform);
+        casterMin = glm::min(casterMin, bounds.GetStart());
+        casterMax = glm::max(casterMax, bounds.GetEnd());
+
+        if (object.dynamicShadowCaster)
+        {
+            m_dynamicCasters.push_back(object);
+            continue;
+        }
+
+        m_staticCasters.push_back(object);
+        const Mesh* mesh = object.mesh.get();
+        staticSignature += HashBytes(&mesh, sizeof(mesh), HashBytes(&object.transform, sizeof(object.transform)));
+    }
+    const size_t staticCount = m_staticCasters.size();
+    staticSignature = HashBytes(&staticCount, sizeof(staticCount), staticSignature);
+
+    if (glm::all(glm::lessThanEqual(casterMin, casterMax)))
+    {
+        casterMin = glm::floor(casterMin / m_shadowBoundsGrid) * m_shadowBoundsGrid;
+        casterMax = glm::ceil(casterMax / m_shadowBoundsGrid) * m_shadowBoundsGrid;
+    }
+
+    CascadeCamera cascadeCamera{};
+    cascadeCamera.inverseView = glm::inverse(camera.GetView());
+    cascadeCamera.fieldOfView = camera.GetFOV();
+    cascadeCamera.aspectRatio = camera.GetAspectRatio();
+    cascadeCamera.nearPlane = camera.GetNearPlane();
+    cascadeCamera.farPlane = camera.GetFarPlane();
+
+    const auto numOfCascades = MAX_SHADOW_CASCADES;
+    const int size = m_shadowResolution;
+
+    m_shadowCascadeCount = glm::clamp(settings.cascadeCount, 1u, MAX_SHADOW_CASCADES);
+
     uint32_t lightIndex = 0;
     for (auto& entry : lightsToDraw) {
-        std::string debugLabel = "Shadow pass #" + std::to_string(lightIndex);
-        PushDebugGL(debugLabel);
+
+        //Early out
+        if (entry.light.Type != Light::Type::Directional) 
+            continue;
 
         //Early out
         if (lightIndex >= MAX_DIRECTIONAL_LIGHTS) {
@@ -418,63 +579,113 @@ void bee::Renderer::Impl::RenderShadowMaps(TerrainRenderer& terrainRenderer, Uni
             break;
         }
 
-        //Early out
-        if (entry.light.Type != Light::Type::Directional || entry.light.CastShadows == false) 
+        // Keep the index in sync with the directional light uniforms
+        if (entry.light.CastShadows == false) {
+            m_shadowMatrices[lightIndex].fill(m_noShadowMatrix);
+            lightIndex++;
             continue;
+        }
 
-        //Area that the shadow map covers
+        std::string debugLabel = "Shadow pass #" + std::to_string(lightIndex);
+        PushDebugGL(debugLabel);
+
+        // Small light movements are ignored, the previous direction is kept until it turned beyond the threshold
         glm::vec3 lightDir = entry.transform * glm::vec4(0.0f, 0.0f, 1.0f, 0.0f);
-        const auto lightMatrices = GetLightSpaceMatrices(camera, lightDir, m_shadowCascadeLevels);
+        auto& cascadeLightDir = m_shadowLightDirections[lightIndex];
+        if (glm::dot(lightDir, cascadeLightDir) < m_shadowLightThreshold)
+            cascadeLightDir = lightDir;
+
+        const auto cascades = FitCascades(cascadeCamera, cascadeLightDir, casterMin, casterMax, settings);
 
-        auto numOfCascades = m_shadowCascadeLevels.size();
-        for (size_t i = 0; i < numOfCascades; i++)
+        m_shadowMatrices[lightIndex].fill(m_noShadowMatrix);
+        for (size_t i = 0; i < m_shadowCascadeCount; i++)
         {
-            m_CameraDataUBO->bee_viewProjection = lightMatrices[i];
+            auto& cache = m_shadowCache[lightIndex * numOfCascades + i];
+
+            const glm::mat4 lightMatrix = cascades[i].viewProjection;
+            m_shadowMatrices[lightIndex][i] = lightMatrix;
+            m_shadowCascadeLevels[i] = cascades[i].farSplit;
+
+            // The matrix changes whenever the cascade bounds do: a snap step of the center, a new depth range from the
+            // caster bounds or a turned light. Snapping stays at the configured few texels, so the cache serves a
+            // still or slow camera and the far cascades with their large texels, without giving up resolution.
+            const bool redrawStatic = !useCache || !cache.valid || cache.matrix != lightMatrix || cache.staticSignature != staticSignature;
+
+            m_CameraDataUBO->bee_viewProjection = lightMatrix;
             m_CameraDataUBO.Patch();
 
-            Engine.ShaderDB()[ShaderDB::Type::SHADOW]->Activate();
-            glViewport(0, 0, m_shadowResolution, m_shadowResolution);
-            glBindFramebuffer(GL_FRAMEBUFFER, m_shadowFBOs[lightIndex * numOfCascades + i]);
-            glClearColor(0.0f, 0.0f, 0.0f, 0.0f);
-            glClear(GL_DEPTH_BUFFER_BIT);
+            glViewport(0, 0, size, size);
             glCullFace(GL_FRONT);
             glEnable(GL_CULL_FACE);
             glEnable(GL_DEPTH_TEST);
 
-            //Traverse the list, collecting transforms and instancing all meshes
-            size_t draw_ptr = 0;
-            while (draw_ptr < objectsToDraw.size()) {
+            if (redrawStatic)
+            {
+                glBindFramebuffer(GL_FRAMEBUFFER, useCache ? m_staticShadowFBOs[lightIndex * numOfCascades + i] : m_shadowFBOs[lightIndex * numOfCascades + i]);
+                glClearColor(0.0f, 0.0f, 0.0f, 0.0f);
+                glClear(GL_DEPTH_BUFFER_BIT);
 
-                auto batch_mesh = objectsToDraw.at(draw_ptr).mesh;
+                Engine.ShaderDB()[ShaderDB::Type::SHADOW]->Activate();
+                RenderShadowCasters(instanceBuffer, m_staticCasters);
+                terrainRenderer.DepthOnlyRender(Engine.ShaderDB()[ShaderDB::Type::TERRAIN_SHADOW]);
 
-                size_t instanceCount = 0;
-                for (size_t lookPtr = draw_ptr; lookPtr < objectsToDraw.size() && instanceCount < MAX_TRANSFORM_INSTANCES; ++lookPtr) {
-                    auto& nextElement = objectsToDraw.at(lookPtr);
+                cache.matrix = lightMatrix;
+                cache.staticSignature = staticSignature;
+                cache.valid = useCache;
+            }
 
-                    if (nextElement.mesh != batch_mesh) break;
+            // Reset the sampled map to the static casters, unless it still holds exactly that
+            if (useCache && (redrawStatic || cache.hasDynamicCasters || !m_dynamicCasters.empty()))
+            {
+                glCopyImageSubData(
+                    m_staticShadowMaps[lightIndex], GL_TEXTURE_2D_ARRAY, 0, 0, 0, static_cast<GLint>(i),
+                    m_shadowMaps[lightIndex], GL_TEXTURE_2D_ARRAY, 0, 0, 0, static_cast<GLint>(i),
+                    size, size, 1);
+            }
 
-                    instanceBuffer->bee_transforms[instanceCount].world = nextElement.transform;
-                    instanceCount++;
-                }
+            if (!m_dynamicCasters.empty())
+            {
+                glBindFramebuffer(GL_FRAMEBUFFER, m_shadowFBOs[lightIndex * numOfCascades + i]);
+                Engine.ShaderDB()[ShaderDB::Type::SHADOW]->Activate();
+                RenderShadowCasters(instanceBuffer, m_dynamicCasters);
+            }
+            cache.hasDynamicCasters = !m_dynamicCasters.empty();
+        }
+        lightIndex++;
+        PopDebugGL();
+    }
+    glCullFace(GL_BACK);
+}
 
-                
-                // Render instances.
-                instanceBuffer.Patch();
+void bee::Renderer::Impl::RenderShadowCasters(Uniform<TransformsUBO>& instanceBuffer, const std::vector<ObjectInfo>& casters)
+{
+    //Traverse the list, collecting transforms and instancing all meshes
+    size_t draw_ptr = 0;
+    while (draw_ptr < casters.size()) {
 
-                Material::ApplyAlbedo(objectsToDraw.at(draw_ptr).material);
+        auto batch_mesh = casters.at(draw_ptr).mesh;
 
-                glBindVertexArray(batch_mesh->vao_handle);
-                glDrawElementsInstanced(GL_TRIANGLES, batch_mesh->index_count, batch_mesh->index_format, nullptr, static_cast<GLsizei>(instanceCount));
+        size_t instanceCount = 0;
+        for (size_t lookPtr = draw_ptr; lookPtr < casters.size() && instanceCount < MAX_TRANSFORM_INSTANCES; ++lookPtr) {
+            auto& nextElement = casters.at(lookPtr);
 
-                draw_ptr += instanceCount;
-            }
+            if (nextElement.mesh != batch_mesh) break;
 
-            terrainRenderer.DepthOnlyRender(Engine.ShaderDB()[ShaderDB::Type::TERRAIN_SHADOW]);
+            instanceBuffer->bee_transforms[instanceCount].world = nextElement.transform;
+            instanceCount++;
         }
-        lightIndex++;
-        PopDebugGL();
+
+        
+        // Render instances.
+        instanceBuffer.Patch();
+
+        Material::ApplyAlbedo(casters.at(draw_ptr).material);
+
+        glBindVertexArray(batch_mesh->vao_handle);
+        glDrawElementsInstanced(GL_TRIANGLES, batch_mesh->index_count, batch_mesh->index_format, nullptr, static_cast<GLsizei>(instanceCount));
+
+        draw_ptr += instanceCount;
     }
-    glCullFace(GL_BACK);
 }
 
 void* bee::Renderer::GetOutputFramebuffer()
@@ -489,6 +700,20 @@ void bee::Renderer::SetScreenBlit(bool value)
 
 void bee::Renderer::Render()
 {
+    // Read back the oldest frame query before reusing it, a result that is not in yet is skipped
+    const GLuint frameQuery = m_impl->m_frameQueries[m_impl->m_frameQueryIndex];
+    if (m_impl->m_frameQueriesIssued >= Impl::m_frameQueryCount)
+    {
+        GLint available = 0;
+        glGetQueryObjectiv(frameQuery, GL_QUERY_RESULT_AVAILABLE, &available);
+        if (available)
+        {
+            GLuint64 elapsed = 0;
+            glGetQueryObjectui64v(frameQuery, GL_QUERY_RESULT, &elapsed);
+            m_gpuFrameTime = static_cast<float>(elapsed) * 1e-6f;
+        }
+    }
+    glBeginQuery(GL_TIME_ELAPSED, frameQuery);
 
     //Pick the first camera (TODO: add option to set a camera or a camera entity)
     auto cameraView = Engine.ECS().Registry.view<Transform, CameraComponent>();
@@ -542,7 +767,7 @@ void bee::Renderer::Render()
 
     // 2. Render to shadow maps
     // TODO: Find better way to communicate instance buffer.
-    m_impl->RenderShadowMaps(*m_terrainRenderer, *static_cast<Uniform<TransformsUBO>*>(m_modelRenderer->InstancedTransformBuffer()), m_objectsToDraw, m_lightsToDraw, frameCamera);
+    m_impl->RenderShadowMaps(*m_terrainRenderer, *static_cast<Uniform<TransformsUBO>*>(m_modelRenderer->InstancedTransformBuffer()), m_objectsToDraw, m_lightsToDraw, frameCamera, m_cascadeSettings, m_shadowCaching);
 
     //MSAA Framebuffer
     glBindFramebuffer(GL_FRAMEBUFFER, m_impl->m_msaaFramebuffer);
@@ -556,7 +781,8 @@ void bee::Renderer::Render()
     glEnable(GL_CULL_FACE);
 
     size_t dir_lights = 0;
-    size_t point_lights = 0;
+    m_impl->m_pointLights.clear();
+    m_impl->m_pointLightViewSpheres.clear();
 
     // 3. Update light and shadow matrix uniforms
     for (auto& entry : m_lightsToDraw) {
@@ -579,10 +805,10 @@ void bee::Renderer::Render()
             uniform_index.direction = lightDir;
             uniform_index.intensity = entry.light.Intensity;
 
-            auto cascadeMatrices = GetLightSpaceMatrices(frameCamera, lightDir, m_impl->m_shadowCascadeLevels);
-            for (size_t i = 0; i < m_impl->m_shadowCascadeLevels.size(); i++)
+            // Sample with the exact matrices the (possibly cached) shadow maps were rendered with
+            for (size_t i = 0; i < m_impl->m_shadowMatrices[dir_lights].size(); i++)
             {
-                uniform_index.shadow_matrices[i] = cascadeMatrices[i];
+                uniform_index.shadow_matrices[i] = m_impl->m_shadowMatrices[dir_lights][i];
             }
 
             dir_lights++;
@@ -591,19 +817,14 @@ void bee::Renderer::Render()
         case Light::Type::Point:
             {
 
-            if (point_lights++ > MAX_POINT_LIGHT_INSTANCES) {
-                Log::Warn("Exceeding max point light uniforms");
-                break;
-            }
-
-            auto& uniform_index = m_impl->m_PointLightUBO->bee_point_lights[point_lights];
+            auto& pointLight = m_impl->m_pointLights.emplace_back();
 
-            uniform_index.color = entry.light.Color;
-            uniform_index.intensity = entry.light.Intensity;
-            uniform_index.position = entry.transform[3];
-            uniform_index.range = entry.light.Range;
+            pointLight.color = entry.light.Color;
+            pointLight.intensity = entry.light.Intensity;
+            pointLight.position = entry.transform[3];
+            pointLight.range = entry.light.Range;
 
-            point_lights++;
+            m_impl->m_pointLightViewSpheres.emplace_back(glm::vec3(view * entry.transform[3]), entry.light.Range);
             }
             break;
         default:
@@ -612,11 +833,11 @@ void bee::Renderer::Render()
         }
     }
 
-    m_impl->m_PointLightUBO.Patch();
     m_impl->m_DirectionalLightUBO.Patch();
 
-    m_impl->m_PointLightUBO.Patch();
-    m_impl->m_DirectionalLightUBO.Patch();
+    // 4. Bin point lights into clusters
+    m_impl->m_lightClusters.Build(m_impl->m_pointLightViewSpheres, projection, frameCamera.GetNearPlane(), frameCamera.GetFarPlane(), &Engine.ThreadPool());
+    m_impl->UploadLightClusters();
 
     //Camera UBO
 
@@ -628,15 +849,17 @@ void bee::Renderer::Render()
     m_impl->m_CameraDataUBO->bee_viewProjection = projection * view;
     m_impl->m_CameraDataUBO->bee_eyePos = eyePos;
     m_impl->m_CameraDataUBO->bee_directionalLightsCount = static_cast<int>(dir_lights);
-    m_impl->m_CameraDataUBO->bee_pointLightsCount = static_cast<int>(point_lights);
+    m_impl->m_CameraDataUBO->bee_pointLightsCount = static_cast<int>(m_impl->m_pointLights.size());
     m_impl->m_CameraDataUBO->bee_resolution = glm::vec2(static_cast<float>(Engine.Device().GetWidth()), 
                                                         static_cast<float>(Engine.Device().GetHeight()));
-    m_impl->m_CameraDataUBO->bee_cascadeCount = m_impl->m_shadowCascadeLevels.size();
-    for (size_t i = 0; i < m_impl->m_shadowCascadeLevels.size(); i++)
+    m_impl->m_CameraDataUBO->bee_cascadeCount = m_impl->m_shadowCascadeCount;
+    for (size_t i = 0; i < m_impl->m_shadowCascadeCount; i++)
     {
         m_impl->m_CameraDataUBO->bee_cascadePlaneDistances[i].x = m_impl->m_shadowCascadeLevels.at(i);
     }
     m_impl->m_CameraDataUBO->bee_farPlane = frameCamera.GetFarPlane();
+    m_impl->m_CameraDataUBO->bee_clusterSliceScale = m_impl->m_lightClusters.SliceScale();
+    m_impl->m_CameraDataUBO->bee_clusterSliceBias = m_impl->m_lightClusters.SliceBias();
 
     m_impl->m_CameraDataUBO.Patch();
 
@@ -653,10 +876,10 @@ void bee::Renderer::Render()
     if (m_skybox) m_skybox->Render();
 
     // 7. Render terrain
-    m_terrainRenderer->Render();
+    m_terrainRenderer->Render(frameCamera);
 
     // 8. Render grass
-    m_grassRenderer->Render();
+    m_grassRenderer->Render(frameCamera);
 
     //Object frustum culling
 
@@ -676,10 +899,28 @@ void bee::Renderer::Render()
 
     m_objectsToDraw = visibleObjects;
 
-    // 9. Render standard models.
+    std::vector<ImpostorInfo> visibleImpostors;
+    visibleImpostors.reserve(m_impostorsToDraw.size());
+
+    for (auto& impostor : m_impostorsToDraw)
+    {
+        auto aabb = BoundingBox(impostor.atlas->center, glm::vec3(impostor.atlas->radius)).ApplyTransform(impostor.transform);
+        if (aabb.FrustumTest(frustumPlanes))
+        {
+            visibleImpostors.push_back(impostor);
+        }
+    }
+
+    // Impostors are batched per atlas
+    std::sort(visibleImpostors.begin(), visibleImpostors.end(),
+        [](const ImpostorInfo& lhs, const ImpostorInfo& rhs) { return lhs.atlas.get() < rhs.atlas.get(); });
+
+    // 9. Render standard models and impostors of distant models.
     m_modelRenderer->Render(m_objectsToDraw, m_lightsToDraw);
+    m_impostorRenderer->Render(visibleImpostors);
     m_objectsToDraw.clear();
     m_lightsToDraw.clear();
+    m_impostorsToDraw.clear();
 
     // 10. Resolve MSAA into HDR
     PushDebugGL("Resolve MSAA");
@@ -732,4 +973,8 @@ void bee::Renderer::Render()
         glDrawBuffer(GL_BACK);
         glBlitFramebuffer(0, 0, m_impl->m_width, m_impl->m_height, 0, 0, m_impl->m_width, m_impl->m_height, GL_COLOR_BUFFER_BIT, GL_NEAREST);
     }
+
+    glEndQuery(GL_TIME_ELAPSED);
+    m_impl->m_frameQueryIndex = (m_impl->m_frameQueryIndex + 1) % Impl::m_frameQueryCount;
+    m_impl->m_frameQueriesIssued++;
 }
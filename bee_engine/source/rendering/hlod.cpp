@@ -0,0 +1,175 @@
+#include <precompiled/engine_precompiled.hpp>
+#include "rendering/hlod.hpp"
+
+#include "math/geometry.hpp"
+
+glm::ivec2 bee::HLODCellCoordinate(glm::vec3 position, float cellSize)
+{
+    return glm::ivec2(glm::floor(glm::vec2(position.x, position.y) / cellSize));
+}
+
+glm::vec4 bee::HLODAtlasTileRect(uint32_t tileIndex, uint32_t tilesPerSide, uint32_t tileSize)
+{
+    const float atlasSize = static_cast<float>(tilesPerSide * tileSize);
+    const glm::vec2 tile = glm::vec2(tileIndex % tilesPerSide, tileIndex / tilesPerSide);
+
+    // Inset by a texel so bilinear filtering does not bleed into the neighbouring tile
+    const glm::vec2 offset = (tile * static_cast<float>(tileSize) + 1.0f) / atlasSize;
+    const glm::vec2 scale = glm::vec2(static_cast<float>(tileSize) - 2.0f) / atlasSize;
+    return glm::vec4(offset, scale);
+}
+
+void bee::HLODAppendMesh(MeshLoader::MeshData& dst, const MeshLoader::MeshData& src, const glm::mat4& transform, glm::vec4 uvRect)
+{
+    const uint32_t baseVertex = static_cast<uint32_t>(dst.positions.size() / 3);
+    const size_t vertexCount = src.positions.size() / 3;
+    const glm::mat3 normalMatrix = glm::transpose(glm::inverse(glm::mat3(transform)));
+
+    dst.positions.reserve(dst.positions.size() + vertexCount * 3);
+    dst.normals.reserve(dst.normals.size() + vertexCount * 3);
+    dst.texture_uvs.reserve(dst.texture_uvs.size() + vertexCount * 2);
+
+    for (size_t i = 0; i < vertexCount; i++)
+    {
+        const glm::vec3 position = transform * glm::vec4(src.positions[i * 3], src.positions[i * 3 + 1], src.positions[i * 3 + 2], 1.0f);
+        dst.positions.insert(dst.positions.end(), { position.x, position.y, position.z });
+
+        glm::vec3 normal = World::UP;
+        if (src.normals.size() >= (i + 1) * 3)
+            normal = glm::normalize(normalMatrix * glm::vec3(src.normals[i * 3], src.normals[i * 3 + 1], src.normals[i * 3 + 2]));
+        dst.normals.insert(dst.normals.end(), { normal.x, normal.y, normal.z });
+
+        glm::vec2 uv = glm::vec2(0.5f);
+        if (src.texture_uvs.size() >= (i + 1) * 2)
+            uv = glm::clamp(glm::vec2(src.texture_uvs[i * 2], src.texture_uvs[i * 2 + 1]), 0.0f, 1.0f);
+        uv = glm::vec2(uvRect.x, uvRect.y) + uv * glm::vec2(uvRect.z, uvRect.w);
+        dst.texture_uvs.insert(dst.texture_uvs.end(), { uv.x, uv.y });
+    }
+
+    dst.indices.reserve(dst.indices.size() + src.indices.size());
+    for (auto index : src.indices)
+        dst.indices.push_back(baseVertex + index);
+}
+
+void bee::HLODSimplify(MeshLoader::MeshData& mesh, const std::vector<uint32_t>& tileIds, float gridSize)
+{
+    const size_t vertexCount = mesh.positions.size() / 3;
+    if (gridSize <= 0.0f || vertexCount == 0) return;
+    assert(tileIds.size() == vertexCount);
+
+    struct ClusterKey
+    {
+        glm::ivec3 cell;
+        uint32_t tile;
+        bool operator==(const ClusterKey& other) const { return cell == other.cell && tile == other.tile; }
+    };
+
+    struct ClusterKeyHash
+    {
+        size_t operator()(const ClusterKey& key) const
+        {
+            size_t hash = std::hash<int>()(key.cell.x);
+            hash = hash * 31 + std::hash<int>()(key.cell.y);
+            hash = hash * 31 + std::hash<int>()(key.cell.z);
+            return hash * 31 + std::hash<uint32_t>()(key.tile);
+        }
+    };
+
+    struct Cluster
+    {
+        glm::vec3 position{ 0.0f };
+        glm::vec3 normal{ 0.0f };
+        glm::vec2 uv{ 0.0f };
+        uint32_t count = 0;
+    };
+
+    std::unordered_map<ClusterKey, uint32_t, ClusterKeyHash> clusterLookup;
+    std::vector<Cluster> clusters;
+    std::vector<uint32_t> remap(vertexCount);
+
+    for (size_t i = 0; i < vertexCount; i++)
+    {
+        const glm::vec3 position = glm::vec3(mesh.positions[i * 3], mesh.positions[i * 3 + 1], mesh.positions[i * 3 + 2]);
+        const ClusterKey key { glm::ivec3(glm::floor(position / gridSize)), tileIds[i] };
+
+        auto [it, inserted] = clusterLookup.emplace(key, static_cast<uint32_t>(clusters.size()));
+        if (inserted) clusters.emplace_back();
+
+        Cluster& cluster = clusters[it->second];
+        cluster.position += position;
+        cluster.normal += glm::vec3(mesh.normals[i * 3], mesh.normals[i * 3 + 1], mesh.normals[i * 3 + 2]);
+        cluster.uv += glm::vec2(mesh.texture_uvs[i * 2], mesh.texture_uvs[i * 2 + 1]);
+        cluster.count++;
+
+        remap[i] = it->second;
+    }
+
+    std::vector<uint32_t> indices;
+    indices.reserve(mesh.indices.size());
+    for (size_t i = 0; i + 2 < mesh.indices.size(); i += 3)
+    {
+        const uint32_t a = remap[mesh.indices[i]];
+        const uint32_t b = remap[mesh.indices[i + 1]];
+        const uint32_t c = remap[mesh.indices[i + 2]];
+
+        // Collapsed into a line or a point
+        if (a == b || b == c || a == c) continue;
+
+        indices.insert(indices.end(), { a, b, c });
+    }
+
+    mesh.positions.clear();
+    mesh.normals.clear();
+    mesh.texture_uvs.clear();
+    mesh.tangents.clear();
+    mesh.positions.reserve(clusters.size() * 3);
+    mesh.normals.reserve(clusters.size() * 3);
+    mesh.texture_uvs.reserve(clusters.size() * 2);
+
+    for (const auto& cluster : clusters)
+    {
+        const float weight = 1.0f / static_cast<float>(cluster.count);
+        const glm::vec3 position = cluster.position * weight;
+        const glm::vec3 normal = glm::length(cluster.normal) > 0.0001f ? glm::normalize(cluster.normal) : World::UP;
+        const glm::vec2 uv = cluster.uv * weight;
+
+        mesh.positions.insert(mesh.positions.end(), { position.x, position.y, position.z });
+        mesh.normals.insert(mesh.normals.end(), { normal.x, normal.y, normal.z });
+        mesh.texture_uvs.insert(mesh.texture_uvs.end(), { uv.x, uv.y });
+    }
+
+    mesh.indices = std::move(indices);
+}
+
+void bee::HLODWriteAtlasTile(std::vector<uint8_t>& atlas, uint32_t tilesPerSide, uint32_t tileSize, uint32_t tileIndex,
+    const uint8_t* pixels, uint32_t width, uint32_t height, glm::vec4 factor)
+{
+    const uint32_t atlasSize = tilesPerSide * tileSize;
+    assert(atlas.size() == static_cast<size_t>(atlasSize) * atlasSize * 4);
+
+    const uint32_t tileX = (tileIndex % tilesPerSide) * tileSize;
+    const uint32_t tileY = (tileIndex / tilesPerSide) * tileSize;
+
+    for (uint32_t y = 0; y < tileSize; y++)
+    {
+        for (uint32_t x = 0; x < tileSize; x++)
+        {
+            glm::vec4 colour = glm::vec4(1.0f);
+            if (pixels && width > 0 && height > 0)
+            {
+                const uint32_t sourceX = glm::min(x * width / tileSize, width - 1);
+                const uint32_t sourceY = glm::min(y * height / tileSize, height - 1);
+                const uint8_t* texel = pixels + (static_cast<size_t>(sourceY) * width + sourceX) * 4;
+                colour = glm::vec4(texel[0], texel[1], texel[2], texel[3]) / 255.0f;
+            }
+
+            colour = glm::clamp(colour * factor, 0.0f, 1.0f) * 255.0f + 0.5f;
+
+            uint8_t* target = atlas.data() + (static_cast<size_t>(tileY + y) * atlasSize + tileX + x) * 4;
+            target[0] = static_cast<uint8_t>(colour.r);
+            target[1] = static_cast<uint8_t>(colour.g);
+            target[2] = static_cast<uint8_t>(colour.b);
+            target[3] = static_cast<uint8_t>(colour.a);
+        }
+    }
+}
@@ -0,0 +1,327 @@
+#include "precompiled/engine_precompiled.hpp"
+
+#include "rendering/hlod.hpp"
+
+#include "core/engine.hpp"
+#include "math/geometry.hpp"
+#include "platform/opengl/open_gl.hpp"
+#include "resources/image/image_gl.hpp"
+#include "resources/image/image_loader.hpp"
+#include "resources/material/material.hpp"
+#include "resources/material/material_builder.hpp"
+#include "resources/mesh/mesh_common.hpp"
+#include "resources/mesh/mesh_gl.hpp"
+#include "resources/resource_manager.hpp"
+#include <tools/log.hpp>
+#include <tools/tools.hpp>
+
+namespace
+{
+
+constexpr uint32_t HLOD_CACHE_MAGIC = 0x444C4842;  // "BHLD"
+// Bump when the way proxies are baked changes, so old cache files are rebaked
+constexpr uint32_t HLOD_CACHE_VERSION = 1;
+
+// File layout: header, indices, positions, normals and UVs, then the RGBA8 atlas without mips
+struct HLODCacheHeader
+{
+    uint32_t magic = HLOD_CACHE_MAGIC;
+    uint32_t version = HLOD_CACHE_VERSION;
+    uint32_t indexCount = 0;
+    uint32_t vertexCount = 0;
+    uint32_t atlasSize = 0;
+    uint32_t padding = 0;
+    glm::vec3 minBounds{ 0.0f };
+    glm::vec3 maxBounds{ 0.0f };
+};
+
+// A proxy before it is uploaded, as it is kept in the cache
+struct BakedProxy
+{
+    bee::MeshLoader::MeshData mesh;
+    std::vector<uint8_t> atlas;
+    uint32_t atlasSize = 0;
+    glm::vec3 minBounds{ 0.0f };
+    glm::vec3 maxBounds{ 0.0f };
+};
+
+std::string HLODCachePath(uint64_t key)
+{
+    return fmt::format("hlod_{:016x}.bin", key);
+}
+
+template <typename T>
+void AppendBytes(std::vector<char>& file, const std::vector<T>& values)
+{
+    const char* bytes = reinterpret_cast<const char*>(values.data());
+    file.insert(file.end(), bytes, bytes + sizeof(T) * values.size());
+}
+
+template <typename T>
+bool ReadBytes(const std::vector<char>& file, size_t& offset, std::vector<T>& values, size_t count)
+{
+    if (offset + sizeof(T) * count > file.size()) return false;
+    values.resize(count);
+    std::memcpy(values.data(), file.data() + offset, sizeof(T) * count);
+    offset += sizeof(T) * count;
+    return true;
+}
+
+bool ReadCachedProxy(const std::string& path, BakedProxy& proxy)
+{
+    auto& fileIO = bee::Engine.FileIO();
+    if (!fileIO.Exists(bee::FileIO::Directory::Save, path)) return false;
+
+    const std::vector<char> file = fileIO.ReadBinaryFile(bee::FileIO::Directory::Save, path);
+
+    HLODCacheHeader header{};
+    if (file.size() < sizeof(header)) return false;
+    std::memcpy(&header, file.data(), sizeof(header));
+
+    const HLODCacheHeader expected{};
+    if (header.magic != expected.magic || header.version != expected.version)
+    {
+        bee::Log::Info("HLOD cache {} is outdated, rebaking it", path);
+        return false;
+    }
+
+    size_t offset = sizeof(header);
+    const bool complete = ReadBytes(file, offset, proxy.mesh.indices, header.indexCount) &&
+        ReadBytes(file, offset, proxy.mesh.positions, static_cast<size_t>(header.vertexCount) * 3) &&
+        ReadBytes(file, offset, proxy.mesh.normals, static_cast<size_t>(header.vertexCount) * 3) &&
+        ReadBytes(file, offset, proxy.mesh.texture_uvs, static_cast<size_t>(header.vertexCount) * 2) &&
+        ReadBytes(file, offset, proxy.atlas, static_cast<size_t>(header.atlasSize) * header.atlasSize * 4);
+    if (!complete)
+    {
+        bee::Log::Warn("HLOD cache {} is truncated, rebaking it", path);
+        return false;
+    }
+
+    proxy.atlasSize = header.atlasSize;
+    proxy.minBounds = header.minBounds;
+    proxy.maxBounds = header.maxBounds;
+    return true;
+}
+
+void WriteCachedProxy(const std::string& path, const BakedProxy& proxy)
+{
+    HLODCacheHeader header{};
+    header.indexCount = static_cast<uint32_t>(proxy.mesh.indices.size());
+    header.vertexCount = static_cast<uint32_t>(proxy.mesh.positions.size() / 3);
+    header.atlasSize = proxy.atlasSize;
+    header.minBounds = proxy.minBounds;
+    header.maxBounds = proxy.maxBounds;
+
+    std::vector<char> file(sizeof(header));
+    std::memcpy(file.data(), &header, sizeof(header));
+    AppendBytes(file, proxy.mesh.indices);
+    AppendBytes(file, proxy.mesh.positions);
+    AppendBytes(file, proxy.mesh.normals);
+    AppendBytes(file, proxy.mesh.texture_uvs);
+    AppendBytes(file, proxy.atlas);
+
+    bee::Engine.FileIO().WriteBinaryFile(bee::FileIO::Directory::Save, path, file);
+}
+
+// Reads the mip level of an RGBA8 texture closest to (but not below) the requested size
+std::vector<uint8_t> ReadTextureForTile(const bee::Image& image, uint32_t tileSize, uint32_t& width, uint32_t& height)
+{
+    int level = 0;
+    width = image.width;
+    height = image.height;
+    while (width / 2 >= tileSize && height / 2 >= tileSize)
+    {
+        width = glm::max(width / 2, 1u);
+        height = glm::max(height / 2, 1u);
+        level++;
+    }
+
+    std::vector<uint8_t> pixels(static_cast<size_t>(width) * height * 4);
+    glBindTexture(GL_TEXTURE_2D, image.handle);
+    glPixelStorei(GL_PACK_ALIGNMENT, 1);
+    glGetTexImage(GL_TEXTURE_2D, level, GL_RGBA, GL_UNSIGNED_BYTE, pixels.data());
+    glBindTexture(GL_TEXTURE_2D, 0);
+    return pixels;
+}
+
+// Merges the sources and fills the atlas, false when nothing is left after simplification
+bool BakeProxy(const std::vector<bee::HLODSource>& sources, std::string_view name, const bee::HLODSettings& settings, BakedProxy& proxy)
+{
+    using namespace bee;
+
+    PushDebugGL("HLOD bake");
+
+    // Every unique material gets one tile in the atlas
+    std::vector<std::shared_ptr<Material>> materials;
+    std::vector<uint32_t> sourceTiles;
+    sourceTiles.reserve(sources.size());
+
+    for (const auto& source : sources)
+    {
+        auto material = source.material.Retrieve();
+        auto it = std::find(materials.begin(), materials.end(), material);
+        sourceTiles.push_back(static_cast<uint32_t>(it - materials.begin()));
+        if (it == materials.end()) materials.push_back(material);
+    }
+
+    const uint32_t tilesPerSide = static_cast<uint32_t>(glm::ceil(glm::sqrt(static_cast<float>(materials.size()))));
+    const uint32_t tileSize = settings.atlasTileSize;
+    const uint32_t atlasSize = tilesPerSide * tileSize;
+
+    std::vector<uint8_t>& atlasPixels = proxy.atlas;
+    atlasPixels.assign(static_cast<size_t>(atlasSize) * atlasSize * 4, 0);
+    proxy.atlasSize = atlasSize;
+    for (uint32_t tile = 0; tile < materials.size(); tile++)
+    {
+        const auto& material = materials[tile];
+        if (!material)
+        {
+            HLODWriteAtlasTile(atlasPixels, tilesPerSide, tileSize, tile, nullptr, 0, 0, glm::vec4(1.0f));
+            continue;
+        }
+
+        auto texture = material->UseBaseTexture ? material->BaseColorTexture.Retrieve() : nullptr;
+        if (texture)
+        {
+            uint32_t width = 0, height = 0;
+            auto pixels = ReadTextureForTile(*texture, tileSize, width, height);
+            HLODWriteAtlasTile(atlasPixels, tilesPerSide, tileSize, tile, pixels.data(), width, height, material->BaseColorFactor);
+        }
+        else
+        {
+            HLODWriteAtlasTile(atlasPixels, tilesPerSide, tileSize, tile, nullptr, 0, 0, material->BaseColorFactor);
+        }
+    }
+
+    // Merge everything into one world space mesh
+    MeshLoader::MeshData& merged = proxy.mesh;
+    std::vector<uint32_t> tileIds;
+
+    for (size_t i = 0; i < sources.size(); i++)
+    {
+        auto meshData = mesh_utils::ReadMeshData(sources[i].mesh);
+        const glm::vec4 uvRect = HLODAtlasTileRect(sourceTiles[i], tilesPerSide, tileSize);
+
+        HLODAppendMesh(merged, meshData, sources[i].transform, uvRect);
+        tileIds.resize(merged.positions.size() / 3, sourceTiles[i]);
+    }
+
+    const size_t originalTriangles = merged.indices.size() / 3;
+    HLODSimplify(merged, tileIds, settings.simplifyGridSize);
+
+    PopDebugGL();
+    if (merged.indices.empty()) return false;
+
+    proxy.minBounds = glm::vec3(std::numeric_limits<float>::max());
+    proxy.maxBounds = glm::vec3(std::numeric_limits<float>::lowest());
+    for (size_t i = 0; i < merged.positions.size(); i += 3)
+    {
+        const glm::vec3 position = glm::vec3(merged.positions[i], merged.positions[i + 1], merged.positions[i + 2]);
+        proxy.minBounds = glm::min(proxy.minBounds, position);
+        proxy.maxBounds = glm::max(proxy.maxBounds, position);
+    }
+
+    Log::Info("HLOD {}: {} meshes, {} -> {} triangles, {} atlas tiles",
+        name, sources.size(), originalTriangles, merged.indices.size() / 3, materials.size());
+    return true;
+}
+
+// Uploads the proxy mesh and atlas
+bee::HLODCluster CreateCluster(BakedProxy&& proxy, std::string_view name)
+{
+    using namespace bee;
+
+    HLODCluster cluster{};
+    cluster.minBounds = proxy.minBounds;
+    cluster.maxBounds = proxy.maxBounds;
+
+    const glm::vec3 extents = (cluster.maxBounds - cluster.minBounds) * 0.5f;
+    BoundingBox bounds(cluster.minBounds + extents, extents);
+    cluster.mesh = Engine.Resources().Meshes().FromRawData(name, std::move(proxy.mesh), bounds);
+
+    auto atlas = Engine.Resources().Images().FromRawData(proxy.atlas.data(), ImageFormat::RGBA8, proxy.atlasSize, proxy.atlasSize);
+
+    Sampler sampler{};
+    sampler.MinFilter = Sampler::Filter::LinearMipmapLinear;
+    sampler.MagFilter = Sampler::Filter::Linear;
+
+    // Distant proxies are lit as rough dielectrics, the atlas is already multiplied by the base colour factors
+    glm::vec4 metallicRoughness = glm::vec4(0.0f, 1.0f, 0.0f, 0.0f);
+    cluster.material = MaterialBuilder()
+        .WithName(std::string(name) + " Material")
+        .WithTexture(TextureSlotIndex::BASE_COLOR, atlas)
+        .WithSampler(TextureSlotIndex::BASE_COLOR, sampler)
+        .WithFactor(TextureSlotIndex::METALLIC_ROUGHNESS, metallicRoughness)
+        .DoubleSided(true)
+        .Build();
+
+    return cluster;
+}
+
+}
+
+uint64_t bee::HLODCellKey(const std::vector<HLODSource>& sources, const HLODSettings& settings)
+{
+    uint64_t key = HashBytes(&settings.cellSize, sizeof(settings.cellSize));
+    key = HashBytes(&settings.simplifyGridSize, sizeof(settings.simplifyGridSize), key);
+    key = HashBytes(&settings.atlasTileSize, sizeof(settings.atlasTileSize), key);
+
+    for (const auto& source : sources)
+    {
+        // Meshes are named after their model file and primitive, a mesh without a name cannot be told apart
+        const std::string meshPath = source.mesh.GetPath();
+        auto mesh = source.mesh.Retrieve();
+        if (meshPath.empty() || !mesh) return 0;
+
+        key = HashBytes(meshPath.data(), meshPath.size(), key);
+        const uint32_t counts[2] = { mesh->vertex_count, mesh->index_count };
+        key = HashBytes(counts, sizeof(counts), key);
+        key = HashBytes(&source.transform, sizeof(source.transform), key);
+
+        // Only the base colour ends up in the atlas
+        if (auto material = source.material.Retrieve())
+        {
+            key = HashBytes(&material->BaseColorFactor, sizeof(material->BaseColorFactor), key);
+            auto texture = material->UseBaseTexture ? material->BaseColorTexture.Retrieve() : nullptr;
+            if (texture)
+            {
+                const std::string texturePath = material->BaseColorTexture.GetPath();
+                const uint32_t size[2] = { texture->width, texture->height };
+                key = HashBytes(texturePath.data(), texturePath.size(), key);
+                key = HashBytes(size, sizeof(size), key);
+            }
+        }
+    }
+
+    // 0 means uncached
+    return key == 0 ? 1 : key;
+}
+
+bee::HLODCluster bee::BakeHLODCluster(const std::vector<HLODSource>& sources, std::string_view name, const HLODSettings& settings)
+{
+    BakedProxy proxy{};
+    if (sources.empty() || !BakeProxy(sources, name, settings, proxy)) return HLODCluster{};
+    return CreateCluster(std::move(proxy), name);
+}
+
+bee::HLODCluster bee::LoadOrBakeHLODCluster(const std::vector<HLODSource>& sources, std::string_view name, const HLODSettings& settings)
+{
+    if (sources.empty()) return HLODCluster{};
+
+    const uint64_t key = HLODCellKey(sources, settings);
+    if (key == 0) return BakeHLODCluster(sources, name, settings);
+
+    // Proxies are baked once per cell content and kept in the save directory, later loads only upload them
+    const std::string path = HLODCachePath(key);
+    BakedProxy proxy{};
+    if (!ReadCachedProxy(path, proxy))
+    {
+        proxy = BakedProxy{};
+        if (!BakeProxy(sources, name, settings, proxy)) return HLODCluster{};
+        WriteCachedProxy(path, proxy);
+    }
+
+    HLODCluster cluster = CreateCluster(std::move(proxy), name);
+    cluster.key = key;
+    return cluster;
+}
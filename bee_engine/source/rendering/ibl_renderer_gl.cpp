@@ -7,7 +7,16 @@
 #include "rendering/shader_db.hpp"
 #include "platform/opengl/uniforms_gl.hpp"
 #include "resources/image/image_gl.hpp"
+#include "resources/image/texture_cache_gl.hpp"
+#include "core/fileio.hpp"
 #include <tools/log.hpp>
+#include <tools/tools.hpp>
+
+namespace
+{
+// Bump when the filtering or the file layout changes, so stale cache files are not loaded
+constexpr uint32_t IBL_CACHE_VERSION = 2;
+}
 
 class bee::IBLRenderer::Impl
 {
@@ -16,6 +25,8 @@ public:
     void CreateSpecularIBL(std::shared_ptr<Image> specularIBL, std::shared_ptr<Image> envCubemap, uint32_t textureSize, uint32_t specularMipCount);
     void CreateLUTIBL(std::shared_ptr<Image> lutIBL, std::shared_ptr<Image> envCubemap, uint32_t textureSize);
 
+    GLuint m_lutHandle = 0;  // The LUT only depends on the settings, it is filled once per texture
+
     unsigned int m_captureFBO;
     unsigned int m_captureRBO;
 
@@ -35,17 +46,58 @@ bee::IBLRenderer::IBLRenderer() : m_impl(std::make_unique<Impl>())
     glFramebufferRenderbuffer(GL_FRAMEBUFFER, GL_DEPTH_ATTACHMENT, GL_RENDERBUFFER, m_impl->m_captureRBO);
 }
 
-void bee::IBLRenderer::Render(std::shared_ptr<Image> envCubemap, const Material::IBL& ibl)
+void bee::IBLRenderer::Render(std::shared_ptr<Image> envCubemap, const Material::IBL& ibl, uint64_t sourceHash)
 {
     auto t = std::chrono::high_resolution_clock::now();
 
+    const CachedTextureLayout diffuseLayout{ GL_TEXTURE_CUBE_MAP, GL_RGB16F, GL_RGB, GL_HALF_FLOAT, m_textureSizeDiffuse, 1 };
+    const CachedTextureLayout specularLayout{ GL_TEXTURE_CUBE_MAP, GL_RGB16F, GL_RGB, GL_HALF_FLOAT, m_textureSizeSpecular, m_specularMipCount };
+    // The LUT is filtered into a 32 bit float texture, the cache keeps that precision
+    const CachedTextureLayout lutLayout{ GL_TEXTURE_2D, GL_RGBA32F, GL_RGBA, GL_FLOAT, m_textureSizeLut, 1 };
+
+    // Everything that changes the filtered result is part of the cache keys
+    const uint32_t settings[] = { IBL_CACHE_VERSION, static_cast<uint32_t>(m_impl->sampleCount), m_textureSizeDiffuse,
+        m_textureSizeSpecular, m_specularMipCount, m_textureSizeLut, envCubemap->width };
+
+    if (m_impl->m_lutHandle != ibl.LUT->handle)
+    {
+        const uint32_t lutSettings[] = { IBL_CACHE_VERSION, static_cast<uint32_t>(m_impl->sampleCount), m_textureSizeLut };
+        const std::string lutPath = fmt::format("ibl_lut_{:016x}.ktx", HashBytes(lutSettings, sizeof(lutSettings)));
+        if (!LoadCachedTexture(lutPath, lutLayout, ibl.LUT->handle))
+        {
+            m_impl->CreateLUTIBL(ibl.LUT, envCubemap, m_textureSizeLut);
+            SaveCachedTexture(lutPath, lutLayout, ibl.LUT->handle);
+        }
+        m_impl->m_lutHandle = ibl.LUT->handle;
+    }
+
+    std::string diffusePath;
+    std::string specularPath;
+    if (sourceHash != 0)
+    {
+        const uint64_t key = HashBytes(settings, sizeof(settings), sourceHash);
+        diffusePath = fmt::format("ibl_{:016x}_diffuse.ktx", key);
+        specularPath = fmt::format("ibl_{:016x}_specular.ktx", key);
+
+        if (LoadCachedTexture(diffusePath, diffuseLayout, ibl.diffuse->handle) &&
+            LoadCachedTexture(specularPath, specularLayout, ibl.specular->handle))
+        {
+            Log::Info("IBL loaded from cache: {}ms", std::chrono::duration_cast<std::chrono::milliseconds>(std::chrono::high_resolution_clock::now() - t).count());
+            return;
+        }
+    }
+
     m_impl->CreateDiffuseIBL(ibl.diffuse, envCubemap, m_textureSizeDiffuse);
     m_impl->CreateSpecularIBL(ibl.specular, envCubemap, m_textureSizeSpecular, m_specularMipCount);
-    m_impl->CreateLUTIBL(ibl.LUT, envCubemap, m_textureSizeLut);
 
-    glFinish();
-    Log::Info("IBL generation: {}ms", std::chrono::duration_cast<std::chrono::milliseconds>(std::chrono::high_resolution_clock::now() - t).count());
+    // Reading the maps back waits for the filtering, no separate glFinish needed
+    if (sourceHash != 0)
+    {
+        SaveCachedTexture(diffusePath, diffuseLayout, ibl.diffuse->handle);
+        SaveCachedTexture(specularPath, specularLayout, ibl.specular->handle);
+    }
 
+    Log::Info("IBL generation: {}ms", std::chrono::duration_cast<std::chrono::milliseconds>(std::chrono::high_resolution_clock::now() - t).count());
 }
 
 void bee::IBLRenderer::Impl::CreateDiffuseIBL(std::shared_ptr<Image> diffuseIBL, std::shared_ptr<Image> envCubemap, uint32_t textureSize)
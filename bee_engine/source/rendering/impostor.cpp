@@ -0,0 +1,48 @@
+#include <precompiled/engine_precompiled.hpp>
+#include "rendering/impostor.hpp"
+
+#include "math/geometry.hpp"
+
+glm::vec2 bee::OctahedralEncode(glm::vec3 direction)
+{
+    direction /= (glm::abs(direction.x) + glm::abs(direction.y) + glm::abs(direction.z));
+
+    glm::vec2 octahedral = glm::vec2(direction.x, direction.y);
+    if (direction.z < 0.0f)
+    {
+        // Fold the lower hemisphere over the diagonals
+        const glm::vec2 signs = glm::vec2(direction.x >= 0.0f ? 1.0f : -1.0f, direction.y >= 0.0f ? 1.0f : -1.0f);
+        octahedral = (1.0f - glm::abs(glm::vec2(direction.y, direction.x))) * signs;
+    }
+
+    return octahedral * 0.5f + 0.5f;
+}
+
+glm::vec3 bee::OctahedralDecode(glm::vec2 uv)
+{
+    const glm::vec2 octahedral = uv * 2.0f - 1.0f;
+    glm::vec3 direction = glm::vec3(octahedral.x, octahedral.y, 1.0f - glm::abs(octahedral.x) - glm::abs(octahedral.y));
+
+    if (direction.z < 0.0f)
+    {
+        const glm::vec2 signs = glm::vec2(direction.x >= 0.0f ? 1.0f : -1.0f, direction.y >= 0.0f ? 1.0f : -1.0f);
+        const glm::vec2 unfolded = (1.0f - glm::abs(glm::vec2(direction.y, direction.x))) * signs;
+        direction.x = unfolded.x;
+        direction.y = unfolded.y;
+    }
+
+    return glm::normalize(direction);
+}
+
+glm::vec3 bee::ImpostorFrameDirection(uint32_t frameX, uint32_t frameY, uint32_t framesPerSide)
+{
+    const glm::vec2 uv = (glm::vec2(frameX, frameY) + 0.5f) / static_cast<float>(framesPerSide);
+    return OctahedralDecode(uv);
+}
+
+void bee::ImpostorBillboardBasis(glm::vec3 viewDirection, glm::vec3& right, glm::vec3& up)
+{
+    const glm::vec3 worldUp = glm::abs(viewDirection.z) > 0.999f ? World::FORWARD : World::UP;
+    right = glm::normalize(glm::cross(worldUp, viewDirection));
+    up = glm::cross(viewDirection, right);
+}
@@ -0,0 +1,350 @@
+#include "precompiled/engine_precompiled.hpp"
+
+#include "rendering/impostor_renderer.hpp"
+
+#include <glm/gtc/matrix_transform.hpp>
+
+#include "core/engine.hpp"
+#include "math/geometry.hpp"
+#include "platform/opengl/open_gl.hpp"
+#include "platform/opengl/shader_gl.hpp"
+#include "platform/opengl/gl_uniform.hpp"
+#include "platform/opengl/uniforms_gl.hpp"
+#include "rendering/model_renderer.hpp"
+#include "rendering/shader_db.hpp"
+#include "resources/image/image_gl.hpp"
+#include "resources/image/texture_cache_gl.hpp"
+#include "resources/material/material.hpp"
+#include "resources/mesh/mesh_gl.hpp"
+#include "resources/model/model.hpp"
+#include <tools/log.hpp>
+#include <tools/tools.hpp>
+
+namespace
+{
+// Bump when the bake or the atlas layout changes, so stale cache files are not loaded
+constexpr uint32_t IMPOSTOR_CACHE_VERSION = 1;
+
+// Mip chain of the atlas textures, limited so frames do not bleed into each other
+constexpr uint32_t IMPOSTOR_MIP_COUNT = 4;
+}
+
+class bee::ImpostorRenderer::Impl
+{
+public:
+    struct BakeDrawCall
+    {
+        glm::mat4 transform;
+        std::shared_ptr<Mesh> mesh;
+        std::shared_ptr<Material> material;
+    };
+
+    void CollectDrawCalls(const Model& model, int nodeIndex, const glm::mat4& parentTransform, std::vector<BakeDrawCall>& drawCalls);
+    std::shared_ptr<ImpostorAtlas> CreateAtlas(const Model& model, uint32_t framesPerSide, uint32_t frameResolution);
+    void BakeAtlas(const Model& model, ImpostorAtlas& atlas);
+    std::shared_ptr<Image> CreateAtlasTexture(GLenum internalFormat, uint32_t size, const std::string& label);
+
+    // Cache files of the albedo, normal and depth atlas, in that order
+    static std::array<CachedTextureLayout, 3> GetCacheLayouts(uint32_t atlasSize);
+    static std::array<std::string, 3> GetCachePaths(const std::string& modelPath, uint32_t framesPerSide, uint32_t frameResolution);
+
+    std::unordered_map<std::string, std::shared_ptr<ImpostorAtlas>> m_cache;
+    GLuint m_billboardVAO = 0;
+};
+
+bee::ImpostorRenderer::ImpostorRenderer(const Material::IBL& ibl) : m_impl(std::make_unique<Impl>()), m_ibl(ibl)
+{
+    // Billboard corners are generated from gl_VertexID, but a VAO still has to be bound to draw
+    glGenVertexArrays(1, &m_impl->m_billboardVAO);
+    glBindVertexArray(m_impl->m_billboardVAO);
+    LabelGL(GL_VERTEX_ARRAY, m_impl->m_billboardVAO, "Impostor Billboard VAO");
+    BEE_DEBUG_ONLY(glBindVertexArray(0));
+}
+
+bee::ImpostorRenderer::~ImpostorRenderer()
+{
+    glDeleteVertexArrays(1, &m_impl->m_billboardVAO);
+}
+
+std::shared_ptr<bee::ImpostorAtlas> bee::ImpostorRenderer::GetOrBake(ResourceHandle<Model> model)
+{
+    auto modelPtr = model.Retrieve();
+    if (!modelPtr) return nullptr;
+
+    const std::string path = model.GetPath();
+    if (path.empty()) return Bake(*modelPtr, m_framesPerSide, m_frameResolution);
+
+    auto it = m_impl->m_cache.find(path);
+    if (it != m_impl->m_cache.end()) return it->second;
+
+    // Atlases are baked once and kept in the save directory, later runs only upload them
+    const auto paths = Impl::GetCachePaths(path, m_framesPerSide, m_frameResolution);
+    const auto layouts = Impl::GetCacheLayouts(m_framesPerSide * m_frameResolution);
+
+    auto atlas = m_impl->CreateAtlas(*modelPtr, m_framesPerSide, m_frameResolution);
+    const bool cached = !paths[0].empty() && LoadCachedTexture(paths[0], layouts[0], atlas->albedo->handle) &&
+        LoadCachedTexture(paths[1], layouts[1], atlas->normal->handle) &&
+        LoadCachedTexture(paths[2], layouts[2], atlas->depth->handle);
+    glBindTexture(GL_TEXTURE_2D, 0);
+
+    if (!cached)
+    {
+        m_impl->BakeAtlas(*modelPtr, *atlas);
+        if (!paths[0].empty())
+        {
+            SaveCachedTexture(paths[0], layouts[0], atlas->albedo->handle);
+            SaveCachedTexture(paths[1], layouts[1], atlas->normal->handle);
+            SaveCachedTexture(paths[2], layouts[2], atlas->depth->handle);
+            glBindTexture(GL_TEXTURE_2D, 0);
+        }
+    }
+
+    m_impl->m_cache.emplace(path, atlas);
+    return atlas;
+}
+
+std::shared_ptr<bee::ImpostorAtlas> bee::ImpostorRenderer::Bake(const Model& model, uint32_t framesPerSide, uint32_t frameResolution)
+{
+    auto atlas = m_impl->CreateAtlas(model, framesPerSide, frameResolution);
+    m_impl->BakeAtlas(model, *atlas);
+    return atlas;
+}
+
+void bee::ImpostorRenderer::Render(const std::vector<Renderer::ImpostorInfo>& impostorsToDraw)
+{
+    if (impostorsToDraw.empty()) return;
+
+    PushDebugGL("Impostor pass");
+    auto shader = Engine.ShaderDB()[ShaderDB::Type::IMPOSTOR];
+    shader->Activate();
+
+    // Shares the instance buffer with the model pass, like the shadow pass does
+    auto& instanceBuffer = *static_cast<Uniform<TransformsUBO>*>(Engine.Renderer().GetModelRenderer().InstancedTransformBuffer());
+
+    glActiveTexture(GL_TEXTURE0 + SPECULAR_SAMPER_LOCATION);
+    glBindTexture(GL_TEXTURE_CUBE_MAP, m_ibl.specular->handle);
+    glUniform1i(SPECULAR_SAMPER_LOCATION, SPECULAR_SAMPER_LOCATION);
+
+    glEnable(GL_DEPTH_TEST);
+    glDisable(GL_CULL_FACE);
+    glBindVertexArray(m_impl->m_billboardVAO);
+
+    //Traverse the list, batching consecutive instances of the same atlas
+    size_t drawPtr = 0;
+    while (drawPtr < impostorsToDraw.size())
+    {
+        auto& batchAtlas = impostorsToDraw.at(drawPtr).atlas;
+
+        size_t instanceCount = 0;
+        for (size_t lookPtr = drawPtr; lookPtr < impostorsToDraw.size() && instanceCount < MAX_TRANSFORM_INSTANCES; ++lookPtr)
+        {
+            auto& nextElement = impostorsToDraw.at(lookPtr);
+            if (nextElement.atlas != batchAtlas) break;
+
+            instanceBuffer->bee_transforms[instanceCount].world = nextElement.transform;
+            instanceCount++;
+        }
+        instanceBuffer.Patch();
+
+        glActiveTexture(GL_TEXTURE0 + BASE_COLOR_SAMPLER_LOCATION);
+        glBindTexture(GL_TEXTURE_2D, batchAtlas->albedo->handle);
+        glUniform1i(BASE_COLOR_SAMPLER_LOCATION, BASE_COLOR_SAMPLER_LOCATION);
+        glActiveTexture(GL_TEXTURE0 + NORMAL_SAMPLER_LOCATION);
+        glBindTexture(GL_TEXTURE_2D, batchAtlas->normal->handle);
+        glUniform1i(NORMAL_SAMPLER_LOCATION, NORMAL_SAMPLER_LOCATION);
+        glActiveTexture(GL_TEXTURE0 + DEPTH_SAMPLER_LOCATION);
+        glBindTexture(GL_TEXTURE_2D, batchAtlas->depth->handle);
+        glUniform1i(DEPTH_SAMPLER_LOCATION, DEPTH_SAMPLER_LOCATION);
+
+        shader->GetParameter("u_framesPerSide")->SetValue(static_cast<int>(batchAtlas->framesPerSide));
+        shader->GetParameter("u_center")->SetValue(batchAtlas->center);
+        shader->GetParameter("u_radius")->SetValue(batchAtlas->radius);
+
+        glDrawArraysInstanced(GL_TRIANGLE_STRIP, 0, 4, static_cast<GLsizei>(instanceCount));
+
+        drawPtr += instanceCount;
+    }
+
+    glEnable(GL_CULL_FACE);
+    PopDebugGL();
+}
+
+void bee::ImpostorRenderer::Impl::CollectDrawCalls(const Model& model, int nodeIndex, const glm::mat4& parentTransform, std::vector<BakeDrawCall>& drawCalls)
+{
+    auto& node = model.nodes[nodeIndex];
+    if (node.lodLevel > 0) return;
+
+    const glm::mat4 transform = parentTransform
+        * glm::translate(glm::mat4(1.0f), node.translation)
+        * glm::mat4_cast(node.rotation)
+        * glm::scale(glm::mat4(1.0f), node.scale);
+
+    if (node.meshIndex != -1)
+    {
+        // Always bake from the highest detail level
+        for (auto& [meshHandle, materialIndex] : model.meshes[node.meshIndex][0].primitiveMaterialPairs)
+        {
+            auto mesh = meshHandle.Retrieve();
+            if (!mesh) continue;
+
+            std::shared_ptr<Material> material = materialIndex != -1 ? model.materials[materialIndex].Retrieve() : nullptr;
+            drawCalls.push_back({ transform, mesh, material });
+        }
+    }
+
+    for (auto child : node.children)
+        CollectDrawCalls(model, child, transform, drawCalls);
+}
+
+void bee::ImpostorRenderer::Impl::BakeAtlas(const Model& model, ImpostorAtlas& atlas)
+{
+    auto t = std::chrono::high_resolution_clock::now();
+    PushDebugGL("Impostor bake");
+
+    const uint32_t framesPerSide = atlas.framesPerSide;
+    const uint32_t frameResolution = atlas.frameResolution;
+    const uint32_t atlasSize = framesPerSide * frameResolution;
+
+    // Offscreen target, no default framebuffer is touched
+    GLuint bakeFBO = 0, bakeDepth = 0;
+    glGenFramebuffers(1, &bakeFBO);
+    glBindFramebuffer(GL_FRAMEBUFFER, bakeFBO);
+    LabelGL(GL_FRAMEBUFFER, bakeFBO, "[R] Impostor Bake FBO");
+    glFramebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_TEXTURE_2D, atlas.albedo->handle, 0);
+    glFramebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT1, GL_TEXTURE_2D, atlas.normal->handle, 0);
+    glFramebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT2, GL_TEXTURE_2D, atlas.depth->handle, 0);
+
+    glGenRenderbuffers(1, &bakeDepth);
+    glBindRenderbuffer(GL_RENDERBUFFER, bakeDepth);
+    glRenderbufferStorage(GL_RENDERBUFFER, GL_DEPTH_COMPONENT24, atlasSize, atlasSize);
+    glFramebufferRenderbuffer(GL_FRAMEBUFFER, GL_DEPTH_ATTACHMENT, GL_RENDERBUFFER, bakeDepth);
+
+    unsigned int attachments[3] = { GL_COLOR_ATTACHMENT0, GL_COLOR_ATTACHMENT1, GL_COLOR_ATTACHMENT2 };
+    glDrawBuffers(3, attachments);
+
+    if (glCheckFramebufferStatus(GL_FRAMEBUFFER) != GL_FRAMEBUFFER_COMPLETE) assert(false);
+
+    // Empty texels decode to a zero normal and a centered depth, so they do not bias the frame blending
+    const float clearAlbedo[4] = { 0.0f, 0.0f, 0.0f, 0.0f };
+    const float clearNormal[4] = { 0.5f, 0.5f, 0.5f, 0.0f };
+    const float clearDepth[4] = { 0.5f, 0.0f, 0.0f, 0.0f };
+    glViewport(0, 0, atlasSize, atlasSize);
+    glClearBufferfv(GL_COLOR, 0, clearAlbedo);
+    glClearBufferfv(GL_COLOR, 1, clearNormal);
+    glClearBufferfv(GL_COLOR, 2, clearDepth);
+    glClear(GL_DEPTH_BUFFER_BIT);
+
+    std::vector<Impl::BakeDrawCall> drawCalls;
+    for (auto root : model.rootNodes)
+        CollectDrawCalls(model, root, glm::mat4(1.0f), drawCalls);
+
+    auto shader = Engine.ShaderDB()[ShaderDB::Type::IMPOSTOR_BAKE];
+    shader->Activate();
+    shader->GetParameter("u_center")->SetValue(atlas.center);
+    shader->GetParameter("u_radius")->SetValue(atlas.radius);
+
+    glEnable(GL_DEPTH_TEST);
+    glDisable(GL_CULL_FACE);
+
+    const float radius = atlas.radius;
+    const glm::mat4 projection = glm::ortho(-radius, radius, -radius, radius, 0.0f, radius * 4.0f);
+
+    for (uint32_t y = 0; y < framesPerSide; y++)
+    {
+        for (uint32_t x = 0; x < framesPerSide; x++)
+        {
+            const glm::vec3 direction = ImpostorFrameDirection(x, y, framesPerSide);
+            glm::vec3 right, up;
+            ImpostorBillboardBasis(direction, right, up);
+
+            const glm::mat4 view = glm::lookAt(atlas.center + direction * radius * 2.0f, atlas.center, up);
+            shader->GetParameter("u_viewProjection")->SetValue(projection * view);
+            shader->GetParameter("u_viewDirection")->SetValue(direction);
+
+            glViewport(x * frameResolution, y * frameResolution, frameResolution, frameResolution);
+
+            for (auto& drawCall : drawCalls)
+            {
+                shader->GetParameter("u_world")->SetValue(drawCall.transform);
+                shader->GetParameter("u_use_base_texture")->SetValue(drawCall.material && drawCall.material->UseBaseTexture);
+                shader->GetParameter("u_base_color_factor")->SetValue(drawCall.material ? drawCall.material->BaseColorFactor : glm::vec4(1.0f));
+                if (drawCall.material) Material::ApplyAlbedo(drawCall.material);
+
+                glBindVertexArray(drawCall.mesh->vao_handle);
+                glDrawElements(GL_TRIANGLES, drawCall.mesh->index_count, drawCall.mesh->index_format, nullptr);
+            }
+        }
+    }
+
+    glEnable(GL_CULL_FACE);
+    glBindFramebuffer(GL_FRAMEBUFFER, 0);
+    glDeleteRenderbuffers(1, &bakeDepth);
+    glDeleteFramebuffers(1, &bakeFBO);
+
+    for (const auto& image : { atlas.albedo, atlas.normal, atlas.depth })
+    {
+        glBindTexture(GL_TEXTURE_2D, image->handle);
+        glGenerateMipmap(GL_TEXTURE_2D);
+    }
+    glBindTexture(GL_TEXTURE_2D, 0);
+
+    PopDebugGL();
+    Log::Info("Impostor bake ({} frames, {} draws): {}ms", framesPerSide * framesPerSide, drawCalls.size(),
+        std::chrono::duration_cast<std::chrono::milliseconds>(std::chrono::high_resolution_clock::now() - t).count());
+}
+
+std::shared_ptr<bee::ImpostorAtlas> bee::ImpostorRenderer::Impl::CreateAtlas(const Model& model, uint32_t framesPerSide, uint32_t frameResolution)
+{
+    auto atlas = std::make_shared<ImpostorAtlas>();
+    atlas->framesPerSide = framesPerSide;
+    atlas->frameResolution = frameResolution;
+
+    const glm::vec3 extents = (model.maxBounds - model.minBounds) * 0.5f;
+    atlas->center = model.minBounds + extents;
+    atlas->radius = glm::max(glm::length(extents), 0.001f);
+
+    const uint32_t atlasSize = framesPerSide * frameResolution;
+    atlas->albedo = CreateAtlasTexture(GL_RGBA8, atlasSize, "[R] Impostor Albedo Atlas");
+    atlas->normal = CreateAtlasTexture(GL_RGBA8, atlasSize, "[R] Impostor Normal Atlas");
+    atlas->depth = CreateAtlasTexture(GL_R16F, atlasSize, "[R] Impostor Depth Atlas");
+    return atlas;
+}
+
+std::shared_ptr<bee::Image> bee::ImpostorRenderer::Impl::CreateAtlasTexture(GLenum internalFormat, uint32_t size, const std::string& label)
+{
+    GLuint handle = 0;
+    glGenTextures(1, &handle);
+    glBindTexture(GL_TEXTURE_2D, handle);
+    LabelGL(GL_TEXTURE, handle, label);
+
+    glTexStorage2D(GL_TEXTURE_2D, IMPOSTOR_MIP_COUNT, internalFormat, size, size);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAX_LEVEL, IMPOSTOR_MIP_COUNT - 1);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR_MIPMAP_LINEAR);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+
+    return std::make_shared<Image>(handle, internalFormat, size, size);
+}
+
+std::array<bee::CachedTextureLayout, 3> bee::ImpostorRenderer::Impl::GetCacheLayouts(uint32_t atlasSize)
+{
+    return { CachedTextureLayout{ GL_TEXTURE_2D, GL_RGBA8, GL_RGBA, GL_UNSIGNED_BYTE, atlasSize, IMPOSTOR_MIP_COUNT },
+             CachedTextureLayout{ GL_TEXTURE_2D, GL_RGBA8, GL_RGBA, GL_UNSIGNED_BYTE, atlasSize, IMPOSTOR_MIP_COUNT },
+             CachedTextureLayout{ GL_TEXTURE_2D, GL_R16F, GL_RED, GL_HALF_FLOAT, atlasSize, IMPOSTOR_MIP_COUNT } };
+}
+
+std::array<std::string, 3> bee::ImpostorRenderer::Impl::GetCachePaths(const std::string& modelPath, uint32_t framesPerSide, uint32_t frameResolution)
+{
+    // The atlas changes with the model file, models that are not an asset file are not cached
+    auto& fileIO = Engine.FileIO();
+    if (!fileIO.Exists(FileIO::Directory::Asset, modelPath)) return {};
+
+    const std::vector<char> source = fileIO.ReadBinaryFile(FileIO::Directory::Asset, modelPath);
+    const uint32_t settings[] = { IMPOSTOR_CACHE_VERSION, framesPerSide, frameResolution };
+    const uint64_t key = HashBytes(settings, sizeof(settings), HashBytes(source.data(), source.size()));
+
+    return { fmt::format("impostor_{:016x}_albedo.ktx", key),
+             fmt::format("impostor_{:016x}_normal.ktx", key),
+             fmt::format("impostor_{:016x}_depth.ktx", key) };
+}
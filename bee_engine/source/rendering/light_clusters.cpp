@@ -0,0 +1,159 @@
+#include <precompiled/engine_precompiled.hpp>
+#include "rendering/light_clusters.hpp"
+
+#include "tools/thread_pool.hpp"
+
+namespace
+{
+// Below this many lights the binning is cheaper than handing it to other threads
+constexpr size_t PARALLEL_LIGHT_THRESHOLD = 64;
+}
+
+bee::LightClusterGrid::LightClusterGrid(glm::uvec3 dimensions) : m_dimensions(dimensions)
+{
+    assert(dimensions.x > 0 && dimensions.y > 0 && dimensions.z > 0);
+    m_clusters.resize(ClusterCount());
+}
+
+uint32_t bee::LightClusterGrid::DepthSlice(float viewDepth) const
+{
+    const float slice = glm::log(glm::max(viewDepth, m_nearPlane)) * m_sliceScale + m_sliceBias;
+    return static_cast<uint32_t>(glm::clamp(slice, 0.0f, static_cast<float>(m_dimensions.z - 1)));
+}
+
+bee::LightClusterBounds bee::LightClusterGrid::ComputeBounds(glm::vec4 viewSpaceLight, const glm::mat4& projection) const
+{
+    LightClusterBounds bounds{};
+
+    const glm::vec3 center = glm::vec3(viewSpaceLight);
+    const float radius = viewSpaceLight.w;
+
+    // The camera looks down -Z in view space
+    const float closest = -center.z - radius;
+    const float furthest = -center.z + radius;
+    if (furthest < m_nearPlane || closest > m_farPlane) return bounds;
+
+    bounds.min.z = DepthSlice(closest);
+    bounds.max.z = DepthSlice(furthest);
+
+    // Project the corners of the view space box around the sphere.
+    // A box crossing the near plane cannot be projected reliably, it covers the whole screen instead.
+    glm::vec2 ndcMin = glm::vec2(-1.0f);
+    glm::vec2 ndcMax = glm::vec2(1.0f);
+
+    if (closest > m_nearPlane)
+    {
+        ndcMin = glm::vec2(std::numeric_limits<float>::max());
+        ndcMax = glm::vec2(std::numeric_limits<float>::lowest());
+
+        for (int corner = 0; corner < 8; corner++)
+        {
+            const glm::vec3 offset = glm::vec3(corner & 1 ? radius : -radius, corner & 2 ? radius : -radius, corner & 4 ? radius : -radius);
+            const glm::vec4 clip = projection * glm::vec4(center + offset, 1.0f);
+            const glm::vec2 ndc = glm::vec2(clip) / clip.w;
+            ndcMin = glm::min(ndcMin, ndc);
+            ndcMax = glm::max(ndcMax, ndc);
+        }
+
+        if (ndcMax.x < -1.0f || ndcMax.y < -1.0f || ndcMin.x > 1.0f || ndcMin.y > 1.0f) return bounds;
+
+        ndcMin = glm::max(ndcMin, glm::vec2(-1.0f));
+        ndcMax = glm::min(ndcMax, glm::vec2(1.0f));
+    }
+
+    const glm::vec2 tiles = glm::vec2(m_dimensions.x, m_dimensions.y);
+    const glm::vec2 tileMin = glm::floor((ndcMin * 0.5f + 0.5f) * tiles);
+    const glm::vec2 tileMax = glm::floor((ndcMax * 0.5f + 0.5f) * tiles);
+
+    bounds.min.x = static_cast<uint32_t>(glm::clamp(tileMin.x, 0.0f, tiles.x - 1.0f));
+    bounds.min.y = static_cast<uint32_t>(glm::clamp(tileMin.y, 0.0f, tiles.y - 1.0f));
+    bounds.max.x = static_cast<uint32_t>(glm::clamp(tileMax.x, 0.0f, tiles.x - 1.0f));
+    bounds.max.y = static_cast<uint32_t>(glm::clamp(tileMax.y, 0.0f, tiles.y - 1.0f));
+    bounds.visible = true;
+
+    return bounds;
+}
+
+void bee::LightClusterGrid::Build(const std::vector<glm::vec4>& viewSpaceLights, const glm::mat4& projection, float nearPlane, float farPlane, ThreadPool* threadPool)
+{
+    m_nearPlane = glm::max(nearPlane, 0.01f);
+    m_farPlane = glm::max(farPlane, m_nearPlane + 0.01f);
+
+    const float logDepthRange = glm::log(m_farPlane / m_nearPlane);
+    m_sliceScale = static_cast<float>(m_dimensions.z) / logDepthRange;
+    m_sliceBias = -static_cast<float>(m_dimensions.z) * glm::log(m_nearPlane) / logDepthRange;
+
+    m_lightBounds.resize(viewSpaceLights.size());
+    for (size_t i = 0; i < viewSpaceLights.size(); i++)
+        m_lightBounds[i] = ComputeBounds(viewSpaceLights[i], projection);
+
+    std::fill(m_clusters.begin(), m_clusters.end(), glm::uvec2(0));
+
+    // Every depth slice only touches its own clusters, so slices can be binned independently
+    auto forEachSliceRange = [&](auto&& function)
+    {
+        const size_t threads = threadPool ? threadPool->NumberOfThreads() : 0;
+        if (threads < 2 || viewSpaceLights.size() < PARALLEL_LIGHT_THRESHOLD)
+        {
+            function(0u, m_dimensions.z - 1);
+            return;
+        }
+
+        const uint32_t slicesPerTask = (m_dimensions.z + static_cast<uint32_t>(threads) - 1) / static_cast<uint32_t>(threads);
+        std::vector<std::future<void>> tasks;
+        for (uint32_t first = 0; first < m_dimensions.z; first += slicesPerTask)
+        {
+            const uint32_t last = glm::min(first + slicesPerTask, m_dimensions.z) - 1;
+            tasks.push_back(threadPool->Enqueue([&function, first, last]() { function(first, last); }));
+        }
+        for (auto& task : tasks) task.get();
+    };
+
+    forEachSliceRange([this](uint32_t first, uint32_t last) { CountSlices(first, last); });
+
+    uint32_t offset = 0;
+    for (auto& cluster : m_clusters)
+    {
+        cluster.x = offset;
+        offset += cluster.y;
+        cluster.y = 0;
+    }
+    m_lightIndices.resize(offset);
+
+    forEachSliceRange([this](uint32_t first, uint32_t last) { FillSlices(first, last); });
+}
+
+void bee::LightClusterGrid::CountSlices(uint32_t firstSlice, uint32_t lastSlice)
+{
+    for (const auto& bounds : m_lightBounds)
+    {
+        if (!bounds.visible) continue;
+
+        const uint32_t minZ = glm::max(bounds.min.z, firstSlice);
+        const uint32_t maxZ = glm::min(bounds.max.z, lastSlice);
+        for (uint32_t z = minZ; z <= maxZ; z++)
+            for (uint32_t y = bounds.min.y; y <= bounds.max.y; y++)
+                for (uint32_t x = bounds.min.x; x <= bounds.max.x; x++)
+                    m_clusters[ClusterIndex(x, y, z)].y++;
+    }
+}
+
+void bee::LightClusterGrid::FillSlices(uint32_t firstSlice, uint32_t lastSlice)
+{
+    for (uint32_t light = 0; light < m_lightBounds.size(); light++)
+    {
+        const auto& bounds = m_lightBounds[light];
+        if (!bounds.visible) continue;
+
+        const uint32_t minZ = glm::max(bounds.min.z, firstSlice);
+        const uint32_t maxZ = glm::min(bounds.max.z, lastSlice);
+        for (uint32_t z = minZ; z <= maxZ; z++)
+            for (uint32_t y = bounds.min.y; y <= bounds.max.y; y++)
+                for (uint32_t x = bounds.min.x; x <= bounds.max.x; x++)
+                {
+                    auto& cluster = m_clusters[ClusterIndex(x, y, z)];
+                    m_lightIndices[cluster.x + cluster.y] = light;
+                    cluster.y++;
+                }
+    }
+}
@@ -32,6 +32,9 @@ bee::ShaderDB::ShaderDB()
     m_shaders.emplace(Type::GRASS_COMPUTE, 
                       std::make_shared<Shader>(FileIO::Directory::Asset, 
                       "shaders/grass/grass_generation.comp"));
+    m_shaders.emplace(Type::GRASS_CULL, 
+                      std::make_shared<Shader>(FileIO::Directory::Asset, 
+                      "shaders/grass/grass_cull.comp"));
     m_shaders.emplace(Type::SKYBOX, 
                       std::make_shared<Shader>(FileIO::Directory::Asset, 
                       "shaders/skybox/skybox.vert", 
@@ -70,9 +73,17 @@ bee::ShaderDB::ShaderDB()
                       std::make_shared<Shader>(FileIO::Directory::Asset,
                       "shaders/displacement/write_displacement.comp"));
 
-    m_shaders.emplace(Type::POPULATE_3DTEX_PERLIN,
+    m_shaders.emplace(Type::IMPOSTOR,
+                      std::make_shared<Shader>(FileIO::Directory::Asset,
+                      "shaders/impostor/impostor.vert",
+                      "shaders/impostor/impostor.frag"));
+    m_shaders.emplace(Type::IMPOSTOR_BAKE,
+                      std::make_shared<Shader>(FileIO::Directory::Asset,
+                      "shaders/impostor/impostor_bake.vert",
+                      "shaders/impostor/impostor_bake.frag"));
+    m_shaders.emplace(Type::WIND_CHECK,
                       std::make_shared<Shader>(FileIO::Directory::Asset,
-                      "shaders/noise/populate_3dtex_perlin.comp"));
+                      "shaders/wind_check.comp"));
 }
 
 bee::ShaderDB::~ShaderDB() = default;
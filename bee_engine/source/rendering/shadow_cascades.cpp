@@ -0,0 +1,246 @@
+#include <precompiled/engine_precompiled.hpp>
+#include "rendering/shadow_cascades.hpp"
+
+#include "math/geometry.hpp"
+#include "tools/log.hpp"
+
+#include <glm/gtc/matrix_transform.hpp>
+
+std::array<float, bee::MAX_SHADOW_CASCADES> bee::ComputeCascadeSplits(CascadeSplitScheme scheme, float lambda, float nearPlane, float farPlane, uint32_t count)
+{
+    std::array<float, MAX_SHADOW_CASCADES> splits{};
+    splits.fill(farPlane);
+
+    count = glm::clamp(count, 1u, MAX_SHADOW_CASCADES);
+    nearPlane = glm::max(nearPlane, 0.001f);
+
+    for (uint32_t i = 1; i < count; i++)
+    {
+        const float fraction = static_cast<float>(i) / static_cast<float>(count);
+        const float uniform = nearPlane + (farPlane - nearPlane) * fraction;
+        const float logarithmic = nearPlane * glm::pow(farPlane / nearPlane, fraction);
+
+        switch (scheme)
+        {
+        case CascadeSplitScheme::Uniform: splits[i - 1] = uniform; break;
+        case CascadeSplitScheme::Logarithmic: splits[i - 1] = logarithmic; break;
+        case CascadeSplitScheme::Practical: splits[i - 1] = glm::mix(uniform, logarithmic, glm::clamp(lambda, 0.0f, 1.0f)); break;
+        }
+    }
+
+    return splits;
+}
+
+glm::vec4 bee::CascadeBoundingSphere(const CascadeCamera& camera, float nearSplit, float farSplit)
+{
+    // A slice corner at depth d lies d * k from the view axis
+    const float tanHalfFov = glm::tan(camera.fieldOfView * 0.5f);
+    const float k2 = tanHalfFov * tanHalfFov * (1.0f + camera.aspectRatio * camera.aspectRatio);
+
+    // Center on the view axis, equally far from the near and far corners.
+    // Wide slices are bounded by the far corners alone.
+    float depth = 0.5f * (nearSplit + farSplit) * (1.0f + k2);
+    float radius = 0.0f;
+    if (depth >= farSplit)
+    {
+        depth = farSplit;
+        radius = farSplit * glm::sqrt(k2);
+    }
+    else
+    {
+        radius = glm::sqrt((farSplit - depth) * (farSplit - depth) + farSplit * farSplit * k2);
+    }
+
+    // The camera looks down -Z in view space
+    const glm::vec3 center = camera.inverseView * glm::vec4(0.0f, 0.0f, -depth, 1.0f);
+    return glm::vec4(center, radius);
+}
+
+glm::mat4 bee::CascadeLightView(glm::vec3 lightDirection)
+{
+    lightDirection = glm::normalize(lightDirection);
+    const glm::vec3 up = glm::abs(glm::dot(lightDirection, World::FORWARD)) > 0.99f ? World::UP : World::FORWARD;
+    return glm::lookAt(lightDirection, glm::vec3(0.0f), up);
+}
+
+bee::ShadowCascade bee::FitCascade(const CascadeCamera& camera, float nearSplit, float farSplit, glm::vec3 lightDirection,
+    glm::vec3 casterMin, glm::vec3 casterMax, uint32_t resolution, uint32_t snapTexels)
+{
+    ShadowCascade cascade{};
+    cascade.nearSplit = nearSplit;
+    cascade.farSplit = farSplit;
+
+    const glm::vec4 sphere = CascadeBoundingSphere(camera, nearSplit, farSplit);
+    cascade.center = glm::vec3(sphere);
+    cascade.radius = sphere.w;
+
+    resolution = glm::max(resolution, 4u);
+    snapTexels = glm::clamp(snapTexels, 1u, resolution / 4);
+
+    // The snapped center is up to one step away from the sphere center, so the bounds grow by a step.
+    // Solved for the extent that keeps a step a whole number of texels: extent = radius + snapTexels * 2 * extent / resolution
+    const float halfExtent = cascade.radius / (1.0f - 2.0f * static_cast<float>(snapTexels) / static_cast<float>(resolution));
+    cascade.texelSize = 2.0f * halfExtent / static_cast<float>(resolution);
+    const float step = cascade.texelSize * static_cast<float>(snapTexels);
+
+    const glm::mat4 lightView = CascadeLightView(lightDirection);
+    const glm::vec3 lightCenter = glm::floor(glm::vec3(lightView * glm::vec4(cascade.center, 1.0f)) / step) * step;
+
+    // Depth is measured along -Z in light space
+    float nearDepth = -lightCenter.z - halfExtent;
+    float farDepth = -lightCenter.z + halfExtent;
+
+    if (glm::all(glm::lessThanEqual(casterMin, casterMax)))
+    {
+        float casterNear = std::numeric_limits<float>::max();
+        float casterFar = std::numeric_limits<float>::lowest();
+        for (int corner = 0; corner < 8; corner++)
+        {
+            const glm::vec3 point = glm::vec3(corner & 1 ? casterMax.x : casterMin.x, corner & 2 ? casterMax.y : casterMin.y, corner & 4 ? casterMax.z : casterMin.z);
+            const float depth = -(lightView * glm::vec4(point, 1.0f)).z;
+            casterNear = glm::min(casterNear, depth);
+            casterFar = glm::max(casterFar, depth);
+        }
+
+        // Anything between the light and the slice can cast into it, nothing beyond the casters receives a shadow
+        nearDepth = casterNear;
+        farDepth = glm::max(glm::min(farDepth, casterFar), nearDepth);
+    }
+    else
+    {
+        // Tune this parameter according to the scene, casters between the light and the cascade still need to be drawn
+        constexpr float zMult = 10.0f;
+        nearDepth = -lightCenter.z - halfExtent * zMult;
+    }
+
+    // Keep geometry touching the planes from being clipped
+    const float depthMargin = glm::max(step, 0.01f * (farDepth - nearDepth));
+
+    const glm::mat4 lightProjection = glm::ortho(
+        lightCenter.x - halfExtent, lightCenter.x + halfExtent,
+        lightCenter.y - halfExtent, lightCenter.y + halfExtent,
+        nearDepth - depthMargin, farDepth + depthMargin);
+    cascade.viewProjection = lightProjection * lightView;
+
+    return cascade;
+}
+
+std::array<bee::ShadowCascade, bee::MAX_SHADOW_CASCADES> bee::FitCascades(const CascadeCamera& camera, glm::vec3 lightDirection,
+    glm::vec3 casterMin, glm::vec3 casterMax, const CascadeSettings& settings)
+{
+    std::array<ShadowCascade, MAX_SHADOW_CASCADES> cascades{};
+
+    const uint32_t count = glm::clamp(settings.cascadeCount, 1u, MAX_SHADOW_CASCADES);
+    const float shadowDistance = glm::clamp(settings.shadowDistance, camera.nearPlane + 0.01f, camera.farPlane);
+    const auto splits = ComputeCascadeSplits(settings.scheme, settings.splitLambda, camera.nearPlane, shadowDistance, count);
+
+    for (uint32_t i = 0; i < count; i++)
+    {
+        const float nearSplit = i == 0 ? camera.nearPlane : splits[i - 1];
+        cascades[i] = FitCascade(camera, nearSplit, splits[i], lightDirection, casterMin, casterMax, settings.resolution, settings.snapTexels);
+    }
+
+    return cascades;
+}
+
+bool bee::CheckCascadeFit(const CascadeSettings& settings)
+{
+    const uint32_t count = glm::clamp(settings.cascadeCount, 1u, MAX_SHADOW_CASCADES);
+    const float halfResolution = static_cast<float>(glm::max(settings.resolution, 4u)) * 0.5f;
+    const glm::vec3 casterMin(-300.0f, -300.0f, -10.0f);
+    const glm::vec3 casterMax(300.0f, 300.0f, 60.0f);
+
+    // Straight down, low and from the side, and close to the fallback up vector of CascadeLightView
+    const glm::vec3 lightDirections[] = { World::UP, glm::normalize(glm::vec3(0.3f, -0.5f, 0.8f)),
+        glm::normalize(glm::vec3(1.0f, 0.2f, 0.1f)), glm::normalize(glm::vec3(0.01f, 1.0f, 0.02f)) };
+    const glm::vec3 positions[] = { glm::vec3(0.0f, 0.0f, 5.0f), glm::vec3(123.4f, -56.7f, 20.0f), glm::vec3(-250.3f, 180.9f, 2.5f) };
+    const float yaws[] = { 0.0f, 1.1f, 2.7f, -2.0f };
+
+    const auto makeCamera = [](glm::vec3 position, float yaw)
+    {
+        CascadeCamera camera{};
+        camera.aspectRatio = 16.0f / 9.0f;
+        camera.farPlane = 600.0f;
+        camera.inverseView = glm::inverse(glm::lookAt(position, position + glm::vec3(glm::cos(yaw), glm::sin(yaw), -0.3f), World::UP));
+        return camera;
+    };
+
+    for (const glm::vec3& light : lightDirections)
+    {
+        for (const glm::vec3& position : positions)
+        {
+            const auto reference = FitCascades(makeCamera(position, yaws[0]), light, casterMin, casterMax, settings);
+            for (float yaw : yaws)
+            {
+                const CascadeCamera camera = makeCamera(position, yaw);
+                const auto cascades = FitCascades(camera, light, casterMin, casterMax, settings);
+                const float tanHalfFov = glm::tan(camera.fieldOfView * 0.5f);
+
+                for (uint32_t i = 0; i < count; i++)
+                {
+                    const ShadowCascade& cascade = cascades[i];
+
+                    // Every corner of the slice lands on the map
+                    for (int corner = 0; corner < 8; corner++)
+                    {
+                        const float depth = corner & 4 ? cascade.farSplit : cascade.nearSplit;
+                        const glm::vec3 view(depth * tanHalfFov * camera.aspectRatio * (corner & 1 ? 1.0f : -1.0f),
+                            depth * tanHalfFov * (corner & 2 ? 1.0f : -1.0f), -depth);
+                        const glm::vec4 clip = cascade.viewProjection * (camera.inverseView * glm::vec4(view, 1.0f));
+                        if (glm::abs(clip.x) > 1.0001f || glm::abs(clip.y) > 1.0001f)
+                        {
+                            Log::Warn("Shadow cascade {} does not cover its slice, corner {} lands at ({}, {})", i, corner, clip.x, clip.y);
+                            return false;
+                        }
+                    }
+
+                    // No caster between the light and the slice is clipped by the near plane. Casters past the far
+                    // plane are beyond the slice and cannot shadow it.
+                    for (int corner = 0; corner < 8; corner++)
+                    {
+                        const glm::vec3 point(corner & 1 ? casterMax.x : casterMin.x, corner & 2 ? casterMax.y : casterMin.y,
+                            corner & 4 ? casterMax.z : casterMin.z);
+                        const float depth = (cascade.viewProjection * glm::vec4(point, 1.0f)).z;
+                        if (depth < -1.0001f)
+                        {
+                            Log::Warn("Shadow cascade {} clips caster corner {} at depth {}", i, corner, depth);
+                            return false;
+                        }
+                    }
+
+                    // Turning the camera keeps the texel size, so edges do not swim
+                    if (glm::abs(cascade.texelSize - reference[i].texelSize) > reference[i].texelSize * 1e-4f)
+                    {
+                        Log::Warn("Shadow cascade {} changes its texel size from {} to {} when the camera turns", i,
+                            reference[i].texelSize, cascade.texelSize);
+                        return false;
+                    }
+                }
+            }
+
+            // Moving the camera moves the map by whole snap steps, the world origin stays on the same spot of a texel
+            const glm::vec3 offsets[] = { glm::vec3(0.013f, 0.0f, 0.0f), glm::vec3(0.71f, -1.37f, 0.2f), glm::vec3(-9.3f, 4.1f, -0.6f) };
+            for (const glm::vec3& offset : offsets)
+            {
+                const auto moved = FitCascades(makeCamera(position + offset, yaws[0]), light, casterMin, casterMax, settings);
+                for (uint32_t i = 0; i < count; i++)
+                {
+                    const glm::vec2 before = glm::vec2(reference[i].viewProjection * glm::vec4(0.0f, 0.0f, 0.0f, 1.0f)) * halfResolution;
+                    const glm::vec2 after = glm::vec2(moved[i].viewProjection * glm::vec4(0.0f, 0.0f, 0.0f, 1.0f)) * halfResolution;
+                    const glm::vec2 steps = (after - before) / static_cast<float>(glm::max(settings.snapTexels, 1u));
+
+                    // The error of the light space transform grows with the distance of the origin from the cascade center
+                    const float tolerance = 1e-3f + 1e-5f * glm::length(before);
+                    if (glm::any(glm::greaterThan(glm::abs(steps - glm::round(steps)), glm::vec2(tolerance))))
+                    {
+                        Log::Warn("Shadow cascade {} moved by ({}, {}) snap steps when the camera moved", i, steps.x, steps.y);
+                        return false;
+                    }
+                }
+            }
+        }
+    }
+
+    Log::Info("Shadow cascades fit their slices and casters and keep their texel grid");
+    return true;
+}
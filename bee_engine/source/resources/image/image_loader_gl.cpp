@@ -21,6 +21,9 @@ bee::ResourceHandle<bee::Image> bee::ImageLoader::FromFile(bee::FileIO::Director
     case bee::ImageFormat::R8:
         desired_channels = 1;
         break;
+    case bee::ImageFormat::RG8:
+        desired_channels = 2;
+        break;
     case bee::ImageFormat::RGBA32F:
         desired_channels = 4;
         isFloat = true;
@@ -88,6 +91,11 @@ bee::ResourceHandle<bee::Image> bee::ImageLoader::FromRawData(const void* image_
         usage = GL_RED;
         type = GL_UNSIGNED_BYTE;
         break;
+    case ImageFormat::RG8:
+        gl_format = GL_RG8;
+        usage = GL_RG;
+        type = GL_UNSIGNED_BYTE;
+        break;
     case ImageFormat::RGBA32F:
         gl_format = GL_RGBA32F;
         usage = GL_RGBA;
@@ -108,6 +116,11 @@ bee::ResourceHandle<bee::Image> bee::ImageLoader::FromRawData(const void* image_
         usage = GL_RGBA;
         type = GL_UNSIGNED_BYTE;
         break;
+    case ImageFormat::R16:
+        gl_format = GL_R16;
+        usage = GL_RED;
+        type = GL_UNSIGNED_SHORT;
+        break;
     default:
         throw std::runtime_error("Encountered unsupported image data");
         break;
@@ -117,6 +130,8 @@ bee::ResourceHandle<bee::Image> bee::ImageLoader::FromRawData(const void* image_
     glGenTextures(1, &textureHandle);             // Gen
     glBindTexture(GL_TEXTURE_2D, textureHandle);  // Bind
 
+    // Rows are tightly packed, single channel images of an odd width do not start at 4 byte boundaries
+    glPixelStorei(GL_UNPACK_ALIGNMENT, 1);
     glTexImage2D(
         GL_TEXTURE_2D,     // What (target)
         0,                 // Mip-map level
@@ -128,6 +143,7 @@ bee::ResourceHandle<bee::Image> bee::ImageLoader::FromRawData(const void* image_
         type,              // Type   (how to interpret)
         image_data
     );
+    glPixelStorei(GL_UNPACK_ALIGNMENT, 4);
 
     glGenerateMipmap(GL_TEXTURE_2D);
     
@@ -159,6 +175,11 @@ bee::ResourceHandle<bee::Image3D> bee::ImageLoader::FromRawData(const void* imag
         usage = GL_RED;
         type = GL_UNSIGNED_BYTE;
         break;
+    case ImageFormat::RG8:
+        gl_format = GL_RG8;
+        usage = GL_RG;
+        type = GL_UNSIGNED_BYTE;
+        break;
     case ImageFormat::RGBA32F:
         gl_format = GL_RGBA8;
         usage = GL_RGBA;
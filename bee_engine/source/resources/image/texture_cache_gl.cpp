@@ -0,0 +1,168 @@
+#include <precompiled/engine_precompiled.hpp>
+#include <resources/image/texture_cache_gl.hpp>
+
+#include <core/engine.hpp>
+#include <core/fileio.hpp>
+#include <tools/log.hpp>
+
+namespace
+{
+constexpr uint8_t KTX_IDENTIFIER[12] = { 0xAB, 0x4B, 0x54, 0x58, 0x20, 0x31, 0x31, 0xBB, 0x0D, 0x0A, 0x1A, 0x0A };
+constexpr uint32_t KTX_ENDIANNESS = 0x04030201;
+
+// KTX 1.1 file header
+struct KTXHeader
+{
+    uint8_t identifier[12];
+    uint32_t endianness;
+    uint32_t glType;
+    uint32_t glTypeSize;
+    uint32_t glFormat;
+    uint32_t glInternalFormat;
+    uint32_t glBaseInternalFormat;
+    uint32_t pixelWidth;
+    uint32_t pixelHeight;
+    uint32_t pixelDepth;
+    uint32_t numberOfArrayElements;
+    uint32_t numberOfFaces;
+    uint32_t numberOfMipmapLevels;
+    uint32_t bytesOfKeyValueData;
+};
+
+uint32_t ComponentCount(GLenum format)
+{
+    switch (format)
+    {
+        case GL_RED: return 1;
+        case GL_RG: return 2;
+        case GL_RGB: return 3;
+        default: return 4;
+    }
+}
+
+uint32_t TypeSize(GLenum type)
+{
+    switch (type)
+    {
+        case GL_UNSIGNED_BYTE: return 1;
+        case GL_HALF_FLOAT: return 2;
+        default: return 4;
+    }
+}
+}
+
+uint32_t bee::CachedTextureLayout::FaceBytes(uint32_t level) const
+{
+    const uint32_t width = glm::max(size >> level, 1u);
+    const uint32_t rowBytes = (width * ComponentCount(format) * TypeSize(type) + 3) & ~3u;
+    return rowBytes * width;
+}
+
+bool bee::LoadCachedTexture(const std::string& path, const CachedTextureLayout& layout, GLuint texture)
+{
+    auto& fileIO = Engine.FileIO();
+    if (!fileIO.Exists(FileIO::Directory::Save, path)) return false;
+
+    const std::vector<char> file = fileIO.ReadBinaryFile(FileIO::Directory::Save, path);
+    if (file.size() < sizeof(KTXHeader)) return false;
+
+    KTXHeader header{};
+    std::memcpy(&header, file.data(), sizeof(header));
+    const bool matches = std::memcmp(header.identifier, KTX_IDENTIFIER, sizeof(KTX_IDENTIFIER)) == 0 &&
+        header.endianness == KTX_ENDIANNESS && header.glType == layout.type && header.glFormat == layout.format &&
+        header.glInternalFormat == layout.internalFormat && header.pixelWidth == layout.size &&
+        header.pixelHeight == layout.size && header.numberOfFaces == layout.FaceCount() &&
+        header.numberOfMipmapLevels == layout.mipCount;
+
+    if (!matches)
+    {
+        Log::Warn("Texture cache file {} does not match the current settings, regenerating it", path);
+        return false;
+    }
+
+    // Check the whole file before touching the texture
+    size_t offset = sizeof(KTXHeader) + header.bytesOfKeyValueData;
+    for (uint32_t level = 0; level < layout.mipCount; level++)
+        offset += sizeof(uint32_t) + static_cast<size_t>(layout.FaceBytes(level)) * layout.FaceCount();
+    if (offset > file.size())
+    {
+        Log::Warn("Texture cache file {} is truncated, regenerating it", path);
+        return false;
+    }
+
+    glPixelStorei(GL_UNPACK_ALIGNMENT, 4);
+    glBindTexture(layout.target, texture);
+
+    GLint immutable = GL_FALSE;
+    glGetTexParameteriv(layout.target, GL_TEXTURE_IMMUTABLE_FORMAT, &immutable);
+
+    offset = sizeof(KTXHeader) + header.bytesOfKeyValueData;
+    for (uint32_t level = 0; level < layout.mipCount; level++)
+    {
+        const uint32_t width = glm::max(layout.size >> level, 1u);
+        offset += sizeof(uint32_t);  // imageSize
+
+        for (uint32_t face = 0; face < layout.FaceCount(); face++)
+        {
+            if (immutable)
+                glTexSubImage2D(layout.FaceTarget(face), level, 0, 0, width, width, layout.format, layout.type, file.data() + offset);
+            else
+                glTexImage2D(layout.FaceTarget(face), level, layout.internalFormat, width, width, 0, layout.format, layout.type,
+                             file.data() + offset);
+            offset += layout.FaceBytes(level);
+        }
+    }
+
+    glTexParameteri(layout.target, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+    glTexParameteri(layout.target, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+    if (layout.target == GL_TEXTURE_CUBE_MAP) glTexParameteri(layout.target, GL_TEXTURE_WRAP_R, GL_CLAMP_TO_EDGE);
+    glTexParameteri(layout.target, GL_TEXTURE_MIN_FILTER, layout.mipCount > 1 ? GL_LINEAR_MIPMAP_LINEAR : GL_LINEAR);
+    glTexParameteri(layout.target, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+    glTexParameteri(layout.target, GL_TEXTURE_MAX_LEVEL, static_cast<GLint>(layout.mipCount - 1));
+
+    return true;
+}
+
+void bee::SaveCachedTexture(const std::string& path, const CachedTextureLayout& layout, GLuint texture)
+{
+    KTXHeader header{};
+    std::memcpy(header.identifier, KTX_IDENTIFIER, sizeof(KTX_IDENTIFIER));
+    header.endianness = KTX_ENDIANNESS;
+    header.glType = layout.type;
+    header.glTypeSize = TypeSize(layout.type);
+    header.glFormat = layout.format;
+    header.glInternalFormat = layout.internalFormat;
+    header.glBaseInternalFormat = layout.format;
+    header.pixelWidth = layout.size;
+    header.pixelHeight = layout.size;
+    header.numberOfFaces = layout.FaceCount();
+    header.numberOfMipmapLevels = layout.mipCount;
+
+    size_t fileSize = sizeof(KTXHeader);
+    for (uint32_t level = 0; level < layout.mipCount; level++)
+        fileSize += sizeof(uint32_t) + static_cast<size_t>(layout.FaceBytes(level)) * layout.FaceCount();
+
+    std::vector<char> file(fileSize);
+    std::memcpy(file.data(), &header, sizeof(header));
+
+    glPixelStorei(GL_PACK_ALIGNMENT, 4);
+    glBindTexture(layout.target, texture);
+
+    size_t offset = sizeof(KTXHeader);
+    for (uint32_t level = 0; level < layout.mipCount; level++)
+    {
+        // For cube maps imageSize is the size of a single face
+        const uint32_t imageSize = layout.FaceBytes(level);
+        std::memcpy(file.data() + offset, &imageSize, sizeof(imageSize));
+        offset += sizeof(uint32_t);
+
+        for (uint32_t face = 0; face < layout.FaceCount(); face++)
+        {
+            glGetTexImage(layout.FaceTarget(face), level, layout.format, layout.type, file.data() + offset);
+            offset += imageSize;
+        }
+    }
+
+    if (!Engine.FileIO().WriteBinaryFile(FileIO::Directory::Save, path, file))
+        Log::Warn("Could not write texture cache file {}", path);
+}
@@ -177,4 +177,38 @@ void bee::mesh_utils::GenerateDisplacementData(ResourceHandle<Mesh> handle, glm:
         glBindBuffer(GL_ARRAY_BUFFER, 0);
         glBindVertexArray(0);
     }
-}
\ No newline at end of file
+}
+
+bee::MeshLoader::MeshData bee::mesh_utils::ReadMeshData(ResourceHandle<Mesh> handle, uint32_t lod)
+{
+    MeshLoader::MeshData meshData{};
+
+    auto mesh = handle.Retrieve();
+    if (!mesh || lod >= mesh->lodCount) return meshData;
+
+    // Meshes are always created with 32 bit indices by FromRawData
+    assert(mesh->index_format == GL_UNSIGNED_INT);
+
+    auto readAttribute = [&](VertexAttributeIndex attribute, uint32_t components, std::vector<float>& out)
+    {
+        GLuint vbo = mesh->attribute_buffers[lod][attribute];
+        if (vbo == 0) return;
+
+        out.resize(mesh->vertex_count * components, 0.0f);
+        glBindBuffer(GL_ARRAY_BUFFER, vbo);
+        glGetBufferSubData(GL_ARRAY_BUFFER, 0, out.size() * sizeof(float), out.data());
+    };
+
+    readAttribute(VertexAttributeIndex::POSITION, 3, meshData.positions);
+    readAttribute(VertexAttributeIndex::NORMAL, 3, meshData.normals);
+    readAttribute(VertexAttributeIndex::TEXTURE0_UV, 2, meshData.texture_uvs);
+    readAttribute(VertexAttributeIndex::TANGENT, 4, meshData.tangents);
+    glBindBuffer(GL_ARRAY_BUFFER, 0);
+
+    meshData.indices.resize(mesh->index_count);
+    glBindBuffer(GL_COPY_READ_BUFFER, mesh->index_handle);
+    glGetBufferSubData(GL_COPY_READ_BUFFER, 0, meshData.indices.size() * sizeof(uint32_t), meshData.indices.data());
+    glBindBuffer(GL_COPY_READ_BUFFER, 0);
+
+    return meshData;
+}
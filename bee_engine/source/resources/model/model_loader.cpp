@@ -11,6 +11,7 @@
 #include <tools/log.hpp>
 
 #include <jolt/Physics/Collision/Shape/MeshShape.h>
+#include <physics/cooked_colliders.hpp>
 
 #define TINYGLTF_USE_CPP14
 #include <tinygltf/tiny_gltf.h>
@@ -185,6 +186,7 @@ bee::ResourceHandle<bee::Model> bee::ModelLoader::FromGLTF(bee::FileIO::Director
     std::vector<ResourceHandle<Material>> materials;
     std::vector<std::vector<PrimitiveSet>> meshes;
     std::vector<ColliderGroup> colliderGroups;
+    CookedColliders cookedColliders(directory, std::string(path));
 
     //Load all textures
     std::vector<ResourceHandle<Image>> allImages;
@@ -335,9 +337,7 @@ bee::ResourceHandle<bee::Model> bee::ModelLoader::FromGLTF(bee::FileIO::Director
                         triangles.push_back(triangle);
                     }
                     
-                    JPH::MeshShapeSettings shapeSettings(triangles);
-                    shapeSettings.SetEmbedded();
-                    JPH::ShapeSettings::ShapeResult shapeResult = shapeSettings.Create();
+                    JPH::ShapeSettings::ShapeResult shapeResult = cookedColliders.GetMeshShape(triangles);
 
                     if (shapeResult.HasError())
                     {
@@ -476,6 +476,9 @@ bee::ResourceHandle<bee::Model> bee::ModelLoader::FromGLTF(bee::FileIO::Director
         nodes.emplace_back(node);
     }
 
+    // Colliders built because they weren't cooked yet are cooked for the next load
+    cookedColliders.Save();
+
     auto newEntry = std::make_shared<ResourceEntry<Model>>();
     newEntry->origin_path = std::string(path);
     newEntry->resource = std::make_shared<Model>(
@@ -1,83 +1,172 @@
 #include <precompiled/engine_precompiled.hpp>
 #include "terrain/terrain_collider.hpp"
 
-#include <tinygltf/stb_image.h>
+#include <sstream>
+
+#include <jolt/Core/StreamWrapper.h>
+#include <jolt/Physics/PhysicsSystem.h>
+#include <jolt/Physics/Body/BodyCreationSettings.h>
+#include <jolt/Physics/Collision/Shape/HeightFieldShape.h>
 
-#include "core/ecs.hpp"
 #include "core/engine.hpp"
 #include "core/transform.hpp"
-#include "terrain/terrain_chunk.hpp"
+#include "physics/helpers.hpp"
+#include "physics/layers.hpp"
+#include "terrain/terrain_heightfield.hpp"
 #include "tools/log.hpp"
+#include "tools/tools.hpp"
+
+namespace
+{
+// Jolt works best with a power of two sample count, at most this many along a side
+constexpr uint32_t TERRAIN_SHAPE_MAX_SAMPLES = 1024;
+// Larger blocks save more memory than fewer bits per sample, at the cost of coarser culling inside the shape
+constexpr uint32_t TERRAIN_SHAPE_BLOCK_SIZE = 4;
+// Largest height error the sample compression may introduce, in world units
+constexpr float TERRAIN_SHAPE_MAX_ERROR = 0.02f;
+// Bump when the shape layout changes, so old cache files are not restored
+constexpr uint32_t TERRAIN_SHAPE_CACHE_VERSION = 1;
+}
 
-bee::TerrainCollider::TerrainCollider(FileIO::Directory directory, const std::string& heightMapPath) : m_heightMapTransform(glm::identity<glm::mat4>())
+bee::TerrainCollider::TerrainCollider(std::shared_ptr<const TerrainHeightfield> heightfield, const glm::mat4& terrainWorld,
+    glm::vec2 terrainSize, float heightModifier)
+    : m_heightfield(std::move(heightfield)), m_heightModifier(heightModifier)
 {
-    std::vector<char> heightMapBinary = Engine.FileIO().ReadBinaryFile(directory, heightMapPath);
-    int component{};
-    m_heightMap = stbi_load_from_memory(
-        reinterpret_cast<unsigned char*>(heightMapBinary.data()),
-        static_cast<int>(heightMapBinary.size()), &m_heightMapWidth, &m_heightMapHeight, &component, 4
-    );
+    assert(m_heightfield != nullptr);
+
+    // The terrain is centred on its transform
+    m_worldToUV = glm::translate(glm::identity<glm::mat4>(), glm::vec3{ 0.5f, 0.5f, 0.0f });
+    m_worldToUV *= glm::scale(glm::identity<glm::mat4>(), 1.0f / glm::vec3{ terrainSize, 1.0f });
+    m_worldToUV *= glm::inverse(terrainWorld);
+
+    CreateBody(terrainWorld, terrainSize);
 }
 
 bee::TerrainCollider::~TerrainCollider()
 {
-    stbi_image_free(m_heightMap);
+    if (m_body.IsInvalid()) return;
+
+    auto& bodyInterface = Engine.PhysicsSystem().GetBodyInterface();
+    bodyInterface.RemoveBody(m_body);
+    bodyInterface.DestroyBody(m_body);
 }
 
 float bee::TerrainCollider::SampleHeightInWorld(glm::vec3 worldPosition) const
 {
-    auto view = Engine.ECS().Registry.view<TerrainChunk, Transform>();
-    auto [terrain, transform] = view.get(*view.begin());
-
-    glm::vec4 sampleLocation = GetHeightMapTransform() * glm::vec4(worldPosition, 1.0f);
+    const glm::vec2 uv = glm::vec2(m_worldToUV * glm::vec4(worldPosition, 1.0f));
+    const bool inside = glm::all(glm::greaterThanEqual(uv, glm::vec2(0.0f))) && glm::all(glm::lessThanEqual(uv, glm::vec2(1.0f)));
 
-    if (sampleLocation.x - 1.0f < 0 || 
-        sampleLocation.y - 1.0f < 0 || 
-        sampleLocation.x + 1.0f > m_heightMapWidth || 
-        sampleLocation.y + 1.0f > m_heightMapHeight)
-        return 0.0f;
+    return m_heightfield->Sample(uv) * m_heightModifier * static_cast<float>(inside);
+}
 
-    uint32_t x0{ static_cast<uint32_t>(sampleLocation.x) };
-    uint32_t y0{ static_cast<uint32_t>(sampleLocation.y) };
-    uint32_t x1{ x0 + 1 };
-    uint32_t y1{ y0 + 1 };
+void bee::TerrainCollider::SampleHeightsInWorld(const glm::vec3* worldPositions, float* heights, size_t count) const
+{
+    for (size_t i = 0; i < count; i++)
+        heights[i] = SampleHeightInWorld(worldPositions[i]);
+}
 
-    float dx = sampleLocation.x - x0;
-    float dy = sampleLocation.y - y0;
+void bee::TerrainCollider::CreateBody(const glm::mat4& terrainWorld, glm::vec2 terrainSize)
+{
+    glm::vec3 scale, translation;
+    glm::quat rotation;
+    Decompose(terrainWorld, translation, scale, rotation);
 
-    uint8_t topLeft     = m_heightMap[(y0 * m_heightMapWidth + x0) * 4];
-    uint8_t topRight    = m_heightMap[(y0 * m_heightMapWidth + x1) * 4];
-    uint8_t bottomLeft  = m_heightMap[(y1 * m_heightMapWidth + x0) * 4];
-    uint8_t bottomRight = m_heightMap[(y1 * m_heightMapWidth + x1) * 4];
+    JPH::ShapeRefC shape = LoadOrBuildShape(terrainSize, scale);
+    if (shape == nullptr) return;
 
-    float top    = topLeft    + dx * static_cast<float>(topRight    - topLeft);
-    float bottom = bottomLeft + dx * static_cast<float>(bottomRight - bottomLeft);
+    // Jolt height fields are Y up, the engine is Z up
+    const glm::quat zUp = glm::angleAxis(glm::half_pi<float>(), glm::vec3(1.0f, 0.0f, 0.0f));
 
-    float value = top + dy * (bottom - top);
+    auto& physicsSystem = Engine.PhysicsSystem();
+    auto& bodyInterface = physicsSystem.GetBodyInterface();
+    JPH::BodyCreationSettings bodySettings(shape, GlmToJolt(translation), GlmToJolt(rotation * zUp), JPH::EMotionType::Static, Layers::NON_MOVING);
 
-    float height = value / 255.0f * terrain.heightModifier;
+    JPH::Body* body = bodyInterface.CreateBody(bodySettings);
+    if (body == nullptr)
+    {
+        Log::Warn("physics body creation failed");
+        Log::Info("num bodies: {:d}, max bodies: {:d}", physicsSystem.GetNumBodies(), physicsSystem.GetMaxBodies());
+        return;
+    }
 
-    return height;
+    bodyInterface.AddBody(body->GetID(), JPH::EActivation::DontActivate);
+    m_body = body->GetID();
 }
 
-glm::mat4 bee::TerrainCollider::GetHeightMapTransform() const
+JPH::ShapeRefC bee::TerrainCollider::LoadOrBuildShape(glm::vec2 terrainSize, glm::vec3 scale) const
 {
-    if (m_initialized)
-        return m_heightMapTransform;
+    const float dimensions[6] = { terrainSize.x, terrainSize.y, scale.x, scale.y, scale.z, m_heightModifier };
+    uint64_t hash = HashBytes(&TERRAIN_SHAPE_CACHE_VERSION, sizeof(TERRAIN_SHAPE_CACHE_VERSION), m_heightfield->GetHash());
+    hash = HashBytes(dimensions, sizeof(dimensions), hash);
+    const std::string cachePath = fmt::format("terrain_shape_{:016x}.bin", hash);
+
+    auto& fileIO = Engine.FileIO();
+    if (fileIO.Exists(FileIO::Directory::Save, cachePath))
+    {
+        const std::vector<char> binary = fileIO.ReadBinaryFile(FileIO::Directory::Save, cachePath);
+        std::istringstream stream(std::string(binary.begin(), binary.end()), std::ios::binary);
+        JPH::StreamInWrapper streamIn(stream);
+
+        JPH::Shape::ShapeResult result = JPH::Shape::sRestoreFromBinaryState(streamIn);
+        if (result.IsValid() && !streamIn.IsFailed())
+        {
+            // Height fields built here have no materials
+            JPH::Ref<JPH::Shape> shape = result.Get();
+            shape->RestoreMaterialState(nullptr, 0);
+            return shape;
+        }
+
+        Log::Warn("Could not restore terrain shape from {}, rebuilding it", cachePath);
+    }
+
+    JPH::ShapeRefC shape = BuildShape(terrainSize, scale);
+    if (shape == nullptr) return shape;
 
-    auto view = Engine.ECS().Registry.view<TerrainChunk, Transform>();
-    if (view.begin() == view.end())
+    std::ostringstream stream(std::ios::binary);
+    JPH::StreamOutWrapper streamOut(stream);
+    shape->SaveBinaryState(streamOut);
+
+    const std::string binary = stream.str();
+    fileIO.WriteBinaryFile(FileIO::Directory::Save, cachePath, std::vector<char>(binary.begin(), binary.end()));
+    return shape;
+}
+
+JPH::ShapeRefC bee::TerrainCollider::BuildShape(glm::vec2 terrainSize, glm::vec3 scale) const
+{
+    const uint32_t resolution = glm::max(m_heightfield->GetWidth(), m_heightfield->GetHeight());
+    uint32_t sampleCount = TERRAIN_SHAPE_BLOCK_SIZE * 2;
+    while (sampleCount < resolution && sampleCount < TERRAIN_SHAPE_MAX_SAMPLES) sampleCount *= 2;
+
+    const glm::vec2 size = terrainSize * glm::vec2(scale);
+    const glm::vec2 cell = size / static_cast<float>(sampleCount - 1);
+    const float heightScale = m_heightModifier * scale.z;
+
+    // Samples span the terrain edge to edge. Rotated to Z up the shape's sample rows run towards -Y, so they are flipped.
+    JPH::HeightFieldShapeSettings settings{};
+    settings.mSampleCount = sampleCount;
+    settings.mHeightSamples.resize(static_cast<size_t>(sampleCount) * sampleCount);
+    for (uint32_t row = 0; row < sampleCount; row++)
     {
-        return glm::identity<glm::mat4>();
+        float* samples = &settings.mHeightSamples[static_cast<size_t>(sampleCount - 1 - row) * sampleCount];
+        for (uint32_t column = 0; column < sampleCount; column++)
+        {
+            const glm::vec2 uv = glm::vec2(static_cast<float>(column), static_cast<float>(row)) / static_cast<float>(sampleCount - 1);
+            samples[column] = m_heightfield->Sample(uv) * heightScale;
+        }
     }
 
-    auto [terrain, transform] = view.get(*view.begin());
-    m_heightMapTransform *= glm::scale(glm::identity<glm::mat4>(), glm::vec3{ m_heightMapWidth, m_heightMapHeight, 1.0f });
-    m_heightMapTransform *= glm::translate(glm::identity<glm::mat4>(), glm::vec3{ 0.5f, 0.5f, 0.0f }); // Translate by half to center
-    m_heightMapTransform *= glm::scale(glm::identity<glm::mat4>(), 1.0f / glm::vec3{ terrain.width, terrain.height, 1.0f }); // Scale by terrain size.
-    m_heightMapTransform *= glm::inverse(transform.World());
+    const glm::vec2 minimum = -size * 0.5f;
+    settings.mOffset = JPH::Vec3(minimum.x, 0.0f, -(minimum.y + cell.y * static_cast<float>(sampleCount - 1)));
+    settings.mScale = JPH::Vec3(cell.x, 1.0f, cell.y);
+    settings.mBlockSize = TERRAIN_SHAPE_BLOCK_SIZE;
+    settings.mBitsPerSample = settings.CalculateBitsPerSampleForError(TERRAIN_SHAPE_MAX_ERROR);
 
-    m_initialized = true;
+    JPH::ShapeSettings::ShapeResult result = settings.Create();
+    if (result.HasError())
+    {
+        Log::Error("Failed to build the terrain height field shape: {}", result.GetError().c_str());
+        return nullptr;
+    }
 
-    return m_heightMapTransform;
+    return result.Get();
 }
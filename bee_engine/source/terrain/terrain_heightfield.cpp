@@ -0,0 +1,164 @@
+#include <precompiled/engine_precompiled.hpp>
+#include "terrain/terrain_heightfield.hpp"
+
+#include <tinygltf/stb_image.h>
+
+#include "core/engine.hpp"
+#include "resources/image/image_loader.hpp"
+#include "resources/resource_manager.hpp"
+#include "tools/log.hpp"
+#include "tools/tools.hpp"
+
+bee::TerrainHeightfield::TerrainHeightfield(uint32_t width, uint32_t height, std::vector<uint16_t> samples)
+    : m_width(width), m_height(height), m_samples(std::move(samples))
+{
+    assert(m_width > 0 && m_height > 0);
+    assert(m_samples.size() == static_cast<size_t>(m_width) * m_height);
+
+    m_size = glm::vec2(static_cast<float>(m_width), static_cast<float>(m_height));
+    m_maxTexel = m_size - 1.0f;
+    BuildRangeLevels();
+
+    const uint32_t dimensions[2] = { m_width, m_height };
+    m_hash = HashBytes(dimensions, sizeof(dimensions));
+    m_hash = HashBytes(m_samples.data(), sizeof(uint16_t) * m_samples.size(), m_hash);
+}
+
+std::shared_ptr<const bee::TerrainHeightfield> bee::TerrainHeightfield::FromFile(FileIO::Directory directory, const std::string& path)
+{
+    std::vector<char> binary = Engine.FileIO().ReadBinaryFile(directory, path);
+
+    int width = 0;
+    int height = 0;
+    int components = 0;
+    // Without a requested component count stb keeps the channels as they are, asking for one would convert RGB to luminance
+    stbi_us* decoded = stbi_load_16_from_memory(reinterpret_cast<unsigned char*>(binary.data()),
+        static_cast<int>(binary.size()), &width, &height, &components, 0);
+
+    if (decoded == nullptr)
+    {
+        Log::Error("Failed to decode terrain heightfield {}: {}", path, stbi_failure_reason());
+        return std::make_shared<TerrainHeightfield>(1, 1, std::vector<uint16_t>{ 0 });
+    }
+
+    // The terrain shaders sample the red channel
+    std::vector<uint16_t> samples(static_cast<size_t>(width) * height);
+    for (size_t i = 0; i < samples.size(); i++)
+        samples[i] = decoded[i * components];
+    stbi_image_free(decoded);
+
+    return std::make_shared<TerrainHeightfield>(static_cast<uint32_t>(width), static_cast<uint32_t>(height), std::move(samples));
+}
+
+bee::ResourceHandle<bee::Image> bee::TerrainHeightfield::CreateImage(const std::string& path) const
+{
+    ResourceHandle<Image> image = Engine.Resources().Images().FromRawData(m_samples.data(), ImageFormat::R16, m_width, m_height);
+    image.SetPath(path);
+    return image;
+}
+
+float bee::TerrainHeightfield::Sample(glm::vec2 uv) const
+{
+    // Texel centres sit at half texel offsets, outside the grid the edge texels repeat
+    const glm::vec2 texel = glm::clamp(uv * m_size - 0.5f, glm::vec2(0.0f), m_maxTexel);
+    const glm::vec2 base = glm::floor(texel);
+    const glm::vec2 t = texel - base;
+
+    const uint32_t x0 = static_cast<uint32_t>(base.x);
+    const uint32_t y0 = static_cast<uint32_t>(base.y);
+    const uint32_t x1 = glm::min(x0 + 1, m_width - 1);
+    const uint32_t y1 = glm::min(y0 + 1, m_height - 1);
+
+    const uint16_t* row0 = &m_samples[y0 * m_width];
+    const uint16_t* row1 = &m_samples[y1 * m_width];
+    const float top = glm::mix(static_cast<float>(row0[x0]), static_cast<float>(row0[x1]), t.x);
+    const float bottom = glm::mix(static_cast<float>(row1[x0]), static_cast<float>(row1[x1]), t.x);
+
+    return glm::mix(top, bottom, t.y) * m_normalize;
+}
+
+void bee::TerrainHeightfield::Sample(const glm::vec2* uvs, float* heights, size_t count) const
+{
+    for (size_t i = 0; i < count; i++)
+        heights[i] = Sample(uvs[i]);
+}
+
+glm::vec2 bee::TerrainHeightfield::GetRange(glm::vec2 uvMin, glm::vec2 uvMax) const
+{
+    // Every texel a bilinear sample inside the area can read from
+    const glm::vec2 texelMin = glm::clamp(glm::min(uvMin, uvMax) * m_size - 0.5f, glm::vec2(0.0f), m_maxTexel);
+    const glm::vec2 texelMax = glm::clamp(glm::max(uvMin, uvMax) * m_size - 0.5f, glm::vec2(0.0f), m_maxTexel);
+
+    const uint32_t x0 = static_cast<uint32_t>(texelMin.x);
+    const uint32_t y0 = static_cast<uint32_t>(texelMin.y);
+    const uint32_t x1 = glm::min(static_cast<uint32_t>(texelMax.x) + 1, m_width - 1);
+    const uint32_t y1 = glm::min(static_cast<uint32_t>(texelMax.y) + 1, m_height - 1);
+
+    // The finest level at which the area touches at most 2x2 blocks
+    uint32_t level = 0;
+    while (level + 1 < m_rangeLevels.size() && ((x1 >> level) - (x0 >> level) > 1 || (y1 >> level) - (y0 >> level) > 1))
+        level++;
+
+    const RangeLevel& range = m_rangeLevels[level];
+    uint16_t low = std::numeric_limits<uint16_t>::max();
+    uint16_t high = 0;
+    for (uint32_t y = y0 >> level; y <= (y1 >> level); y++)
+    {
+        for (uint32_t x = x0 >> level; x <= (x1 >> level); x++)
+        {
+            low = glm::min(low, range.min[y * range.width + x]);
+            high = glm::max(high, range.max[y * range.width + x]);
+        }
+    }
+
+    return glm::vec2(static_cast<float>(low), static_cast<float>(high)) * m_normalize;
+}
+
+void bee::TerrainHeightfield::BuildRangeLevels()
+{
+    m_rangeLevels.clear();
+
+    RangeLevel first{};
+    first.width = m_width;
+    first.height = m_height;
+    first.min = m_samples;
+    first.max = m_samples;
+    m_rangeLevels.push_back(std::move(first));
+
+    while (m_rangeLevels.back().width > 1 || m_rangeLevels.back().height > 1)
+    {
+        const RangeLevel& previous = m_rangeLevels.back();
+
+        RangeLevel next{};
+        next.width = (previous.width + 1) / 2;
+        next.height = (previous.height + 1) / 2;
+        next.min.resize(static_cast<size_t>(next.width) * next.height);
+        next.max.resize(next.min.size());
+
+        for (uint32_t y = 0; y < next.height; y++)
+        {
+            for (uint32_t x = 0; x < next.width; x++)
+            {
+                // Blocks on an odd edge only have one child along that axis
+                const uint32_t childX[2] = { x * 2, glm::min(x * 2 + 1, previous.width - 1) };
+                const uint32_t childY[2] = { y * 2, glm::min(y * 2 + 1, previous.height - 1) };
+
+                uint16_t low = std::numeric_limits<uint16_t>::max();
+                uint16_t high = 0;
+                for (uint32_t cy : childY)
+                {
+                    for (uint32_t cx : childX)
+                    {
+                        low = glm::min(low, previous.min[cy * previous.width + cx]);
+                        high = glm::max(high, previous.max[cy * previous.width + cx]);
+                    }
+                }
+
+                next.min[y * next.width + x] = low;
+                next.max[y * next.width + x] = high;
+            }
+        }
+
+        m_rangeLevels.push_back(std::move(next));
+    }
+}
@@ -0,0 +1,126 @@
+#include <precompiled/engine_precompiled.hpp>
+#include "terrain/terrain_lod.hpp"
+
+#include "math/geometry.hpp"
+#include "terrain/terrain_heightfield.hpp"
+
+namespace
+{
+bool BoxIntersectsSphere(glm::vec3 boxMin, glm::vec3 boxMax, glm::vec3 center, float radius)
+{
+    const glm::vec3 closest = glm::clamp(center, boxMin, boxMax);
+    const glm::vec3 offset = closest - center;
+    return glm::dot(offset, offset) <= radius * radius;
+}
+}
+
+bool bee::TerrainLODSettings::operator==(const TerrainLODSettings& other) const
+{
+    return terrainMin == other.terrainMin && terrainMax == other.terrainMax && maxHeight == other.maxHeight &&
+        heightfield == other.heightfield &&
+        leafSize == other.leafSize && lodDistance == other.lodDistance && morphRatio == other.morphRatio;
+}
+
+void bee::TerrainLOD::Configure(const TerrainLODSettings& settings)
+{
+    m_settings = settings;
+    m_settings.leafSize = glm::max(m_settings.leafSize, 0.001f);
+    m_settings.morphRatio = glm::clamp(m_settings.morphRatio, 0.0f, 0.99f);
+
+    // A level has to reach past the nodes of the finer level around the eye, or they would touch coarser nodes
+    m_settings.lodDistance = glm::max(m_settings.lodDistance, m_settings.leafSize * 3.0f);
+
+    // Enough levels for a single root to cover the terrain, when possible
+    const glm::vec2 extents = glm::max(m_settings.terrainMax - m_settings.terrainMin, glm::vec2(0.0f));
+    const float largest = glm::max(extents.x, extents.y);
+    m_levelCount = 1;
+    while (m_levelCount < TERRAIN_MAX_LOD_LEVELS && GetNodeSize(m_levelCount - 1) < largest)
+        m_levelCount++;
+
+    for (uint32_t level = 0; level < TERRAIN_MAX_LOD_LEVELS; level++)
+    {
+        m_ranges[level] = m_settings.lodDistance * static_cast<float>(1u << level);
+
+        const float previous = level == 0 ? 0.0f : m_ranges[level - 1];
+        const float start = previous + (m_ranges[level] - previous) * m_settings.morphRatio;
+        m_morphRanges[level] = glm::vec2(start, m_ranges[level]);
+    }
+
+    // The coarsest level has nothing to morph into and covers everything beyond the finer levels
+    m_ranges[m_levelCount - 1] = std::numeric_limits<float>::max();
+    m_morphRanges[m_levelCount - 1] = glm::vec2(std::numeric_limits<float>::max());
+}
+
+void bee::TerrainLOD::Select(glm::vec3 eye, const glm::mat4& world, const std::array<Plane, 6>& frustum,
+    std::vector<TerrainNodeGPU>& fullNodes, std::vector<TerrainNodeGPU>& halfNodes) const
+{
+    fullNodes.clear();
+    halfNodes.clear();
+    if (m_levelCount == 0) return;
+
+    const uint32_t rootLevel = m_levelCount - 1;
+    const float rootSize = GetNodeSize(rootLevel);
+    for (float y = m_settings.terrainMin.y; y < m_settings.terrainMax.y; y += rootSize)
+    {
+        for (float x = m_settings.terrainMin.x; x < m_settings.terrainMax.x; x += rootSize)
+            SelectNode(glm::vec2(x, y), rootLevel, eye, world, frustum, fullNodes, halfNodes);
+    }
+}
+
+bool bee::TerrainLOD::SelectNode(glm::vec2 min, uint32_t level, glm::vec3 eye, const glm::mat4& world, const std::array<Plane, 6>& frustum,
+    std::vector<TerrainNodeGPU>& fullNodes, std::vector<TerrainNodeGPU>& halfNodes) const
+{
+    // Nodes past the terrain edge have nothing to draw
+    if (min.x >= m_settings.terrainMax.x || min.y >= m_settings.terrainMax.y) return true;
+
+    const float size = GetNodeSize(level);
+    const glm::vec2 heightRange = GetHeightRange(min, size);
+    const glm::vec3 boxMin(min, heightRange.x);
+    const glm::vec3 boxMax(min + glm::vec2(size), heightRange.y);
+
+    // Out of range of this level, the parent covers it
+    if (!BoxIntersectsSphere(boxMin, boxMax, eye, m_ranges[level])) return false;
+
+    const BoundingBox bounds = BoundingBox((boxMin + boxMax) * 0.5f, (boxMax - boxMin) * 0.5f).ApplyTransform(world);
+    if (!bounds.FrustumTest(frustum)) return true;
+
+    if (level == 0 || !BoxIntersectsSphere(boxMin, boxMax, eye, m_ranges[level - 1]))
+    {
+        fullNodes.push_back({ glm::vec4(min, size, static_cast<float>(level)) });
+        return true;
+    }
+
+    const float half = size * 0.5f;
+    for (uint32_t i = 0; i < 4; i++)
+    {
+        const glm::vec2 childMin = min + glm::vec2(static_cast<float>(i & 1), static_cast<float>(i >> 1)) * half;
+        if (!SelectNode(childMin, level - 1, eye, world, frustum, fullNodes, halfNodes))
+            halfNodes.push_back({ glm::vec4(childMin, half, static_cast<float>(level)) });
+    }
+
+    return true;
+}
+
+void bee::TerrainLOD::SelectLevel(uint32_t level, std::vector<TerrainNodeGPU>& nodes) const
+{
+    nodes.clear();
+    if (m_levelCount == 0) return;
+
+    level = glm::min(level, m_levelCount - 1);
+    const float size = GetNodeSize(level);
+    for (float y = m_settings.terrainMin.y; y < m_settings.terrainMax.y; y += size)
+    {
+        for (float x = m_settings.terrainMin.x; x < m_settings.terrainMax.x; x += size)
+            nodes.push_back({ glm::vec4(x, y, size, static_cast<float>(level)) });
+    }
+}
+
+glm::vec2 bee::TerrainLOD::GetHeightRange(glm::vec2 min, float size) const
+{
+    if (m_settings.heightfield == nullptr) return glm::vec2(0.0f, m_settings.maxHeight);
+
+    const glm::vec2 extents = m_settings.terrainMax - m_settings.terrainMin;
+    const glm::vec2 uvMin = (min - m_settings.terrainMin) / extents;
+    const glm::vec2 uvMax = (min + glm::vec2(size) - m_settings.terrainMin) / extents;
+    return m_settings.heightfield->GetRange(uvMin, uvMax) * m_settings.maxHeight;
+}
@@ -15,12 +15,50 @@
 #include <resources/image/image_gl.hpp>
 #include "platform/opengl/uniforms_gl.hpp"
 #include "rendering/shader_db.hpp"
+#include "terrain/terrain_lod.hpp"
+#include "terrain/terrain_heightfield.hpp"
+#include "math/geometry.hpp"
 
 class bee::TerrainRenderer::Impl
 {
 public:
+    struct Patch
+    {
+        GLuint vao = 0;
+        GLuint vertexBuffer = 0;
+        GLuint indexBuffer = 0;
+        uint32_t indexCount = 0;
+    };
+
     int SamplerTypeToGL(Sampler::Filter filter);
     int SamplerTypeToGL(Sampler::Wrap wrap);
+
+    void CreatePatch(Patch& patch, uint32_t resolution);
+    void DeletePatch(Patch& patch);
+    void UploadNodes(GLuint buffer, size_t& capacity, const std::vector<TerrainNodeGPU>& fullNodes, const std::vector<TerrainNodeGPU>& halfNodes);
+    void BindHeightmap(Shader& shader, const TerrainChunk& chunk);
+    void SetLODUniforms(Shader& shader, const TerrainLODSettings& settings, const std::array<glm::vec2, TERRAIN_MAX_LOD_LEVELS>& morphRanges);
+
+    static TerrainLODSettings GetLODSettings(const TerrainChunk& chunk);
+
+    // Configure clamps the settings, so the chunk settings they came from are kept to detect changes
+    TerrainLOD m_lod;
+    TerrainLODSettings m_lodSettings{};
+    Patch m_fullPatch;  // TERRAIN_PATCH_RESOLUTION quads per side
+    Patch m_halfPatch;  // Half the quads, for quadrants drawn with their parent's detail
+
+    GLuint m_nodesSSBO = 0;
+    size_t m_nodesCapacity = 0;
+    std::vector<TerrainNodeGPU> m_fullNodes;
+    std::vector<TerrainNodeGPU> m_halfNodes;
+
+    // The shadow nodes only change with the terrain, not with the camera
+    TerrainLOD m_shadowLOD;
+    TerrainLODSettings m_shadowLODSettings{};
+    GLuint m_shadowNodesSSBO = 0;
+    size_t m_shadowNodesCapacity = 0;
+    std::vector<TerrainNodeGPU> m_shadowNodes;
+    bool m_shadowNodesValid = false;
 };
 
 int bee::TerrainRenderer::Impl::SamplerTypeToGL(bee::Sampler::Filter filter)
@@ -57,19 +95,132 @@ int bee::TerrainRenderer::Impl::SamplerTypeToGL(bee::Sampler::Wrap wrap)
     return 0;
 }
 
+void bee::TerrainRenderer::Impl::CreatePatch(Patch& patch, uint32_t resolution)
+{
+    // Unit grid, positioned and scaled per node in the vertex shader
+    const uint32_t width = resolution + 1;
+    std::vector<glm::vec2> vertices;
+    vertices.reserve(width * width);
+    for (uint32_t y = 0; y <= resolution; ++y)
+    {
+        for (uint32_t x = 0; x <= resolution; ++x)
+            vertices.emplace_back(static_cast<float>(x) / static_cast<float>(resolution), static_cast<float>(y) / static_cast<float>(resolution));
+    }
+
+    std::vector<uint32_t> indices;
+    indices.reserve(resolution * resolution * 6);
+    for (uint32_t y = 0; y < resolution; ++y)
+    {
+        for (uint32_t x = 0; x < resolution; ++x)
+        {
+            const uint32_t i = y * width + x;
+            indices.push_back(i);
+            indices.push_back(i + 1);
+            indices.push_back(i + width);
+            indices.push_back(i + 1);
+            indices.push_back(i + width + 1);
+            indices.push_back(i + width);
+        }
+    }
+    patch.indexCount = static_cast<uint32_t>(indices.size());
+
+    glCreateBuffers(1, &patch.vertexBuffer);
+    glNamedBufferData(patch.vertexBuffer, sizeof(glm::vec2) * vertices.size(), vertices.data(), GL_STATIC_DRAW);
+    glCreateBuffers(1, &patch.indexBuffer);
+    glNamedBufferData(patch.indexBuffer, sizeof(uint32_t) * indices.size(), indices.data(), GL_STATIC_DRAW);
+
+    glCreateVertexArrays(1, &patch.vao);
+    glVertexArrayVertexBuffer(patch.vao, 0, patch.vertexBuffer, 0, sizeof(glm::vec2));
+    glVertexArrayElementBuffer(patch.vao, patch.indexBuffer);
+    glEnableVertexArrayAttrib(patch.vao, POSITION_LOCATION);
+    glVertexArrayAttribFormat(patch.vao, POSITION_LOCATION, 2, GL_FLOAT, GL_FALSE, 0);
+    glVertexArrayAttribBinding(patch.vao, POSITION_LOCATION, 0);
+}
+
+void bee::TerrainRenderer::Impl::DeletePatch(Patch& patch)
+{
+    glDeleteVertexArrays(1, &patch.vao);
+    glDeleteBuffers(1, &patch.vertexBuffer);
+    glDeleteBuffers(1, &patch.indexBuffer);
+    patch = Patch{};
+}
+
+void bee::TerrainRenderer::Impl::UploadNodes(GLuint buffer, size_t& capacity, const std::vector<TerrainNodeGPU>& fullNodes,
+    const std::vector<TerrainNodeGPU>& halfNodes)
+{
+    // Half nodes follow the full ones, their draw starts at the full node count as base instance
+    const size_t count = fullNodes.size() + halfNodes.size();
+    if (count > capacity)
+    {
+        capacity = glm::max(count, capacity * 2);
+        glNamedBufferData(buffer, sizeof(TerrainNodeGPU) * capacity, nullptr, GL_DYNAMIC_DRAW);
+    }
+
+    if (!fullNodes.empty())
+        glNamedBufferSubData(buffer, 0, sizeof(TerrainNodeGPU) * fullNodes.size(), fullNodes.data());
+    if (!halfNodes.empty())
+        glNamedBufferSubData(buffer, sizeof(TerrainNodeGPU) * fullNodes.size(), sizeof(TerrainNodeGPU) * halfNodes.size(), halfNodes.data());
+}
+
+void bee::TerrainRenderer::Impl::BindHeightmap(Shader& shader, const TerrainChunk& chunk)
+{
+    glActiveTexture(GL_TEXTURE0 + 16);
+    glBindTexture(GL_TEXTURE_2D, chunk.heightmap.Retrieve()->handle);
+    glUniform1i(shader.GetParameter("s_heightmap")->GetLocation(), 16);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, SamplerTypeToGL(Sampler::Filter::Linear));
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, SamplerTypeToGL(Sampler::Filter::Linear));
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, SamplerTypeToGL(Sampler::Wrap::ClampToEdge));
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, SamplerTypeToGL(Sampler::Wrap::ClampToEdge));
+}
+
+void bee::TerrainRenderer::Impl::SetLODUniforms(Shader& shader, const TerrainLODSettings& settings,
+    const std::array<glm::vec2, TERRAIN_MAX_LOD_LEVELS>& morphRanges)
+{
+    shader.GetParameter("u_terrainMin")->SetValue(settings.terrainMin);
+    shader.GetParameter("u_terrainMax")->SetValue(settings.terrainMax);
+    glUniform2fv(shader.GetParameter("u_morphRanges[0]")->GetLocation(), TERRAIN_MAX_LOD_LEVELS, &morphRanges[0].x);
+}
+
+bee::TerrainLODSettings bee::TerrainRenderer::Impl::GetLODSettings(const TerrainChunk& chunk)
+{
+    // The chunk is centred on its transform, one heightmap tile is unitsPerTile wide
+    const glm::vec2 halfSize = glm::vec2(static_cast<float>(chunk.width), static_cast<float>(chunk.height)) * 0.5f * chunk.unitsPerTile;
+
+    TerrainLODSettings settings{};
+    settings.terrainMin = -halfSize;
+    settings.terrainMax = halfSize;
+    settings.maxHeight = chunk.heightModifier;
+    settings.heightfield = chunk.heightfield.get();
+    // A leaf has a vertex for every tile, tessellation adds the detail in between
+    settings.leafSize = static_cast<float>(TERRAIN_PATCH_RESOLUTION) * chunk.unitsPerTile;
+    settings.lodDistance = chunk.lodDistance;
+    return settings;
+}
+
 bee::TerrainRenderer::TerrainRenderer(const DebugData& debugFlags, const Material::IBL& ibl, uint32_t iblSpecularMipCount) 
     : m_impl(std::make_unique<Impl>()), m_debugFlags(debugFlags), m_ibl(ibl), m_iblSpecularMipCount(iblSpecularMipCount)
 {
     m_terrainPass = Engine.ShaderDB()[ShaderDB::Type::TERRAIN];
+
+    m_impl->CreatePatch(m_impl->m_fullPatch, TERRAIN_PATCH_RESOLUTION);
+    m_impl->CreatePatch(m_impl->m_halfPatch, TERRAIN_PATCH_RESOLUTION / 2);
+    glCreateBuffers(1, &m_impl->m_nodesSSBO);
+    glCreateBuffers(1, &m_impl->m_shadowNodesSSBO);
 }
 
-bee::TerrainRenderer::~TerrainRenderer() { }
+bee::TerrainRenderer::~TerrainRenderer()
+{
+    m_impl->DeletePatch(m_impl->m_fullPatch);
+    m_impl->DeletePatch(m_impl->m_halfPatch);
+    glDeleteBuffers(1, &m_impl->m_nodesSSBO);
+    glDeleteBuffers(1, &m_impl->m_shadowNodesSSBO);
+}
 
 void bee::TerrainRenderer::Submit(entt::entity entity) { }
 
 void bee::TerrainRenderer::CleanUp(entt::entity entity) { }
 
-void bee::TerrainRenderer::Render()
+void bee::TerrainRenderer::Render(const Camera& camera)
 {
     PushDebugGL("Terrain pass");
 
@@ -82,14 +233,9 @@ void bee::TerrainRenderer::Render()
     }
 
     // Create view of all chunks.
-    auto terrainChunkView = bee::Engine.ECS().Registry.view <const TerrainChunk, const bee::Transform, const bee::MeshRenderer>();
+    auto terrainChunkView = bee::Engine.ECS().Registry.view<const TerrainChunk, const bee::Transform, const bee::MeshRenderer>();
 
-    //Pick the first camera (TODO: add option to set a camera or a camera entity)
-    auto camera_view = Engine.ECS().Registry.view<Transform, CameraComponent>();
-    glm::mat4 camera_transform{};
-    if (camera_view.begin() != camera_view.end())
-        camera_transform = Engine.ECS().Registry.get<Transform>(camera_view.front()).World();
-    glm::vec4 eyePos = camera_transform[3];
+    const auto frustum = camera.GetFrustum();
 
     glPatchParameteri(GL_PATCH_VERTICES, 3);
 
@@ -98,26 +244,38 @@ void bee::TerrainRenderer::Render()
     {
         if (!chunk.heightmap.Valid()) continue;
 
-        glBindVertexArray(renderer.GetMesh().Retrieve()->vao_handle);
-
         glm::mat4 world = transform.World();
-        uint32_t indexCount = renderer.GetMesh().Retrieve()->index_count;
 
-        // Bind heightmap
-        glActiveTexture(GL_TEXTURE0 + 16);
-        glBindTexture(GL_TEXTURE_2D, chunk.heightmap.Retrieve()->handle);
-        glUniform1i(m_terrainPass->GetParameter("s_heightmap")->GetLocation(), 16);
-        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, m_impl->SamplerTypeToGL(Sampler::Filter::Linear));
-        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, m_impl->SamplerTypeToGL(Sampler::Filter::Linear));
-        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, m_impl->SamplerTypeToGL(Sampler::Wrap::ClampToEdge));
-        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, m_impl->SamplerTypeToGL(Sampler::Wrap::ClampToEdge));
+        // Select the nodes around the camera in the local space of the chunk
+        auto& lod = m_impl->m_lod;
+        const TerrainLODSettings settings = Impl::GetLODSettings(chunk);
+        if (settings != m_impl->m_lodSettings || lod.GetLevelCount() == 0)
+        {
+            lod.Configure(settings);
+            m_impl->m_lodSettings = settings;
+        }
+
+        const glm::vec3 eye = glm::vec3(glm::inverse(world) * glm::vec4(camera.GetPosition(), 1.0f));
+        lod.Select(eye, world, frustum, m_impl->m_fullNodes, m_impl->m_halfNodes);
+
+        const auto fullCount = static_cast<GLsizei>(m_impl->m_fullNodes.size());
+        const auto halfCount = static_cast<GLsizei>(m_impl->m_halfNodes.size());
+        if (fullCount + halfCount == 0) continue;
+
+        m_impl->UploadNodes(m_impl->m_nodesSSBO, m_impl->m_nodesCapacity, m_impl->m_fullNodes, m_impl->m_halfNodes);
+        glBindBufferBase(GL_SHADER_STORAGE_BUFFER, TERRAIN_NODES_SSBO_LOCATION, m_impl->m_nodesSSBO);
+
+        m_impl->BindHeightmap(*m_terrainPass, chunk);
+
+        // Vertex shader
+        m_impl->SetLODUniforms(*m_terrainPass, lod.GetSettings(), lod.GetMorphRanges());
+        m_terrainPass->GetParameter("u_eyePos")->SetValue(glm::vec4(eye, 1.0f));
 
         // Tessellation control shader
-        m_terrainPass->GetParameter("u_tessDist")->SetValue(chunk.tesselationDistance);
         m_terrainPass->GetParameter("u_tessFactorMax")->SetValue(chunk.tesselationFactor);
+        m_terrainPass->GetParameter("u_tessPixels")->SetValue(chunk.tessellationPixels);
         m_terrainPass->GetParameter("u_normalScale")->SetValue(chunk.normalScale);
         m_terrainPass->GetParameter("u_terrainSize")->SetValue(glm::vec2(chunk.width, chunk.height));
-        m_terrainPass->GetParameter("u_eyePos")->SetValue(eyePos);
         
         // Tessellation evaluation shader
         m_terrainPass->GetParameter("u_model")->SetValue(world);
@@ -127,7 +285,21 @@ void bee::TerrainRenderer::Render()
 
         Material::Apply(renderer.Material.Retrieve(), m_terrainPass, m_debugFlags, m_ibl, m_iblSpecularMipCount);
 
-        glDrawElements(GL_PATCHES, indexCount, GL_UNSIGNED_INT, 0);
+        // One instanced draw per patch resolution, every instance is a node
+        const auto& full = m_impl->m_fullPatch;
+        const auto& half = m_impl->m_halfPatch;
+        if (fullCount > 0)
+        {
+            m_terrainPass->GetParameter("u_gridResolution")->SetValue(static_cast<float>(TERRAIN_PATCH_RESOLUTION));
+            glBindVertexArray(full.vao);
+            glDrawElementsInstancedBaseInstance(GL_PATCHES, full.indexCount, GL_UNSIGNED_INT, nullptr, fullCount, 0);
+        }
+        if (halfCount > 0)
+        {
+            m_terrainPass->GetParameter("u_gridResolution")->SetValue(static_cast<float>(TERRAIN_PATCH_RESOLUTION / 2));
+            glBindVertexArray(half.vao);
+            glDrawElementsInstancedBaseInstance(GL_PATCHES, half.indexCount, GL_UNSIGNED_INT, nullptr, halfCount, fullCount);
+        }
     }
 
     glBindVertexArray(0);
@@ -141,48 +313,79 @@ void bee::TerrainRenderer::DepthOnlyRender(std::shared_ptr<bee::Shader> depthOnl
     depthOnlyShader->Activate();
 
     // Create view of all chunks.
-    auto terrainChunkView = bee::Engine.ECS().Registry.view <const TerrainChunk, const bee::Transform, const bee::MeshRenderer>();
+    auto terrainChunkView = bee::Engine.ECS().Registry.view<const TerrainChunk, const bee::Transform, const bee::MeshRenderer>();
 
     glPatchParameteri(GL_PATCH_VERTICES, 3);
 
-    //Pick the first camera (TODO: add option to set a camera or a camera entity)
-    auto camera_view = Engine.ECS().Registry.view<Transform, CameraComponent>();
-    glm::mat4 camera_transform{};
-    if (camera_view.begin() != camera_view.end())
-        camera_transform = Engine.ECS().Registry.get<Transform>(camera_view.front()).World();
-    glm::vec4 eyePos = camera_transform[3];
+    // Nothing morphs, every vertex stays on the grid of its level
+    std::array<glm::vec2, TERRAIN_MAX_LOD_LEVELS> noMorph;
+    noMorph.fill(glm::vec2(std::numeric_limits<float>::max()));
 
     // Iterate view for rendering.
     for (auto [e, chunk, transform, renderer] : terrainChunkView.each())
     {
         if (!chunk.heightmap.Valid()) continue;
 
-        glBindVertexArray(renderer.GetMesh().Retrieve()->vao_handle);
-
         glm::mat4 world = transform.World();
-        uint32_t indexCount = renderer.GetMesh().Retrieve()->index_count;
 
-        // Bind heightmap
-        glActiveTexture(GL_TEXTURE0 + 16);
-        glBindTexture(GL_TEXTURE_2D, chunk.heightmap.Retrieve()->handle);
-        glUniform1i(depthOnlyShader->GetParameter("s_heightmap")->GetLocation(), 16);
-        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, m_impl->SamplerTypeToGL(Sampler::Filter::Linear));
-        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, m_impl->SamplerTypeToGL(Sampler::Filter::Linear));
-        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, m_impl->SamplerTypeToGL(Sampler::Wrap::ClampToEdge));
-        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, m_impl->SamplerTypeToGL(Sampler::Wrap::ClampToEdge));
+        // Shadows use one uniform level over the whole chunk, slightly coarser than the finest one
+        auto& lod = m_impl->m_shadowLOD;
+        const TerrainLODSettings settings = Impl::GetLODSettings(chunk);
+        if (settings != m_impl->m_shadowLODSettings || !m_impl->m_shadowNodesValid)
+        {
+            lod.Configure(settings);
+            m_impl->m_shadowLODSettings = settings;
+            lod.SelectLevel(glm::min(1u, lod.GetLevelCount() - 1), m_impl->m_shadowNodes);
+            m_impl->UploadNodes(m_impl->m_shadowNodesSSBO, m_impl->m_shadowNodesCapacity, m_impl->m_shadowNodes, {});
+            m_impl->m_shadowNodesValid = true;
+        }
 
-        // Tessellation control shader
-        depthOnlyShader->GetParameter("u_tessDist")->SetValue(chunk.tesselationDistance);
-        depthOnlyShader->GetParameter("u_tessFactorMax")->SetValue(chunk.tesselationFactor);
-        depthOnlyShader->GetParameter("u_eyePos")->SetValue(eyePos);
+        const auto count = static_cast<GLsizei>(m_impl->m_shadowNodes.size());
+        if (count == 0) continue;
+
+        glBindBufferBase(GL_SHADER_STORAGE_BUFFER, TERRAIN_NODES_SSBO_LOCATION, m_impl->m_shadowNodesSSBO);
+
+        m_impl->BindHeightmap(*depthOnlyShader, chunk);
+
+        // Vertex shader
+        m_impl->SetLODUniforms(*depthOnlyShader, lod.GetSettings(), noMorph);
+        depthOnlyShader->GetParameter("u_gridResolution")->SetValue(static_cast<float>(TERRAIN_PATCH_RESOLUTION));
+
+        // Tessellation control shader, no view dependent tessellation so cached shadow maps stay valid
+        depthOnlyShader->GetParameter("u_tessFactorMax")->SetValue(1.0f);
+        depthOnlyShader->GetParameter("u_tessPixels")->SetValue(chunk.tessellationPixels);
 
         // Tessellation evaluation shader
         depthOnlyShader->GetParameter("u_model")->SetValue(world);
         depthOnlyShader->GetParameter("u_heightModifier")->SetValue(chunk.heightModifier);
 
-        glDrawElements(GL_PATCHES, indexCount, GL_UNSIGNED_INT, 0);
+        glBindVertexArray(m_impl->m_fullPatch.vao);
+        glDrawElementsInstancedBaseInstance(GL_PATCHES, m_impl->m_fullPatch.indexCount, GL_UNSIGNED_INT, nullptr, count, 0);
     }
 
     glBindVertexArray(0);
     depthOnlyShader->Deactivate();
 }
+
+bool bee::TerrainRenderer::GetBounds(glm::vec3& minBounds, glm::vec3& maxBounds) const
+{
+    minBounds = glm::vec3(std::numeric_limits<float>::max());
+    maxBounds = glm::vec3(std::numeric_limits<float>::lowest());
+
+    auto terrainChunkView = bee::Engine.ECS().Registry.view<const TerrainChunk, const bee::Transform>();
+    for (auto [e, chunk, transform] : terrainChunkView.each())
+    {
+        // The vertex shader places the nodes over the chunk extents and displaces them by the heightmap
+        const TerrainLODSettings settings = Impl::GetLODSettings(chunk);
+        const glm::vec2 heightRange = chunk.heightfield ? chunk.heightfield->GetRange(glm::vec2(0.0f), glm::vec2(1.0f)) : glm::vec2(0.0f, 1.0f);
+        const glm::vec3 start(settings.terrainMin, heightRange.x * chunk.heightModifier);
+        const glm::vec3 end(settings.terrainMax, heightRange.y * chunk.heightModifier);
+
+        const BoundingBox local((start + end) * 0.5f, (end - start) * 0.5f);
+        const BoundingBox world = local.ApplyTransform(transform.World());
+        minBounds = glm::min(minBounds, world.GetStart());
+        maxBounds = glm::max(maxBounds, world.GetEnd());
+    }
+
+    return glm::all(glm::lessThanEqual(minBounds, maxBounds));
+}
@@ -0,0 +1,107 @@
+#include <precompiled/engine_precompiled.hpp>
+#include "wind/wind_field.hpp"
+
+namespace
+{
+// Must match shaders/wind.glsl
+constexpr float WIND_FIELD_FREQUENCY = 4.0f;
+constexpr float WIND_FIELD_DETAIL_FREQUENCY = 7.71f;
+constexpr glm::vec3 WIND_FIELD_DETAIL_OFFSET = glm::vec3(0.37f, 0.61f, 0.13f);
+constexpr float WIND_FIELD_DETAIL_WEIGHT = 0.35f;
+
+// Gradient of a lattice point, the same integer hash as shaders/noise/hash.glsl
+glm::vec3 Gradient(glm::ivec3 p, uint32_t seed)
+{
+    const uint32_t x = static_cast<uint32_t>(p.x);
+    const uint32_t y = static_cast<uint32_t>(p.y);
+    const uint32_t z = static_cast<uint32_t>(p.z) + seed * 1013u;
+
+    glm::uvec3 n(x * 127u + y * 311u + z * 74u,
+                 x * 269u + y * 183u + z * 246u,
+                 x * 113u + y * 271u + z * 124u);
+
+    n = (n << 13u) ^ n;
+    n = n * (n * n * 15731u + 789221u) + 1376312589u;
+    return -1.0f + 2.0f * glm::vec3(n & glm::uvec3(0x0fffffffu)) / static_cast<float>(0x0fffffff);
+}
+
+// Gradient noise whose lattice wraps every WIND_FIELD_PERIOD cells
+float PeriodicNoise(glm::vec3 x, uint32_t seed)
+{
+    const glm::ivec3 i = glm::ivec3(glm::floor(x));
+    const glm::vec3 f = x - glm::floor(x);
+    const glm::vec3 u = f * f * f * (f * (f * 6.0f - 15.0f) + 10.0f);
+
+    const auto corner = [&](int dx, int dy, int dz)
+    {
+        const glm::ivec3 lattice = (i + glm::ivec3(dx, dy, dz)) & glm::ivec3(bee::WIND_FIELD_PERIOD - 1);
+        return glm::dot(Gradient(lattice, seed), f - glm::vec3(dx, dy, dz));
+    };
+
+    const float x00 = glm::mix(corner(0, 0, 0), corner(1, 0, 0), u.x);
+    const float x10 = glm::mix(corner(0, 1, 0), corner(1, 1, 0), u.x);
+    const float x01 = glm::mix(corner(0, 0, 1), corner(1, 0, 1), u.x);
+    const float x11 = glm::mix(corner(0, 1, 1), corner(1, 1, 1), u.x);
+    return glm::mix(glm::mix(x00, x10, u.y), glm::mix(x01, x11, u.y), u.z);
+}
+}
+
+bee::WindField::WindField(uint32_t seed)
+{
+    static_assert((WIND_FIELD_PERIOD & (WIND_FIELD_PERIOD - 1)) == 0, "The lattice wraps with a mask");
+    static_assert(WIND_FIELD_SIZE % WIND_FIELD_PERIOD == 0, "Every cell has to cover whole texels");
+
+    constexpr float cellsPerTexel = static_cast<float>(WIND_FIELD_PERIOD) / static_cast<float>(WIND_FIELD_SIZE);
+
+    m_texels.resize(static_cast<size_t>(WIND_FIELD_SIZE) * WIND_FIELD_SIZE * WIND_FIELD_SIZE * 2);
+    size_t index = 0;
+    for (uint32_t z = 0; z < WIND_FIELD_SIZE; z++)
+    {
+        for (uint32_t y = 0; y < WIND_FIELD_SIZE; y++)
+        {
+            for (uint32_t x = 0; x < WIND_FIELD_SIZE; x++)
+            {
+                // Independent noise per channel, direction and strength
+                const glm::vec3 position = glm::vec3(x, y, z) * cellsPerTexel;
+                const glm::vec2 value(PeriodicNoise(position, seed * 2), PeriodicNoise(position, seed * 2 + 1));
+
+                const glm::vec2 unorm = glm::clamp(value * 0.5f + 0.5f, 0.0f, 1.0f);
+                m_texels[index++] = static_cast<uint8_t>(unorm.x * 255.0f + 0.5f);
+                m_texels[index++] = static_cast<uint8_t>(unorm.y * 255.0f + 0.5f);
+            }
+        }
+    }
+}
+
+glm::vec2 bee::WindField::Sample(glm::vec3 uvw) const
+{
+    // Texel centres sit at half texel offsets, like GL_LINEAR with GL_REPEAT
+    const glm::vec3 texel = uvw * static_cast<float>(WIND_FIELD_SIZE) - 0.5f;
+    const glm::vec3 base = glm::floor(texel);
+    const glm::vec3 t = texel - base;
+
+    constexpr int mask = static_cast<int>(WIND_FIELD_SIZE) - 1;
+    const glm::ivec3 p0 = glm::ivec3(base) & mask;
+    const glm::ivec3 p1 = (p0 + 1) & mask;
+
+    const auto fetch = [&](int x, int y, int z)
+    {
+        const size_t index = ((static_cast<size_t>(z) * WIND_FIELD_SIZE + y) * WIND_FIELD_SIZE + x) * 2;
+        return glm::vec2(m_texels[index], m_texels[index + 1]) / 255.0f;
+    };
+
+    const glm::vec2 x00 = glm::mix(fetch(p0.x, p0.y, p0.z), fetch(p1.x, p0.y, p0.z), t.x);
+    const glm::vec2 x10 = glm::mix(fetch(p0.x, p1.y, p0.z), fetch(p1.x, p1.y, p0.z), t.x);
+    const glm::vec2 x01 = glm::mix(fetch(p0.x, p0.y, p1.z), fetch(p1.x, p0.y, p1.z), t.x);
+    const glm::vec2 x11 = glm::mix(fetch(p0.x, p1.y, p1.z), fetch(p1.x, p1.y, p1.z), t.x);
+    const glm::vec2 value = glm::mix(glm::mix(x00, x10, t.y), glm::mix(x01, x11, t.y), t.z);
+
+    return value * 2.0f - 1.0f;
+}
+
+glm::vec2 bee::WindField::SampleOctaves(glm::vec3 coordinate) const
+{
+    const glm::vec2 base = Sample(coordinate * WIND_FIELD_FREQUENCY);
+    const glm::vec2 detail = Sample(coordinate * WIND_FIELD_DETAIL_FREQUENCY + WIND_FIELD_DETAIL_OFFSET);
+    return (base + detail * WIND_FIELD_DETAIL_WEIGHT) / (1.0f + WIND_FIELD_DETAIL_WEIGHT);
+}
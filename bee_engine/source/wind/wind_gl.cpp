@@ -6,8 +6,9 @@
 #include "resources/image/image_loader.hpp"
 #include "resources/image/image_gl.hpp"
 #include "resources/resource_manager.hpp"
-#include "rendering/shader.hpp"
+#include "platform/opengl/shader_gl.hpp"
 #include "rendering/shader_db.hpp"
+#include "tools/log.hpp"
 
 #include "../assets/shaders/locations.glsl"
 
@@ -31,18 +32,17 @@ bee::WindMap::WindMap()
     glBufferData(GL_UNIFORM_BUFFER, sizeof(m_ambientWind), &m_ambientWind, GL_STATIC_READ);
     glBindBufferBase(GL_UNIFORM_BUFFER, AMBIENT_WIND_LOCATION, m_impl->m_ambientWindUBO);
 
-    auto compShader = Engine.ShaderDB().Get(bee::ShaderDB::Type::POPULATE_3DTEX_PERLIN);
+    // A small tileable volume, sampled at several octaves in the shaders
+    const auto& texels = m_field.GetTexels();
+    m_wind = Engine.Resources().Images().FromRawData(texels.data(), ImageFormat::RG8, WIND_FIELD_SIZE, WIND_FIELD_SIZE, WIND_FIELD_SIZE);
 
-    const uint32_t size{ 512 };
-    m_wind = Engine.Resources().Images().FromRawData(nullptr, ImageFormat::RGBA8, size, size, 1);
-    compShader->Activate();
-    glActiveTexture(GL_TEXTURE0);
     glBindTexture(GL_TEXTURE_3D, m_wind.Retrieve()->handle);
-    glBindImageTexture(0, m_wind.Retrieve()->handle, 0, GL_TRUE, 0, GL_READ_WRITE, GL_RGBA8);
-    glDispatchCompute(size / 8, size / 8, size / 8);
-    glMemoryBarrier(GL_SHADER_IMAGE_ACCESS_BARRIER_BIT);
-
-    compShader->Deactivate();
+    glTexParameteri(GL_TEXTURE_3D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
+    glTexParameteri(GL_TEXTURE_3D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+    glTexParameteri(GL_TEXTURE_3D, GL_TEXTURE_WRAP_S, GL_REPEAT);
+    glTexParameteri(GL_TEXTURE_3D, GL_TEXTURE_WRAP_T, GL_REPEAT);
+    glTexParameteri(GL_TEXTURE_3D, GL_TEXTURE_WRAP_R, GL_REPEAT);
+    glBindTexture(GL_TEXTURE_3D, 0);
 }
 
 bee::WindMap::~WindMap()
@@ -53,4 +53,70 @@ bee::WindMap::~WindMap()
 bee::ResourceHandle<bee::Image3D> bee::WindMap::GetWindImage()
 {
 	return m_wind;
-}
\ No newline at end of file
+}
+
+bee::WindMap::WindAmbient bee::WindMap::GetWindParameters()
+{
+    return m_ambientWind;
+}
+
+glm::vec3 bee::WindMap::GetWindMovement(glm::vec2 coordinate, float time) const
+{
+    const glm::vec2 scrollDirection(-std::sin(m_ambientWind.direction), std::cos(m_ambientWind.direction));
+    const glm::vec2 scroll = scrollDirection * time * m_ambientWind.speed;
+
+    const glm::vec2 noise = m_field.SampleOctaves(glm::vec3(coordinate + scroll, time * WIND_FIELD_EVOLUTION));
+    const float angle = m_ambientWind.direction + noise.x * 0.25f;
+    const float strength = (noise.y * 0.5f + 0.5f) * m_ambientWind.strength + 0.5f;
+
+    return glm::vec3(std::cos(angle), std::sin(angle), 0.0f) * strength;
+}
+
+bool bee::WindMap::CheckShader()
+{
+    // Texture filtering blends with 8 bit weights, the pushes only agree up to that
+    constexpr float TOLERANCE = 0.02f;
+    constexpr uint32_t GRID_SIZE = 32;
+
+    struct WindSample
+    {
+        glm::vec4 coordinate;
+        glm::vec4 movement;
+    };
+
+    // An uneven spacing so the samples cross texel, cell and tile borders of both octaves
+    std::vector<WindSample> samples(GRID_SIZE * GRID_SIZE);
+    for (uint32_t i = 0; i < samples.size(); i++)
+        samples[i].coordinate = glm::vec4(glm::vec2(i % GRID_SIZE, i / GRID_SIZE) * 0.0731f + 0.013f, 0.0f, 0.0f);
+
+    GLuint buffer = 0;
+    glCreateBuffers(1, &buffer);
+    glNamedBufferData(buffer, sizeof(WindSample) * samples.size(), samples.data(), GL_DYNAMIC_READ);
+    glBindBufferBase(GL_SHADER_STORAGE_BUFFER, WIND_CHECK_SSBO_LOCATION, buffer);
+    glBindTextureUnit(WIND_SAMPLER_LOCATION, m_wind.Retrieve()->handle);
+
+    Engine.ShaderDB()[ShaderDB::Type::WIND_CHECK]->Activate();
+    glDispatchCompute((static_cast<GLuint>(samples.size()) + 63) / 64, 1, 1);
+    glMemoryBarrier(GL_BUFFER_UPDATE_BARRIER_BIT);
+
+    glGetNamedBufferSubData(buffer, 0, sizeof(WindSample) * samples.size(), samples.data());
+    glDeleteBuffers(1, &buffer);
+
+    float largestError = 0.0f;
+    for (const WindSample& sample : samples)
+    {
+        const glm::vec3 expected = GetWindMovement(glm::vec2(sample.coordinate), sample.movement.w);
+        const float error = glm::length(glm::vec3(sample.movement) - expected);
+        if (error > TOLERANCE)
+        {
+            Log::Warn("Wind mismatch at ({}, {}) and {}s: the shader pushes ({}, {}, {}), the CPU ({}, {}, {})", sample.coordinate.x,
+                sample.coordinate.y, sample.movement.w, sample.movement.x, sample.movement.y, sample.movement.z, expected.x, expected.y,
+                expected.z);
+            return false;
+        }
+        largestError = glm::max(largestError, error);
+    }
+
+    Log::Info("Wind matches shaders/wind.glsl at {} samples, largest difference {}", samples.size(), largestError);
+    return true;
+}
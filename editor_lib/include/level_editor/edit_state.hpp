@@ -7,6 +7,7 @@
 
 #include <cereal/cereal.hpp>
 #include <cereal/types/vector.hpp>
+#include <tools/serialization.hpp>
 
 namespace bee {
 
@@ -28,8 +29,9 @@ struct EditState {
 		int mapSizeY = 256;
 		int unitsPerTile = 1; //TODO: currently doesnt work with grass
 
-		float tesselationDistance = 50.0f;
+		float lodDistance = 50.0f;
 		float tesselationModifier = 8.0f;
+		float tessellationPixels = 8.0f;
 		float heightScale = 2.0f;
 	};
 
@@ -56,6 +58,7 @@ struct EditState {
 		
 		bool collectable = false;
 		bool partOfSequence = false;
+		bool useImpostors = false;
 
 		bool propDirty = false;
 	};
@@ -92,6 +95,7 @@ void save(A& archive, const EditState::PropEditState& desc)
 	archive(cereal::make_nvp("GenerateCollidableMesh", desc.generateCollidableMesh));
 	archive(cereal::make_nvp("Collectable", desc.collectable));
 	archive(cereal::make_nvp("HiddenUntilSequence", desc.partOfSequence));
+	archive(cereal::make_nvp("UseImpostors", desc.useImpostors));
 	archive(cereal::make_nvp("AdjustSlopePercentage", desc.adjustSlopePercentage));
 	archive(cereal::make_nvp("MaxBendFactor", desc.distanceMaxBend));
 	archive(cereal::make_nvp("BendHeightPercentage", desc.displacementHeightPercent));
@@ -121,6 +125,7 @@ void load(A& archive, EditState::PropEditState& desc)
 	archive(cereal::make_nvp("GenerateCollidableMesh", desc.generateCollidableMesh));
 	archive(cereal::make_nvp("Collectable", desc.collectable));
 	archive(cereal::make_nvp("HiddenUntilSequence", desc.partOfSequence));
+	LoadOptional(archive, "UseImpostors", desc.useImpostors);
 	archive(cereal::make_nvp("MaxBendFactor", desc.distanceMaxBend));
 	archive(cereal::make_nvp("AdjustSlopePercentage", desc.adjustSlopePercentage));
 	archive(cereal::make_nvp("BendHeightPercentage", desc.displacementHeightPercent));
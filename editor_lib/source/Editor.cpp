@@ -13,6 +13,8 @@
 
 #include <core/engine.hpp>
 #include <core/ecs.hpp>
+#include <core/time.hpp>
+#include <physics/physics_system.hpp>
 #include <rendering/debug_render.hpp>
 #include <file_dialog/windows_file_dialog.hpp>
 #include <tools/log.hpp>
@@ -223,6 +225,27 @@ void bee::Editor::UpdateSystems(BlossomGame& game, float dt)
             }
         
             Engine.DebugRenderer().SetCategoryFlags(currentFlags);
+
+            ImGui::Separator();
+
+            auto& physics = Engine.GetPhysics();
+
+            if (ImGui::MenuItem("Save Physics State"))
+            {
+                physics.SaveSnapshot();
+            }
+
+            if (ImGui::MenuItem("Restore Physics State", nullptr, false, !physics.GetSnapshot().IsEmpty()))
+            {
+                physics.RestoreSnapshot();
+            }
+
+            if (ImGui::MenuItem("Check Physics Determinism"))
+            {
+                // Five seconds of fixed steps with scripted input, the result is logged
+                const float fixedTimeStep = Engine.GetTime().GetFixedTimeStep().count() / 1000.0f;
+                game.CheckDeterminism(static_cast<uint32_t>(5.0f / fixedTimeStep));
+            }
         
             ImGui::EndMenu();
         }
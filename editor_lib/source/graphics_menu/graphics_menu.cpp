@@ -9,6 +9,7 @@
 #include <glm/gtc/type_ptr.hpp>
 #include <tools/log.hpp>
 #include <rendering/render.hpp>
+#include <grass/grass_manager.hpp>
 #include <rendering/post_process/post_process_manager.hpp>
 #include "rendering/model_renderer.hpp"
 
@@ -111,6 +112,33 @@ void bee::GraphicsMenu::DrawPostProcessingMenu(std::shared_ptr<Level> level)
 		ImGui::SliderFloat("Blur strength", &data.BlurStrength, 0.0f, 1.0f);
 		ImGui::SliderFloat("Dither distance", &Engine.Renderer().GetDitherDistance(), 0.0f, 10.0f);
 
+		ImGui::Text("Shadows");
+
+		CascadeSettings& cascades = Engine.Renderer().GetCascadeSettings();
+		ImGui::Checkbox("Shadow caching", &Engine.Renderer().GetShadowCaching());
+
+		const char* schemes[] = { "Uniform", "Logarithmic", "Practical" };
+		int scheme = static_cast<int>(cascades.scheme);
+		if (ImGui::Combo("Cascade splits", &scheme, schemes, IM_ARRAYSIZE(schemes)))
+			cascades.scheme = static_cast<CascadeSplitScheme>(scheme);
+		if (cascades.scheme == CascadeSplitScheme::Practical)
+			ImGui::SliderFloat("Split lambda", &cascades.splitLambda, 0.0f, 1.0f);
+
+		ImGui::SliderFloat("Shadow distance", &cascades.shadowDistance, 10.0f, 1000.0f);
+
+		int cascadeCount = static_cast<int>(cascades.cascadeCount);
+		if (ImGui::SliderInt("Cascades", &cascadeCount, 1, static_cast<int>(MAX_SHADOW_CASCADES)))
+			cascades.cascadeCount = static_cast<uint32_t>(cascadeCount);
+
+		const char* resolutions[] = { "512", "1024", "2048", "4096" };
+		int resolution = glm::clamp(static_cast<int>(glm::log2(static_cast<float>(cascades.resolution))) - 9, 0, 3);
+		if (ImGui::Combo("Shadow resolution", &resolution, resolutions, IM_ARRAYSIZE(resolutions)))
+			cascades.resolution = 512u << resolution;
+
+		int snapTexels = static_cast<int>(cascades.snapTexels);
+		if (ImGui::SliderInt("Snap texels", &snapTexels, 1, 64))
+			cascades.snapTexels = static_cast<uint32_t>(snapTexels);
+
 		ImGui::TreePop();
 	}
 }
@@ -145,6 +173,31 @@ void bee::GraphicsMenu::DrawGrassMenu(std::shared_ptr<Level> level)
         }
 		ImGui::Indent(-12);
 
+		ImGui::Separator();
+
+		GrassQualitySettings& quality = level->GetGrass().quality;
+		bool qualityChanged = false;
+		for (size_t i = 0; i < quality.lodDistances.size(); i++)
+		{
+			// The distance is where the next LOD takes over
+			const std::string lod = "LOD " + std::to_string(i);
+			qualityChanged |= ImGui::DragFloat((lod + " end distance").c_str(), &quality.lodDistances[i], 0.5f, 0.0f, quality.drawDistance);
+			qualityChanged |= ImGui::SliderFloat((lod + " density").c_str(), &quality.lodDensities[i], 0.0f, 1.0f);
+		}
+		qualityChanged |= ImGui::DragFloat("Draw distance", &quality.drawDistance, 1.0f, 16.0f, 1024.0f);
+		qualityChanged |= ImGui::Checkbox("Adapt to frame time", &quality.adaptive);
+		qualityChanged |= ImGui::DragFloat("Target frame time (ms)", &quality.targetFrameTime, 0.1f, 1.0f, 100.0f);
+		qualityChanged |= ImGui::DragFloatRange2("Quality scale", &quality.minScale, &quality.maxScale, 0.01f, 0.05f, 2.0f);
+		qualityChanged |= ImGui::SliderFloat("Min density", &quality.minDensity, 0.0f, 1.0f);
+
+		const auto& controller = Engine.GetGrassManager().GetQuality();
+		ImGui::Text("GPU frame %.2f ms, grass quality %.2f", controller.GetSmoothedFrameTime(), controller.GetScale());
+
+		if (qualityChanged)
+		{
+			Engine.GetGrassManager().SetQualitySettings(quality);
+		}
+
 		if (changed)
 		{
 			level->GenerateGrass();
@@ -174,6 +227,13 @@ void bee::GraphicsMenu::DrawLODsMenu(std::shared_ptr<Level> level)
 
         }
 
+        ImGui::SliderFloat("Impostor distance", &lods.impostorDistance, 0.0f, 500.0f);
+        ImGui::SliderFloat("HLOD distance", &lods.hlodDistance, 0.0f, 1000.0f);
+        ImGui::SliderFloat("HLOD cell size", &lods.hlodCellSize, 8.0f, 256.0f);
+
+        if (ImGui::Button("Rebake HLODs"))
+            level->GenerateHLODs();
+
         ImGui::TreePop();
     }
 }
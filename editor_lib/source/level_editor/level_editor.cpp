@@ -66,6 +66,9 @@ void bee::LevelEditor::LoadFromFile(BlossomGame& game, cereal::JSONInputArchive*
 	{
 		auto& terrainData = level->GetTerrain();
 		m_editState.terrainEdit.heightScale = terrainData.heightScale;
+		m_editState.terrainEdit.lodDistance = terrainData.lodDistance;
+		m_editState.terrainEdit.tesselationModifier = terrainData.tesselationModifier;
+		m_editState.terrainEdit.tessellationPixels = terrainData.tessellationPixels;
 		m_editState.terrainEdit.mapSizeX = terrainData.mapSizeX;
 		m_editState.terrainEdit.mapSizeY = terrainData.mapSizeY;
 
@@ -201,6 +204,16 @@ void bee::LevelEditor::TerrainSettingsMenu()
 	if (ImGui::DragFloat("Terrain Height Scale", &terrainSettings.heightScale))
 		edited = true;
 
+	//Edit level of detail
+	if (ImGui::DragFloat("Finest LOD Distance", &terrainSettings.lodDistance, 1.0f, 1.0f, 1000.0f))
+		edited = true;
+
+	if (ImGui::DragFloat("Max Tessellation Factor", &terrainSettings.tesselationModifier, 0.1f, 1.0f, 64.0f))
+		edited = true;
+
+	if (ImGui::DragFloat("Tessellation Edge Pixels", &terrainSettings.tessellationPixels, 0.1f, 1.0f, 64.0f))
+		edited = true;
+
 	//Edit heightmap
 
 	if (DisplayTextureField("Heightmap", terrainSettings.terrainHeighMapPath))
@@ -363,6 +376,11 @@ void bee::LevelEditor::PropSettingsMenu(EditState::PropEditState& prop)
 			edited = true;
 		}
 
+		if (ImGui::Checkbox("Use impostors at distance", &prop.useImpostors))
+		{
+			edited = true;
+		}
+
 		if (prop.generateWindMask)
 		{
 			if (ImGui::DragFloat("Trunk height percentage", &prop.displacementHeightPercent, 0.1f, 0.0f, 1.0f))
@@ -388,12 +406,12 @@ bool bee::LevelEditor::BakeTerrain(std::shared_ptr<Level> level) const
 	terrainData.mapSizeX = m_editState.terrainEdit.mapSizeX;
 	terrainData.mapSizeY = m_editState.terrainEdit.mapSizeY;
 	terrainData.heightScale = m_editState.terrainEdit.heightScale;
+	terrainData.lodDistance = m_editState.terrainEdit.lodDistance;
+	terrainData.tesselationModifier = m_editState.terrainEdit.tesselationModifier;
+	terrainData.tessellationPixels = m_editState.terrainEdit.tessellationPixels;
 	
-	auto& image_loader = Engine.Resources().Images();
-
 	try {
-		terrainData.heightMap = image_loader
-			.FromFile(bee::FileIO::Directory::Asset, m_editState.terrainEdit.terrainHeighMapPath.string(), ImageFormat::RGBA8);
+		terrainData.LoadHeightMap(m_editState.terrainEdit.terrainHeighMapPath.string());
 	}
 	catch (std::exception& e) {
 		Log::Error("Generating Terrain: {}", e.what());
@@ -471,6 +489,7 @@ bool bee::LevelEditor::BakeProp(std::shared_ptr<Level> level, size_t prop_index)
 	levelPropDescription.generateCollidableMesh = editorPropDescription.generateCollidableMesh;
 	levelPropDescription.collectable = editorPropDescription.collectable;
 	levelPropDescription.partOfSequence = editorPropDescription.partOfSequence;
+	levelPropDescription.useImpostors = editorPropDescription.useImpostors;
 
 	auto& image_loader = Engine.Resources().Images();
 	try {
@@ -516,5 +535,6 @@ bool bee::LevelEditor::BakeProp(std::shared_ptr<Level> level, size_t prop_index)
 	}
 
 	level->GenerateProp(prop_index);
+	level->GenerateHLODs();
 	return true;
 }
@@ -207,7 +207,6 @@ entt::id_type reflect_component() {
 bee::SceneViewer::SceneViewer()
 {
 	REFLECT(Transform);
-	REFLECT(GrassChunk);
 	REFLECT(MeshRenderer);
 	REFLECT(Light);
 	REFLECT(RigidBody);
@@ -485,6 +484,9 @@ void bee::SceneViewer::DrawTransformGizmo()
 		transform->SetTranslation(translation);
 		transform->SetRotation(rotation);
 		transform->SetScale(scale);
+
+		// Lets colliders and sensors follow the gizmo
+		Engine.ECS().Registry.patch<Transform>(m_selectedEntity);
 	}
 }
 
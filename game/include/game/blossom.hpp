@@ -11,6 +11,8 @@ namespace bee
 {
 
 class Level;
+struct PlayerInput;
+struct TerrainSampleBuffers;
 
 #if defined(BEE_EDITOR)
 class Editor;
@@ -23,6 +25,11 @@ public:
     ~BlossomGame();
 
     void Update(float dt);
+
+    // Runs the fixed steps of the current level twice with scripted player input, from the current state, and
+    // compares the physics and gameplay state of both runs bit for bit. Nothing is rendered, the game is back in
+    // its current state afterwards.
+    bool CheckDeterminism(uint32_t steps);
    
     //Opens level based on filename, except if filename is empty, where a new level (default) is created
     //Return true if the level was loaded successfully, false otherwise.
@@ -53,6 +60,9 @@ private:
     ResourceHandle<Image> m_exitButton;
     ResourceHandle<Image> m_exitButtonHovered;
 
+    // Gameplay systems of one fixed step, the physics world is advanced separately
+    void FixedStep(const PlayerInput& input, float fixedTimeStep);
+
     void ShowMainMenu();
     void CheckWinCondition();
     bool victory = false;
@@ -68,6 +78,7 @@ private:
     void UpdateHUD(float dt);
 
     std::shared_ptr<Level> m_currentLevel;
+    std::unique_ptr<TerrainSampleBuffers> m_terrainSamples;
     State m_state{};
     bool m_freeCamEnabled = false;
 
@@ -8,10 +8,13 @@
 #include <vector>
 
 #include "grass/grass_chunk.hpp"
+#include "grass/grass_quality.hpp"
 
 namespace bee {
 
+class StaticBodyBatch;
 class TerrainCollider;
+class TerrainHeightfield;
 
 class Level {
 public:
@@ -52,16 +55,20 @@ public:
 
 	struct TerrainDescription
 	{
+		// Decodes the heightmap once, the texture is uploaded from the heightfield
+		void LoadHeightMap(const std::string& path);
+
 		ResourceHandle<Image> heightMap;
+		std::shared_ptr<const TerrainHeightfield> heightfield;
 		ResourceHandle<Material> terrainMaterial;
-		ResourceHandle<Mesh> generatedMesh;
 
 		int mapSizeX = 256; // TODO: doesnt work with non square sizes
 		int mapSizeY = 256;
 		int unitsPerTile = 1; //TODO: currently doesnt work with grass
 
-		float tesselationDistance = 50.0f;
-		float tesselationModifier = 8.0f;
+		float lodDistance = 50.0f;          // Range of the finest terrain LOD level, was "TesselationDistance"
+		float tesselationModifier = 8.0f;   // Maximum tessellation factor of a patch edge
+		float tessellationPixels = 8.0f;    // Screen space length a tessellated edge aims for
 		float heightScale = 2.0f;
 	};
 
@@ -70,6 +77,7 @@ public:
 		ResourceHandle<Image> grassColour;
 		ResourceHandle<Image> grassDensityMap;
 		GrassChunkMaterial material;
+		GrassQualitySettings quality;
 	};
 
 	struct PropDescription
@@ -84,11 +92,19 @@ public:
 		bool generateCollidableMesh = false;
 		bool collectable = false;
 		bool partOfSequence = false;
+
+		//Swaps distant instances to a baked impostor billboard
+		bool useImpostors = false;
 	};
 
 	struct LODDescription
     {
         std::array<float, 2> distances{};
+        float impostorDistance = 150.0f;
+
+        // Beyond this distance whole cells of static props are drawn as one merged proxy mesh
+        float hlodDistance = 300.0f;
+        float hlodCellSize = 64.0f;
     };
 
 	// Generates the default level
@@ -110,7 +126,7 @@ public:
 	auto& GetLODs() { return m_lods; }
 
 	void GenerateAll() {
-		GenerateTerrain(); GenerateGrass(); GenerateLighting(); GenerateAllProps();
+		GenerateTerrain(); GenerateGrass(); GenerateLighting(); GenerateAllProps(); GenerateHLODs();
 	}
 
 	void GenerateTerrain();
@@ -119,14 +135,17 @@ public:
 	//Updates skybox
 	void GenerateLighting();
 
-	void GenerateAllProps() {
-		for (size_t i = 0; i < m_props.size(); i++) GenerateProp(i);
-	}
+	// The colliders of all props are added to the physics system together
+	void GenerateAllProps();
 
 	struct ModelTag { size_t index; };
 	void GenerateProp(size_t prop_index);
 	void ClearProp(size_t prop_index);
 
+	// Bakes merged proxies of the static props per cell, call after the props are generated
+	void GenerateHLODs();
+	void ClearHLODs();
+
 	//Serialization
 	void SaveToArchive(JSONSaver& archive);
 
@@ -137,6 +156,8 @@ public:
 
 private:
 
+	void GenerateProp(size_t prop_index, StaticBodyBatch& colliders);
+
 	std::string m_originPath{};
 
 	LightingDescription m_lighting;
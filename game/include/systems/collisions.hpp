@@ -17,25 +17,14 @@ public:
     std::vector<JPH::BodyID> collidedBodies;
 };
 
-class BodyCollisionCollector : public JPH::CollideShapeCollector
+// Scratch buffers of TerrainCollisionHandlingSystem, the caller keeps them so they are reused between fixed steps
+struct TerrainSampleBuffers
 {
-public:
-
-    struct Data
-    {
-        glm::vec3 normal;
-        float magnitude;
-    };
-
-    virtual void AddHit(const ResultType& inResult) override;
-    bool Collided();
-
-    std::vector<Data> results;
-
-    float totalMagnitude = 0;
+    std::vector<glm::vec3> positions;
+    std::vector<float> heights;
 };
 
 void PhysicsTest();
-void TerrainCollisionHandlingSystem(std::shared_ptr<Level> level, float dt);
+void TerrainCollisionHandlingSystem(std::shared_ptr<Level> level, TerrainSampleBuffers& buffers, float dt);
 
 }
\ No newline at end of file
@@ -20,6 +20,9 @@ public:
 private:
     static void OnPatch(entt::registry& registry, entt::entity entity);
     static void OnDestroy(entt::registry& registry, entt::entity entity);
+
+    // Copies DynamicShadowCaster to the children of the entity, so the mesh pass reads it without walking up
+    static void OnShadowCasterConstruct(entt::registry& registry, entt::entity entity);
 };
 
 template<typename A>
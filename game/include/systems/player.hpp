@@ -54,9 +54,20 @@ struct Player
     int scoreCap = 10;
 };
 
+// Controls of the player for one fixed step
+struct PlayerInput
+{
+    float throttle = 0.0f;       // 0 to 1
+    bool boost = false;
+    glm::vec3 rotation{ 0.0f };  // Euler angles added to the pull of the player
+};
+
 void UpdatePlayerControlInversion();
 
-void PlayerMovementSystem(std::shared_ptr<Level> level, float dt);
+// Reads the gamepad when one is active, the mouse otherwise
+PlayerInput GetPlayerInput(float dt);
+
+void PlayerMovementSystem(std::shared_ptr<Level> level, const PlayerInput& input, float dt);
 
 }
 
@@ -14,6 +14,14 @@ struct POIComponent {
 	bool started = false;
 	bool completed = false;
 	ResourceHandle<Model> particleModel{};
+
+	// Keeps a sensor covering the start range on every POI
+	static void SubscribeToEvents();
+	static void UnsubscribeToEvents();
+
+private:
+	static void OnPatch(entt::registry& registry, entt::entity entity);
+	static void OnDestroy(entt::registry& registry, entt::entity entity);
 };
 
 void POISystem(float dt, int hiveAudioChannelID);
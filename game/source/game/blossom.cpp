@@ -5,7 +5,9 @@
 #include "core/engine.hpp"
 #include "core/input.hpp"
 #include "core/transform.hpp"
+#include "physics/character.hpp"
 #include "physics/physics_system.hpp"
+#include "physics/static_body_batch.hpp"
 #include "rendering/debug_render.hpp"
 #include "systems/player.hpp"
 #include "systems/player_camera.hpp"
@@ -25,6 +27,8 @@
 
 #include <rendering/render.hpp>
 #include <rendering/render_components.hpp>
+#include <rendering/impostor.hpp>
+#include <rendering/hlod.hpp>
 
 
 #include "grass/grass_manager.hpp"
@@ -46,18 +50,122 @@
 #include <systems/scale_in_system.hpp>
 #include <systems/orbiting_bee_system.hpp>
 #include <core/time.hpp>
+#include <core/transform_interpolation.hpp>
 #include <core/audio.hpp>
 
 #if defined(BEE_EDITOR)
 #include <../../editor_lib/include/Editor.hpp>
 #endif
 
+// True if the entity is part of a cell currently drawn as a merged HLOD proxy
+bool IsReplacedByHLOD(entt::registry& registry, entt::entity entity)
+{
+    auto* member = registry.try_get<bee::HLODMember>(entity);
+    if (!member || !registry.valid(member->cluster)) return false;
+
+    auto* cluster = registry.try_get<bee::HLODCluster>(member->cluster);
+    return cluster && cluster->active;
+}
+
+// Tags the meshes below a prop root while an impostor or HLOD proxy is drawn in its place.
+// Only called when one of its proxies switches, so the mesh pass can skip the tagged meshes in its view.
+void UpdateReplacedByProxy(entt::registry& registry, entt::entity root)
+{
+    if (!registry.valid(root)) return;
+
+    auto* impostor = registry.try_get<bee::Impostor>(root);
+    const bool replaced = (impostor && impostor->active) || IsReplacedByHLOD(registry, root);
+
+    std::vector<entt::entity> stack;
+    for (auto child : registry.get<bee::Transform>(root)) stack.push_back(child);
+    while (!stack.empty())
+    {
+        entt::entity entity = stack.back();
+        stack.pop_back();
+
+        if (replaced)
+            registry.emplace_or_replace<bee::TagReplacedByProxy>(entity);
+        else
+            registry.remove<bee::TagReplacedByProxy>(entity);
+
+        for (auto child : registry.get<bee::Transform>(entity)) stack.push_back(child);
+    }
+}
+
+// Calls the function with every value the fixed step systems change outside of the Jolt world, in storage order
+template <typename Function>
+void VisitFixedStepState(entt::registry& registry, Function&& function)
+{
+    for (auto&& [e, transform, body] : registry.view<bee::Transform, bee::RigidBody>().each())
+    {
+        function(transform.Translation);
+        function(transform.Rotation);
+        function(body.velocity);
+        function(body.acceleration);
+    }
+
+    for (auto&& [e, interpolated] : registry.view<bee::InterpolatedTransform>().each())
+    {
+        function(interpolated.previousTranslation);
+        function(interpolated.currentTranslation);
+        function(interpolated.previousRotation);
+        function(interpolated.currentRotation);
+    }
+
+    for (auto&& [e, player] : registry.view<bee::Player>().each())
+    {
+        function(player.eulerRadians);
+        function(player.pullEulerRadians);
+        function(player.speed);
+        function(player.boostTimer);
+    }
+
+    for (auto&& [e, displacer] : registry.view<bee::Displacer>().each())
+        function(displacer.radius);
+
+    for (auto&& [e, orbital, transform] : registry.view<bee::OrbitalMovementComponent, bee::Transform>().each())
+    {
+        function(orbital.orbitProgress);
+        function(transform.Translation);
+        function(transform.Rotation);
+    }
+}
+
+void SaveFixedStepState(entt::registry& registry, JPH::StateRecorder& recorder)
+{
+    VisitFixedStepState(registry, [&recorder](const auto& value) { recorder.Write(value); });
+
+    for (auto&& [e, character] : registry.view<bee::CharacterComponent>().each())
+        character.character->SaveState(recorder);
+}
+
+void RestoreFixedStepState(entt::registry& registry, JPH::StateRecorder& recorder)
+{
+    VisitFixedStepState(registry, [&recorder](auto& value) { recorder.Read(value); });
+
+    for (auto&& [e, character] : registry.view<bee::CharacterComponent>().each())
+        character.character->RestoreState(recorder);
+
+    // The poses were written directly
+    for (auto&& [e, transform] : registry.view<bee::Transform>().each())
+        transform.MarkDirty();
+}
+
+// Full throttle while steering in a slow wave, with a boost every few seconds
+bee::PlayerInput GetScriptedPlayerInput(uint32_t step)
+{
+    const float time = static_cast<float>(step);
+    return { 1.0f, step % 240 == 0, glm::vec3(0.01f * std::sin(time * 0.013f), 0.0f, 0.02f * std::sin(time * 0.007f)) };
+}
+
 bee::BlossomGame::BlossomGame()
 {
+    m_terrainSamples = std::make_unique<TerrainSampleBuffers>();
     Engine.DebugRenderer().SetCategoryFlags({}/*DebugCategory::Enum::Rendering*/);
     ModelRootComponent::SubscribeToEvents();
     PlayerStart::SubscribeToEvents();
     OrbitalSpawnerComponent::SubscribeToEvents();
+    POIComponent::SubscribeToEvents();
 
 #if defined(BEE_EDITOR)
     m_editor = std::make_unique<Editor>();
@@ -145,20 +253,16 @@ void bee::BlossomGame::Update(float dt)
 
         //Runs on Fixed Timestep
         {
-            auto view = Engine.ECS().Registry.view<Transform, RigidBody>();
+            auto& registry = Engine.ECS().Registry;
             auto fixedTimeStep = Engine.GetTime().GetFixedTimeStep().count() / 1000.0f;
 
+            //Fixed step systems continue from the simulated poses, not the blended ones that were rendered
+            BeginFixedSteps(registry);
+
             for (uint32_t i = 0; i < Engine.GetTime().GetFixedStepsNeeded(); i++)
-            {
-                if (!m_freeCamEnabled) {
-                    PlayerMovementSystem(m_currentLevel, fixedTimeStep);
-                }
-
-                for (auto&& [e, transform, body] : view.each())
-                    bee::UpdateRigidBody(body, transform, fixedTimeStep);
-                TerrainCollisionHandlingSystem(m_currentLevel, fixedTimeStep);
-                OrbitalParticleMovementSystem(fixedTimeStep);
-            }
+                FixedStep(GetPlayerInput(fixedTimeStep), fixedTimeStep);
+
+            InterpolateTransforms(registry, Engine.GetTime().GetFixedStepAlpha());
         }
 
         bool switchFreeCam =
@@ -195,12 +299,49 @@ void bee::BlossomGame::Update(float dt)
     break;
     }
 
-    auto meshRendererView = Engine.ECS().Registry.view<Transform, MeshRenderer>(entt::exclude<TerrainChunk, TagNoDraw>);
+    auto meshRendererView = Engine.ECS().Registry.view<Transform, MeshRenderer>(entt::exclude<TerrainChunk, TagNoDraw, TagReplacedByProxy>);
     auto cameraView = Engine.ECS().Registry.view<CameraComponent, Transform>();
     auto& cameraTransform = std::get<1>(cameraView[*cameraView.begin()]);
 
     auto& lodDistances = m_currentLevel->GetLODs();
 
+    // Prop roots whose impostor or HLOD proxy switched on or off this frame
+    std::vector<entt::entity> switchedProxies;
+
+    // Cells of static props far away are drawn as a single merged mesh
+    auto hlodView = Engine.ECS().Registry.view<HLODCluster>();
+    for (auto [entity, cluster] : hlodView.each())
+    {
+        const glm::vec3 cameraPosition = cameraTransform.GetTranslation();
+        const glm::vec3 closestPoint = glm::clamp(cameraPosition, cluster.minBounds, cluster.maxBounds);
+
+        const bool active = glm::distance(closestPoint, cameraPosition) > lodDistances.hlodDistance;
+        if (active != cluster.active)
+            switchedProxies.insert(switchedProxies.end(), cluster.members.begin(), cluster.members.end());
+
+        cluster.active = active;
+        if (cluster.active)
+            Engine.Renderer().QueueMesh(glm::mat4(1.0f), cluster.mesh, cluster.material, nullptr);
+    }
+
+    // Distant models are drawn as a single impostor billboard instead of their meshes
+    auto impostorView = Engine.ECS().Registry.view<Transform, Impostor>(entt::exclude<TagNoDraw>);
+    for (auto [entity, transform, impostor] : impostorView.each())
+    {
+        const glm::mat4& worldTransform = transform.World();
+        float distanceFromCamera = glm::distance(glm::vec3(worldTransform[3]), cameraTransform.GetTranslation());
+
+        const bool active = impostor.atlas && distanceFromCamera > lodDistances.impostorDistance && !IsReplacedByHLOD(Engine.ECS().Registry, entity);
+        if (active != impostor.active) switchedProxies.push_back(entity);
+
+        impostor.active = active;
+        if (impostor.active)
+            Engine.Renderer().QueueImpostor(worldTransform, impostor.atlas);
+    }
+
+    for (auto entity : switchedProxies)
+        UpdateReplacedByProxy(Engine.ECS().Registry, entity);
+
     for (auto [entity, transform, model] : meshRendererView.each())
     {
         glm::mat4 worldTransform = transform.World();
@@ -212,7 +353,8 @@ void bee::BlossomGame::Update(float dt)
             if (distanceFromCamera > lodDistances.distances[i])
                 model.ActiveLevel = i + 1;
 
-        Engine.Renderer().QueueMesh(worldTransform, model.GetMesh(), model.Material, &model);
+        Engine.Renderer().QueueMesh(worldTransform, model.GetMesh(), model.Material, &model,
+            Engine.ECS().Registry.all_of<DynamicShadowCaster>(entity));
     }
 
     if (m_currentLevel) {
@@ -243,6 +385,48 @@ void bee::BlossomGame::Update(float dt)
 
 }
 
+void bee::BlossomGame::FixedStep(const PlayerInput& input, float fixedTimeStep)
+{
+    auto& registry = Engine.ECS().Registry;
+    auto view = registry.view<Transform, RigidBody>(entt::exclude<CharacterComponent>);
+    auto characters = registry.view<Transform, RigidBody, CharacterComponent>();
+
+    BeginFixedStep(registry);
+
+    if (!m_freeCamEnabled) {
+        PlayerMovementSystem(m_currentLevel, input, fixedTimeStep);
+    }
+
+    for (auto&& [e, transform, body] : view.each())
+        bee::UpdateRigidBody(body, transform, fixedTimeStep);
+    for (auto&& [e, transform, body, character] : characters.each())
+        bee::UpdateCharacter(character, body, transform, fixedTimeStep);
+    TerrainCollisionHandlingSystem(m_currentLevel, *m_terrainSamples, fixedTimeStep);
+    OrbitalParticleMovementSystem(fixedTimeStep);
+}
+
+bool bee::BlossomGame::CheckDeterminism(uint32_t steps)
+{
+    auto& registry = Engine.ECS().Registry;
+    auto& physics = Engine.GetPhysics();
+    const float fixedTimeStep = Engine.GetTime().GetFixedTimeStep().count() / 1000.0f;
+
+    BeginFixedSteps(registry);
+
+    // Every step moves the player and its character, the physics update moves the sensor targets after them
+    const bool deterministic = physics.CheckDeterminism(steps,
+        [this, &physics, fixedTimeStep](uint32_t step)
+        {
+            FixedStep(GetScriptedPlayerInput(step), fixedTimeStep);
+            physics.Update(fixedTimeStep, 1);
+        },
+        [&registry](JPH::StateRecorder& recorder) { SaveFixedStepState(registry, recorder); },
+        [&registry](JPH::StateRecorder& recorder) { RestoreFixedStepState(registry, recorder); });
+
+    InterpolateTransforms(registry, Engine.GetTime().GetFixedStepAlpha());
+    return deterministic;
+}
+
 bool bee::BlossomGame::OpenLevel(const std::string &file) {
 
     victory = false;
@@ -263,22 +447,23 @@ bool bee::BlossomGame::OpenLevel(const std::string &file) {
     {
         CreateHUDResources();
         m_currentPlayer = SpawnPlayerSystem(constants);
-        PlayerMovementSystem(new_level, 0.0f);
+        PlayerMovementSystem(new_level, GetPlayerInput(0.0f), 0.0f);
         PlayerCameraSystem(0.0f); //Makes sure the camera start close to the player
         if (m_state == State::MAIN_MENU) ShowMainMenu();
     }
 
     m_currentLevel = new_level;
-    m_currentLevel->GenerateAll();
     m_currentLevel->SetPath(file);
+    m_currentLevel->GenerateAll();
 
     auto POIView = Engine.ECS().Registry.view<POIComponent>();
 
+    StaticBodyBatch poiColliders;
     for (auto [entity, poi] : POIView.each())
     {
-        InitColliderTransforms(Engine.ECS().Registry, entity);
+        poiColliders.AddColliders(Engine.ECS().Registry, entity);
     }
-    //Engine.PhysicsSystem().
+    poiColliders.Commit(Engine.ECS().Registry);
 
 #if defined(BEE_EDITOR)
     m_editor->LoadMenuData(*this);
@@ -10,12 +10,16 @@
 #include <grass/grass_manager.hpp>
 #include <rendering/render.hpp>
 #include <rendering/model_renderer.hpp>
+#include <rendering/impostor.hpp>
+#include <rendering/impostor_renderer.hpp>
+#include <rendering/hlod.hpp>
 #include <grass/grass_chunk.hpp>
 
 #include <core/fileio.hpp>
 #include <math/geometry.hpp>
 
 #include "terrain/terrain_collider.hpp"
+#include "terrain/terrain_heightfield.hpp"
 
 #include "systems/collectable.hpp"
 
@@ -34,11 +38,14 @@
 #include <tools/log.hpp>
 #include <resources/material/material_builder.hpp>
 #include <tools/serialization.hpp>
+#include <tools/tools.hpp>
 
 
 #include "jolt/Jolt.h"
 #include "physics/physics_system.hpp"
 #include "physics/helpers.hpp"
+#include "physics/shape_cache.hpp"
+#include "physics/static_body_batch.hpp"
 #include <jolt/Physics/Collision/Shape/BoxShape.h>
 #include <jolt/Physics/Body/BodyCreationSettings.h>
 
@@ -87,7 +94,7 @@ void load(A& archive, Level::TerrainDescription& desc) {
     archive(cereal::make_nvp("HeightMap", heightMapPath));
 
     if (!heightMapPath.empty()) try {
-        desc.heightMap = Engine.Resources().Images().FromFile(FileIO::Directory::Asset, heightMapPath, ImageFormat::RGBA8);
+        desc.LoadHeightMap(heightMapPath);
     }
     catch (std::exception& e) {
         Log::Error("Failed loading heightmap path from level file {}", e.what());
@@ -135,8 +142,11 @@ void load(A& archive, Level::TerrainDescription& desc) {
         .WithFactor(TextureSlotIndex::METALLIC_ROUGHNESS, roughnessFactor)
         .Build();
 
-    archive(cereal::make_nvp("TesselationDistance", desc.tesselationDistance));
+    // Older levels stored the range of the finest LOD level as the distance tessellation faded out over
+    LoadOptional(archive, "TesselationDistance", desc.lodDistance);
+    LoadOptional(archive, "LODDistance", desc.lodDistance);
     archive(cereal::make_nvp("TesselatinModifier", desc.tesselationModifier));
+    LoadOptional(archive, "TessellationPixels", desc.tessellationPixels);
     archive(cereal::make_nvp("UnitsPerTile", desc.unitsPerTile));
 }
 
@@ -161,8 +171,9 @@ void save(A& archive, const Level::TerrainDescription& desc) {
     archive(cereal::make_nvp("TerrainNormals", normalPath));
     archive(cereal::make_nvp("TerrainRoughness", roughnessPath));
 
-    archive(cereal::make_nvp("TesselationDistance", desc.tesselationDistance));
+    archive(cereal::make_nvp("LODDistance", desc.lodDistance));
     archive(cereal::make_nvp("TesselatinModifier", desc.tesselationModifier));
+    archive(cereal::make_nvp("TessellationPixels", desc.tessellationPixels));
     archive(cereal::make_nvp("UnitsPerTile", desc.unitsPerTile));
 }
 
@@ -172,6 +183,7 @@ void save(A& archive, const Level::GrassDescription& desc) {
     archive(cereal::make_nvp("GrassColourMap", desc.grassColour.GetPath()));
     archive(cereal::make_nvp("GrassDensityMap", desc.grassDensityMap.GetPath()));
     archive(cereal::make_nvp("Material", desc.material));
+    archive(cereal::make_nvp("Quality", desc.quality));
 }
 
 template<typename A>
@@ -182,6 +194,7 @@ void load(A& archive, Level::GrassDescription& desc) {
     archive(cereal::make_nvp("GrassColourMap", grassColourPath));
     archive(cereal::make_nvp("GrassDensityMap", grassDensityPath));
     archive(cereal::make_nvp("Material", desc.material));
+    LoadOptional(archive, "Quality", desc.quality);
 
     desc.grassColour = imageLoader.FromFile(FileIO::Directory::Asset, grassColourPath, ImageFormat::RGBA8);
     desc.grassDensityMap = imageLoader.FromFile(FileIO::Directory::Asset, grassDensityPath, ImageFormat::RGBA8);
@@ -191,11 +204,17 @@ template<typename A>
 void save(A& archive, const Level::LODDescription& desc)
 {
     archive(cereal::make_nvp("Distances", desc.distances));
+    archive(cereal::make_nvp("ImpostorDistance", desc.impostorDistance));
+    archive(cereal::make_nvp("HLODDistance", desc.hlodDistance));
+    archive(cereal::make_nvp("HLODCellSize", desc.hlodCellSize));
 }
 template<typename A>
 void load(A& archive, Level::LODDescription& desc)
 {
     archive(cereal::make_nvp("Distances", desc.distances));
+    LoadOptional(archive, "ImpostorDistance", desc.impostorDistance);
+    LoadOptional(archive, "HLODDistance", desc.hlodDistance);
+    LoadOptional(archive, "HLODCellSize", desc.hlodCellSize);
 }
 
 
@@ -220,6 +239,7 @@ void save(A& archive, const Level::PropDescription& desc) {
 
     archive(cereal::make_nvp("Collectable", desc.collectable));
     archive(cereal::make_nvp("HiddenUntilSequence", desc.partOfSequence));
+    archive(cereal::make_nvp("UseImpostors", desc.useImpostors));
 
     archive(cereal::make_nvp("PropTransforms", desc.propTransforms));
 }
@@ -250,6 +270,7 @@ void load(A& archive, Level::PropDescription& desc) {
 
     archive(cereal::make_nvp("Collectable", desc.collectable));
     archive(cereal::make_nvp("HiddenUntilSequence", desc.partOfSequence));
+    LoadOptional(archive, "UseImpostors", desc.useImpostors);
 
     archive(cereal::make_nvp("PropTransforms", desc.propTransforms));
 }
@@ -364,13 +385,13 @@ bee::Level::~Level() {
         Engine.ECS().DeleteEntity(entity);
     }
 
-    for (auto&& [entity, tag] : registry.view<GrassChunk>().each()) {
-        bee::Engine.ECS().DeleteEntity(entity);
-    }
+    Engine.GetGrassManager().ClearStreamingArea();
 
     for (auto&& [entity, tag] : registry.view<ModelTag>().each()) {
         bee::Engine.ECS().DeleteEntity(entity);
     }
+
+    ClearHLODs();
 }
 
 void bee::Level::GenerateLighting() {
@@ -389,6 +410,12 @@ void bee::Level::GenerateLighting() {
     }
 }
 
+void bee::Level::TerrainDescription::LoadHeightMap(const std::string& path)
+{
+    heightfield = TerrainHeightfield::FromFile(FileIO::Directory::Asset, path);
+    heightMap = heightfield->CreateImage(path);
+}
+
 void bee::Level::GenerateTerrain()
 {
     //Clear all terrain from ecs
@@ -396,43 +423,6 @@ void bee::Level::GenerateTerrain()
         Engine.ECS().DeleteEntity(entity);
     }
 
-    std::vector<float> vertices; vertices.reserve((m_terrain.mapSizeX + 1) * (m_terrain.mapSizeY + 1) * 3);
-    std::vector<float> uv; uv.reserve((m_terrain.mapSizeX + 1) * (m_terrain.mapSizeY + 1) * 2);
-
-    float half_width = static_cast<float>(m_terrain.mapSizeX) / 2.0f;
-    float half_height = static_cast<float>(m_terrain.mapSizeY) / 2.0f;
-
-    for (int y = 0; y <= m_terrain.mapSizeY; ++y) {
-        for (int x = 0; x <= m_terrain.mapSizeX; ++x) {
-
-            vertices.push_back((static_cast<float>(x) - half_width) * m_terrain.unitsPerTile);
-            vertices.push_back((static_cast<float>(y) - half_height) * m_terrain.unitsPerTile);
-            vertices.push_back(0.f);
-
-            uv.push_back(static_cast<float>(x) / static_cast<float>(m_terrain.mapSizeX));
-            uv.push_back(static_cast<float>(y) / static_cast<float>(m_terrain.mapSizeY));
-        }
-    }
-
-    //Indices
-    std::vector<unsigned int> indices;
-    indices.reserve(m_terrain.mapSizeX * m_terrain.mapSizeY * 6);
-
-    for (int i = 0, y = 0; y < m_terrain.mapSizeY; ++i, ++y) {
-        for (int x = 0; x < m_terrain.mapSizeX; ++i, ++x) {
-
-            indices.push_back(i);
-            indices.push_back(i + 1);
-            indices.push_back(i + m_terrain.mapSizeX + 1);
-            indices.push_back(i + 1);
-            indices.push_back(i + m_terrain.mapSizeX + 2);
-            indices.push_back(i + m_terrain.mapSizeX + 1);
-        }
-    }
-
-   m_terrain.generatedMesh = 
-       bee::Engine.Resources().Meshes().FromRawData("terrain", std::move(indices), std::move(vertices), {}, std::move(uv), {}, {}, BoundingBox());
-
     // Creating entity
     const auto terrainEntity = bee::Engine.ECS().CreateEntity();
     {
@@ -440,9 +430,8 @@ void bee::Level::GenerateTerrain()
         auto& transform = bee::Engine.ECS().Registry.emplace<bee::Transform>(terrainEntity);
         transform.Name = "Terrain plane";
 
-        // Mesh
+        // The terrain renderer draws a shared grid patch per quadtree node, only the material is needed
         auto& renderer = bee::Engine.ECS().Registry.emplace<bee::MeshRenderer>(terrainEntity);
-        renderer.LODs[0] = m_terrain.generatedMesh;
 
         // Hard override to disable dithering on terrain.
         m_terrain.terrainMaterial.Retrieve()->IsDitherable = false;
@@ -450,15 +439,20 @@ void bee::Level::GenerateTerrain()
 
         // Terrain settings
         auto& terrainChunk = bee::Engine.ECS().Registry.emplace<TerrainChunk>(terrainEntity);
-        terrainChunk.height = m_terrain.mapSizeX;
-        terrainChunk.width = m_terrain.mapSizeY;
+        terrainChunk.width = m_terrain.mapSizeX;
+        terrainChunk.height = m_terrain.mapSizeY;
+        terrainChunk.unitsPerTile = static_cast<float>(m_terrain.unitsPerTile);
         terrainChunk.heightmap = m_terrain.heightMap;
+        terrainChunk.heightfield = m_terrain.heightfield ? m_terrain.heightfield
+                                                         : std::make_shared<TerrainHeightfield>(1, 1, std::vector<uint16_t>{ 0 });
         terrainChunk.tesselationFactor = m_terrain.tesselationModifier;
-        terrainChunk.tesselationDistance = m_terrain.tesselationDistance;
+        terrainChunk.lodDistance = m_terrain.lodDistance;
+        terrainChunk.tessellationPixels = m_terrain.tessellationPixels;
         terrainChunk.heightModifier = m_terrain.heightScale;
 
         m_terrainCollider.reset();
-        m_terrainCollider = std::make_unique<TerrainCollider>(FileIO::Directory::Asset, m_terrain.heightMap.GetPath());
+        const glm::vec2 terrainSize = glm::vec2(m_terrain.mapSizeX, m_terrain.mapSizeY) * static_cast<float>(m_terrain.unitsPerTile);
+        m_terrainCollider = std::make_unique<TerrainCollider>(terrainChunk.heightfield, transform.World(), terrainSize, m_terrain.heightScale);
     }
 }
 
@@ -476,10 +470,7 @@ void bee::Level::GenerateGrass()
         grassRenderer.UpdateMaterial(std::move(material));
     }
 
-    //Clear all terrain from ecs
-    for (auto&& [entity, terrain] : bee::Engine.ECS().Registry.view<GrassChunk>().each()) {
-        Engine.ECS().DeleteEntity(entity);
-    }
+    Engine.GetGrassManager().SetQualitySettings(m_grass.quality);
 
     constexpr int GRASS_CHUNK_SIZE = 16; //Grass generation is hardcoded for 8x8 units per chunk
 
@@ -489,23 +480,44 @@ void bee::Level::GenerateGrass()
     const float grass_chunks_y =
         std::ceilf(static_cast<float>(m_terrain.mapSizeY) / static_cast<float>(GRASS_CHUNK_SIZE));
 
-    for (int y = 0; y < static_cast<int>(grass_chunks_y); ++y)
-    {
-        for (int x = 0; x < static_cast<float>(grass_chunks_x); ++x)
-        {
-            glm::vec3 grassChunkPos = {
-                (static_cast<float>(x) - grass_chunks_x / 2) * GRASS_CHUNK_SIZE + GRASS_CHUNK_SIZE / 2,
-                (static_cast<float>(y) - grass_chunks_y / 2) * GRASS_CHUNK_SIZE + GRASS_CHUNK_SIZE / 2,
-                0.0f
-            };
-
-            auto entity = Engine.GetGrassManager().CreateChunk(grassChunkPos, m_terrain.heightMap, m_terrain.heightScale);
+    // Chunks are streamed in around the camera instead of being created for the whole terrain
+    GrassStreamingArea grassArea{};
+    grassArea.origin = -glm::vec2(grass_chunks_x, grass_chunks_y) * 0.5f * static_cast<float>(GRASS_CHUNK_SIZE);
+    grassArea.chunkCount = glm::ivec2(static_cast<int>(grass_chunks_x), static_cast<int>(grass_chunks_y));
+    grassArea.chunkSize = static_cast<float>(GRASS_CHUNK_SIZE);
+    grassArea.terrainHeight = m_terrain.heightScale;
+    grassArea.heightMap = m_terrain.heightMap;
+    Engine.GetGrassManager().SetStreamingArea(grassArea);
+}
 
-        }
-    }
+void bee::Level::GenerateAllProps()
+{
+    // Drops the shapes of props that are gone, props replaced now are deleted at the end of the frame
+    ShapeCache& shapeCache = Engine.PhysicsShapeCache();
+    shapeCache.Prune();
+
+    StaticBodyBatch colliders;
+    for (size_t i = 0; i < m_props.size(); i++) GenerateProp(i, colliders);
+
+    // Saved levels keep a snapshot of their static bodies in the save directory, named after the level path
+    const std::string snapshotPath = m_originPath.empty()
+        ? std::string()
+        : fmt::format("physics_scene_{:016x}.bin", HashBytes(m_originPath.data(), m_originPath.size()));
+    colliders.Commit(Engine.ECS().Registry, FileIO::Directory::Save, snapshotPath);
+
+    const ShapeCache::Stats stats = shapeCache.GetStats();
+    Log::Info("Prop colliders: {} shared shapes ({:.1f} KB), {:.0f}% cache hits", stats.shapes,
+              static_cast<float>(stats.memoryBytes) / 1024.0f, stats.HitRate() * 100.0f);
 }
 
 void bee::Level::GenerateProp(size_t prop_index)
+{
+    StaticBodyBatch colliders;
+    GenerateProp(prop_index, colliders);
+    colliders.Commit(Engine.ECS().Registry);
+}
+
+void bee::Level::GenerateProp(size_t prop_index, StaticBodyBatch& colliders)
 {
     auto& registry = bee::Engine.ECS().Registry;
 
@@ -525,9 +537,6 @@ void bee::Level::GenerateProp(size_t prop_index)
         }
 	}
 
-    JPH::PhysicsSystem& physicsSystem = Engine.PhysicsSystem();
-    JPH::BodyInterface& bodyInterface = physicsSystem.GetBodyInterface();
-
     int32_t prevModelIndex = -1;
     glm::vec3 boxExtent;
     glm::vec3 boxCenter;
@@ -581,21 +590,7 @@ void bee::Level::GenerateProp(size_t prop_index)
 
             glm::vec3 offset = glm::rotate(rotation, boxCenter * scale);
 
-            JPH::BodyCreationSettings boxSettings(shape->ScaleShape(GlmToJolt(boxExtent * scale)).Get(), GlmToJolt(translation + offset), GlmToJolt(rotation), JPH::EMotionType::Static, Layers::COLLECTABLE);
-            JPH::Body* body = bodyInterface.CreateBody(boxSettings);
-
-            if (body != nullptr)
-            {
-                bodyInterface.AddBody(body->GetID(), JPH::EActivation::DontActivate);
-                body->SetUserData(static_cast<JPH::uint64>(newEntity));
-                auto& collider = registry.emplace<bee::ColliderComponent>(newEntity);
-                collider.body = body->GetID();
-            }
-            else
-            {
-                Log::Warn("physics body creation failed");
-                Log::Info("num bodies: {:d}, max bodies: {:d}", physicsSystem.GetNumBodies(), physicsSystem.GetMaxBodies());
-            }
+            colliders.Add(newEntity, shape, boxExtent * scale, translation + offset, rotation, Layers::COLLECTABLE);
         }
 
         if (propEntry.partOfSequence)
@@ -610,7 +605,13 @@ void bee::Level::GenerateProp(size_t prop_index)
         
         if (propEntry.generateCollidableMesh)
         {
-            InitColliderTransforms(Engine.ECS().Registry, newEntity);
+            colliders.AddColliders(registry, newEntity);
+        }
+
+        if (propEntry.useImpostors)
+        {
+            auto& impostor = registry.emplace<Impostor>(newEntity);
+            impostor.atlas = Engine.Renderer().GetImpostorRenderer().GetOrBake(propEntry.propModels[modelIndex]);
         }
 
         if (propEntry.collectable)
@@ -618,8 +619,6 @@ void bee::Level::GenerateProp(size_t prop_index)
             registry.emplace<Collectable>(newEntity, false);
         }
     }
-
-    Engine.PhysicsSystem().OptimizeBroadPhase();
 }
 
 void bee::Level::ClearProp(size_t prop_index)
@@ -628,17 +627,136 @@ void bee::Level::ClearProp(size_t prop_index)
 
     //Clear all previous models
     for (auto&& [entity, tag] : registry.view<ModelTag>().each()) {
-        if (tag.index == prop_index) bee::Engine.ECS().DeleteEntity(entity);
+        if (tag.index == prop_index) {
+            bee::Engine.ECS().DeleteEntity(entity);
+
+            // Deletion is deferred, untag now so a regenerate in the same frame (e.g. HLODs) skips it
+            registry.remove<ModelTag>(entity);
+        }
     }
 }
 
+void bee::Level::GenerateHLODs()
+{
+    auto& registry = bee::Engine.ECS().Registry;
+
+    // Clusters whose cell did not change are kept as they are, only changed cells are rebaked or read from the cache
+    std::unordered_map<uint64_t, entt::entity> previous;
+    for (auto [entity, cluster] : registry.view<HLODCluster>().each())
+    {
+        if (cluster.key != 0) previous.emplace(cluster.key, entity);
+    }
+    std::vector<entt::entity> kept;
+
+    registry.clear<HLODMember>();
+    registry.clear<TagReplacedByProxy>();
+    for (auto [entity, impostor] : registry.view<Impostor>().each())
+        impostor.active = false;
+
+    HLODSettings settings{};
+    settings.cellSize = m_lods.hlodCellSize;
+
+    // Only props that never change state can be merged, collectables and sequences are left alone
+    std::map<std::pair<int, int>, std::vector<entt::entity>> cells;
+    auto propView = registry.view<ModelTag, Transform>(entt::exclude<Collectable, BeautifyTag, TagNoDraw>);
+    for (auto [entity, tag, transform] : propView.each())
+    {
+        const glm::ivec2 cell = HLODCellCoordinate(glm::vec3(transform.World()[3]), settings.cellSize);
+        cells[{ cell.x, cell.y }].push_back(entity);
+    }
+
+    std::vector<HLODSource> sources;
+    std::vector<entt::entity> stack;
+
+    for (auto& [cell, props] : cells)
+    {
+        if (props.size() < settings.minPropsPerCell) continue;
+
+        // The coarsest LOD of every mesh in the prop hierarchies
+        sources.clear();
+        stack.assign(props.begin(), props.end());
+        while (!stack.empty())
+        {
+            entt::entity entity = stack.back();
+            stack.pop_back();
+
+            auto& transform = registry.get<Transform>(entity);
+            for (auto child : transform) stack.push_back(child);
+
+            auto* meshRenderer = registry.try_get<MeshRenderer>(entity);
+            if (!meshRenderer || registry.all_of<TagNoDraw>(entity)) continue;
+
+            ResourceHandle<Mesh> mesh = meshRenderer->LODs[0];
+            for (auto& lod : meshRenderer->LODs)
+                if (lod.Valid()) mesh = lod;
+
+            sources.push_back(HLODSource{ transform.World(), mesh, meshRenderer->Material });
+        }
+
+        entt::entity clusterEntity = entt::null;
+        if (auto it = previous.find(HLODCellKey(sources, settings)); it != previous.end())
+        {
+            clusterEntity = it->second;
+            previous.erase(it);
+        }
+        else
+        {
+            const std::string name = fmt::format("HLOD cell {} {}", cell.first, cell.second);
+            HLODCluster cluster = LoadOrBakeHLODCluster(sources, name, settings);
+            if (!cluster.mesh.Valid()) continue;
+
+            clusterEntity = registry.create();
+            registry.emplace<Transform>(clusterEntity).Name = name;
+            registry.emplace<HLODCluster>(clusterEntity, std::move(cluster));
+        }
+        kept.push_back(clusterEntity);
+
+        // Props can be recreated with the same contents, the kept cluster takes the new entities
+        auto& cluster = registry.get<HLODCluster>(clusterEntity);
+        cluster.members = props;
+        cluster.active = false;
+
+        for (auto prop : props)
+            registry.emplace_or_replace<HLODMember>(prop, clusterEntity);
+    }
+
+    // Every other cluster belongs to a cell that changed or is gone. Deletion is deferred, drop the proxies now so
+    // they are not drawn next to the rebaked ones.
+    std::sort(kept.begin(), kept.end());
+    std::vector<entt::entity> stale;
+    for (auto entity : registry.view<HLODCluster>())
+    {
+        if (!std::binary_search(kept.begin(), kept.end(), entity)) stale.push_back(entity);
+    }
+    for (auto entity : stale)
+    {
+        bee::Engine.ECS().DeleteEntity(entity);
+        registry.remove<HLODCluster>(entity);
+    }
+}
+
+void bee::Level::ClearHLODs()
+{
+    auto& registry = bee::Engine.ECS().Registry;
+
+    registry.clear<HLODMember>();
+    for (auto entity : registry.view<HLODCluster>())
+        bee::Engine.ECS().DeleteEntity(entity);
+
+    // Deletion is deferred, drop the proxies now so they are not drawn next to the rebaked ones
+    registry.clear<HLODCluster>();
+
+    // Proxy tags are only updated when a proxy switches, switch every impostor off so the next frame tags them again
+    registry.clear<TagReplacedByProxy>();
+    for (auto [entity, impostor] : registry.view<Impostor>().each())
+        impostor.active = false;
+}
+
 void bee::Level::FallbackDefaultLevel()
 {
     auto& terrain = GetTerrain();
 
-    terrain.heightMap = bee::Engine.Resources().Images().FromFile(
-        bee::FileIO::Directory::Asset, "textures/noise/gradient.png",
-        ImageFormat::RGBA8);
+    terrain.LoadHeightMap("textures/noise/gradient.png");
 
     auto imageAlbedo = bee::Engine.Resources().Images().FromFile(
         bee::FileIO::Directory::Asset,
@@ -1,8 +1,18 @@
 #include <precompiled/game_precompiled.hpp>
 
+#include <charconv>
+#include <cstring>
+#include <optional>
+#include <string>
+
 #include "core/ecs.hpp"
 #include "core/engine.hpp"
 #include "game/blossom.hpp"
+#include "grass/grass_renderer.hpp"
+#include "rendering/render.hpp"
+#include "rendering/shadow_cascades.hpp"
+#include "tools/log.hpp"
+#include "wind/wind.hpp"
 
 using namespace bee;
 
@@ -11,8 +21,68 @@ using namespace bee;
 #include <windows/dgpu_exports.hpp>
 #endif
 
+// Checks that run instead of the game, the exit code is 0 when they pass:
+//   --check-determinism [level] [steps]  runs the fixed steps of the level twice and compares both runs
+//   --check-grass-cull [level]           renders the level once and compares the grass cull pass with its CPU reference
+//   --check-wind [level]                 renders the level once and compares shaders/wind.glsl with WindMap
+//   --check-shadow-cascades              fits the shadow cascades of the renderer settings for a set of cameras and lights
+std::optional<int> RunCommandLine(int argc, char* argv[])
+{
+    if (argc < 2) return std::nullopt;
+
+    const std::string check = argv[1];
+    if (check != "--check-determinism" && check != "--check-grass-cull" && check != "--check-wind" && check != "--check-shadow-cascades")
+        return std::nullopt;
+
+    const std::string level = argc > 2 ? argv[2] : std::string();
+
+    uint32_t steps = 600;
+    if (argc > 3)
+    {
+        const char* end = argv[3] + std::strlen(argv[3]);
+        const auto [last, error] = std::from_chars(argv[3], end, steps);
+        if (error != std::errc() || last != end || steps == 0)
+        {
+            bee::Log::Error("{} expects a positive number of steps, got \"{}\"", check, argv[3]);
+            return 1;
+        }
+    }
+
+    // The renderer needs a window to load a level, nothing is presented in it
+    bee::Engine.Initialize(Mode::WINDOW);
+
+    bool passed = false;
+    if (check == "--check-shadow-cascades")
+    {
+        // Only the fit on the CPU, no level is needed
+        passed = bee::CheckCascadeFit(bee::Engine.Renderer().GetCascadeSettings());
+    }
+    else
+    {
+        BlossomGame game = BlossomGame();
+        if (level.empty() || game.OpenLevel(level))
+        {
+            if (check == "--check-determinism")
+            {
+                passed = game.CheckDeterminism(steps);
+            }
+            else
+            {
+                bee::Engine.RenderSystems();
+                passed = check == "--check-wind" ? bee::Engine.GetWindMap().CheckShader()
+                                                 : bee::Engine.Renderer().GetGrassRenderer().CheckCulling();
+            }
+        }
+    }
+
+    bee::Engine.Shutdown();
+    return passed ? 0 : 1;
+}
+
 int main(int argc, char* argv[])
 {
+    if (auto exitCode = RunCommandLine(argc, argv)) return *exitCode;
+
     Mode mode =
 #if defined(BEE_EDITOR)
         Mode::WINDOW;
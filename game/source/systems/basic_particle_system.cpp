@@ -6,6 +6,7 @@
 #include <rendering/render_components.hpp>
 #include <physics/rigidbody.hpp>
 #include <core/transform.hpp>
+#include <core/transform_interpolation.hpp>
 #include <tools/pcg_rand.hpp>
 
 //TODO move somewhere else
@@ -51,6 +52,7 @@ void bee::BasicParticleSystem(pcg::RNGState& seed, float dt)
                 particleTransform.SetScale(glm::vec3(emitter.particleScale));
 
                 auto& rigidBody = registry.emplace<RigidBody>(particle);
+                registry.emplace<InterpolatedTransform>(particle, particleTransform);
                 
                 auto randomDir = rand_vec3(seed);
                 auto randomSpeed = pcg::rand0_1(seed) * 0.5f + 0.5f;
@@ -64,6 +66,8 @@ void bee::BasicParticleSystem(pcg::RNGState& seed, float dt)
                 auto& particleMesh = registry.emplace<MeshRenderer>(particle);
                 particleMesh.LODs.front() = emitter.particleMesh;
                 particleMesh.Material = emitter.particleMaterial;
+
+                registry.emplace<DynamicShadowCaster>(particle);
             }
         }
     }
@@ -8,62 +8,27 @@
 #include <systems/basic_particle_system.hpp>
 #include <core/audio.hpp>
 
-#include <jolt/Jolt.h>
-#include <jolt/Physics/Collision/Shape/SphereShape.h>
-#include <jolt/Physics/Collision/CollideShape.h>
-#include "systems/collisions.hpp"
-#include "physics/physics_system.hpp"
-#include "physics/debug_renderer.hpp"
-#include "physics/helpers.hpp"
+#include "physics/sensors.hpp"
 #include <string>
 
 void bee::CollectItems()
 {
-	auto collectables = Engine.ECS().Registry.view<Collectable>();
-	auto players = Engine.ECS().Registry.view<Transform, Player>();
-
-	for (auto&& [playerEntity, transform, player] : players.each())
-	{
-        if (player.currentScore >= player.scoreCap) continue; //No collecting needed if player is full
-
-		JPH::SphereShape sphere = JPH::SphereShape(player.playerCollectionRadius);
-        JPH::Mat44 Jtransform = JPH::Mat44::sIdentity();
-        Jtransform.SetTranslation(GlmToJolt(transform.GetTranslation()));
-
-        JPH::CollideShapeSettings collideSettings;
-
-        CollectableCollisionCollector collector;
-
-        Engine.PhysicsSystem()
-            .GetNarrowPhaseQuery()
-            .CollideShape(&sphere, JPH::Vec3Arg(1.0f, 1.0f, 1.0f), Jtransform, collideSettings, JPH::RVec3Arg(0.0f, 0.0f, 0.0f), collector);
-
-#if defined(JPH_DEBUG_RENDERER) && defined(BEE_EDITOR)
-
-        JPH::Color color = JPH::Color(0.0f, 0.0f, 255.0f, 255.0f);
+    auto& registry = Engine.ECS().Registry;
 
-        JPH::DebugRenderer::sInstance->DrawSphere(Jtransform.GetTranslation(), sphere.GetRadius(), color);
-#endif
+    // Collectables are sensors, the player's sensor target overlapping one is reported by the physics update
+    for (const SensorEvent& event : Engine.PhysicsSensorEvents())
+    {
+        if (event.type == SensorEvent::Type::Exit) continue;
 
-        JPH::BodyInterface& bodyInterface = Engine.PhysicsSystem().GetBodyInterface();
+        auto* player = registry.try_get<Player>(event.other);
+        if (player == nullptr || player->currentScore >= player->scoreCap) continue; //No collecting needed if player is full
 
-        for (int i = 0; i < collector.collidedBodies.size(); i += 1)
+        auto* collectable = registry.try_get<Collectable>(event.sensor);
+        if (collectable != nullptr && collectable->isActive)
         {
-            entt::entity entity = static_cast<entt::entity>(bodyInterface.GetUserData(collector.collidedBodies[i]));
-
-            auto* collect = Engine.ECS().Registry.try_get<Collectable>(entity);
-
-            if (collect != nullptr)
-            {
-                Collectable& collectable = collectables.get<Collectable>(entity);
-
-                if (collectable.isActive)
-                {
-                    OnPlayerCollect(playerEntity, entity);
-                }
-            }
+            OnPlayerCollect(event.other, event.sensor);
         }
-	}
+    }
 }
 
 void bee::OnPlayerCollect(entt::entity player, entt::entity collectable)
@@ -9,14 +9,14 @@
 #include <physics/helpers.hpp>
 #include <physics/debug_renderer.hpp>
 #include <terrain/terrain_collider.hpp>
+#include <physics/character.hpp>
 #include <physics/rigidbody.hpp>
+#include <physics/sensors.hpp>
 #include <displacement/displacer.hpp>
 #include <math/geometry.hpp>
 
 #include <jolt/Jolt.h>
 #include <jolt/Physics/Collision/CollideShape.h>
-#include <jolt/Physics/Collision/Shape/BoxShape.h>
-#include <jolt/Physics/Collision/Shape/SphereShape.h>
 #include <jolt/Physics/Body/BodyCreationSettings.h>
 #include <jolt/Physics/Collision/CollisionCollector.h>
 
@@ -30,85 +30,56 @@ bool bee::CollectableCollisionCollector::Collided()
     return collidedBodies.size() > 0;
 }
 
-void bee::BodyCollisionCollector::AddHit(const ResultType& inResult)
-{
-    glm::vec3 delta = JoltToGlm(inResult.mContactPointOn2 - inResult.mContactPointOn1);
-
-    Data data;
-
-    data.magnitude = glm::length(delta);
-
-    if (data.magnitude == 0.0f)
-    {
-        return;
-    }
-
-    data.normal = delta / data.magnitude;
-
-    totalMagnitude += data.magnitude;
-
-    results.push_back(data);
-}
-
-bool bee::BodyCollisionCollector::Collided()
-{
-    return results.size() > 0;
-}
-
 void bee::PhysicsTest()
 {
     //Log::Info("{}", Engine.PhysicsSystem().GetNumActiveBodies(JPH::EBodyType::RigidBody));
 
     auto players = Engine.ECS().Registry.view<Transform, Player>();
+    const auto& sensorEvents = Engine.PhysicsSensorEvents();
 
     for (auto&& [entity, transform, player] : players.each())
     {
-        JPH::SphereShape sphere = JPH::SphereShape(0.5f);
-        JPH::Mat44 Jtransform = JPH::Mat44::sIdentity();
-        Jtransform.SetTranslation(GlmToJolt(transform.GetTranslation()));
-
-        JPH::CollideShapeSettings collideSettings;
-
-        CollectableCollisionCollector collector;
-
-        Engine.PhysicsSystem()
-            .GetNarrowPhaseQuery()
-            .CollideShape(&sphere, JPH::Vec3Arg(1.0f, 1.0f, 1.0f), Jtransform, collideSettings, JPH::RVec3Arg(0.0f, 0.0f, 0.0f), collector);
-
-        JPH::Color color = JPH::Color(0.0f, 255.0f, 0.0f, 255.0f);
-
-        if (collector.Collided())
-        {
-            color = JPH::Color(255.0f, 0.0f, 0.0f, 255.0f);
-        }
-
-        JPH::BodyInterface& bodyInterface = Engine.PhysicsSystem().GetBodyInterface();
+        // Red while the player is inside any sensor
+        bool overlapping = std::any_of(sensorEvents.begin(), sensorEvents.end(), [entity = entity](const SensorEvent& event)
+            {
+                return event.other == entity && event.type != SensorEvent::Type::Exit;
+            });
 
-        // deletes props on collision
-        //for (int i = 0; i < collector.collidedBodies.size(); i += 1)
-        //{
-        //    entt::entity entity = static_cast<entt::entity>(bodyInterface.GetUserData(collector.collidedBodies[i]));
-        //
-        //    Engine.ECS().DeleteEntity(entity);
-        //}
+        JPH::Color color = overlapping ? JPH::Color(255.0f, 0.0f, 0.0f, 255.0f) : JPH::Color(0.0f, 255.0f, 0.0f, 255.0f);
 
         // This will be fixed later
         // at the moment using debug renderer on release and 
         // playstation creates a compilation error because of how Jolt is implemented
-        EDITOR_ONLY(JPH::DebugRenderer::sInstance->DrawSphere(Jtransform.GetTranslation(), sphere.GetRadius(), color));
+        EDITOR_ONLY(JPH::DebugRenderer::sInstance->DrawSphere(GlmToJolt(transform.GetTranslation()), player.playerCollectionRadius, color));
     }
 }
 
-void bee::TerrainCollisionHandlingSystem(std::shared_ptr<Level> level, float dt)
+void bee::TerrainCollisionHandlingSystem(std::shared_ptr<Level> level, TerrainSampleBuffers& buffers, float dt)
 {
     constexpr float marginFromGround = 0.5f;
 
     if (level == nullptr) return;
 
-    auto view = Engine.ECS().Registry.view<Transform, RigidBody, Displacer>();
+    auto& registry = Engine.ECS().Registry;
+    auto view = registry.view<Transform, RigidBody, Displacer>();
+
+    // Sample the terrain below all entities at once, the loop below visits them in the same order
+    std::vector<glm::vec3>& positions = buffers.positions;
+    std::vector<float>& heights = buffers.heights;
+    positions.clear();
+    for (auto&& [entity, transform, rigidbody, displacer] : view.each())
+        positions.push_back(transform.GetTranslation());
+
+    heights.resize(positions.size());
+    level->GetTerrainCollider().SampleHeightsInWorld(positions.data(), heights.data(), positions.size());
+
+    // Characters are kept above the terrain by their sweep, unless the terrain has no height field body to sweep against
+    const bool terrainHasBody = !level->GetTerrainCollider().GetBody().IsInvalid();
+
+    size_t index = 0;
     for (auto&& [entity, transform, rigidbody, displacer] : view.each())
     {
-        float terrainHeight = level->GetTerrainCollider().SampleHeightInWorld(transform.GetTranslation()) + marginFromGround;
+        float terrainHeight = heights[index++] + marginFromGround;
         const float pushPadding = 0.15f;
 
         float distanceToTerrain = transform.GetTranslation().z - terrainHeight;
@@ -117,7 +88,7 @@ void bee::TerrainCollisionHandlingSystem(std::shared_ptr<Level> level, float dt)
             glm::vec3 translation = transform.GetTranslation();
 
             // Clamp player to terrain height
-            if (translation.z < terrainHeight)
+            if (translation.z < terrainHeight && (!terrainHasBody || !registry.all_of<CharacterComponent>(entity)))
             {
                 translation.z = terrainHeight;
                 transform.SetTranslation(translation);
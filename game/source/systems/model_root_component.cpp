@@ -4,12 +4,14 @@
 #include <core/transform.hpp>
 #include <systems/model_root_component.hpp>
 #include <resources/model/model.hpp>
+#include <rendering/render_components.hpp>
 
 void bee::ModelRootComponent::SubscribeToEvents()
 {
 	Engine.ECS().Registry.on_update<ModelRootComponent>().connect<ModelRootComponent::OnPatch>();
 	Engine.ECS().Registry.on_construct<ModelRootComponent>().connect<ModelRootComponent::OnPatch>();
 	Engine.ECS().Registry.on_destroy<ModelRootComponent>().connect<ModelRootComponent::OnDestroy>();
+	Engine.ECS().Registry.on_construct<DynamicShadowCaster>().connect<ModelRootComponent::OnShadowCasterConstruct>();
 }
 
 void bee::ModelRootComponent::UnsubscribeToEvents()
@@ -17,6 +19,7 @@ void bee::ModelRootComponent::UnsubscribeToEvents()
 	Engine.ECS().Registry.on_update<ModelRootComponent>().disconnect<ModelRootComponent::OnPatch>();
 	Engine.ECS().Registry.on_construct<ModelRootComponent>().disconnect<ModelRootComponent::OnPatch>();
 	Engine.ECS().Registry.on_destroy<ModelRootComponent>().disconnect<ModelRootComponent::OnDestroy>();
+	Engine.ECS().Registry.on_construct<DynamicShadowCaster>().disconnect<ModelRootComponent::OnShadowCasterConstruct>();
 }
 
 void bee::ModelRootComponent::OnPatch(entt::registry& registry, entt::entity entity)
@@ -27,6 +30,10 @@ void bee::ModelRootComponent::OnPatch(entt::registry& registry, entt::entity ent
 	if (auto m = model.model.Retrieve()) {
 		m->InstantiateScene(registry, entity);
 	}
+
+	// The scene can be instantiated after the root was tagged
+	if (registry.all_of<DynamicShadowCaster>(entity))
+		OnShadowCasterConstruct(registry, entity);
 }
 
 void bee::ModelRootComponent::OnDestroy(entt::registry& registry, entt::entity entity)
@@ -40,3 +47,15 @@ void bee::ModelRootComponent::OnDestroy(entt::registry& registry, entt::entity e
 
 	transform->DetachChildren(registry);
 }
+
+void bee::ModelRootComponent::OnShadowCasterConstruct(entt::registry& registry, entt::entity entity)
+{
+	auto* transform = registry.try_get<Transform>(entity);
+	if (transform == nullptr) return;
+
+	// Tagging a child calls this again for it, so the whole hierarchy below gets tagged
+	for (auto child : *transform) {
+		if (!registry.all_of<DynamicShadowCaster>(child))
+			registry.emplace<DynamicShadowCaster>(child);
+	}
+}
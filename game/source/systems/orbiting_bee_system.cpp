@@ -3,6 +3,7 @@
 
 #include <rendering/render_components.hpp>
 #include <core/transform.hpp>
+#include <core/transform_interpolation.hpp>
 #include <rendering/debug_render.hpp>
 #include <core/engine.hpp>
 #include <core/ecs.hpp>
@@ -155,6 +156,8 @@ void bee::OrbitalSpawnerComponent::OnCreate(entt::registry& registry, entt::enti
 
 			auto& new_model = registry.emplace<ModelRootComponent>(new_entity, spawner.particleModel);
 			auto& new_orbital = registry.emplace<OrbitalMovementComponent>(new_entity);
+			registry.emplace<InterpolatedTransform>(new_entity, new_transform);
+			registry.emplace<DynamicShadowCaster>(new_entity);
 
 			new_orbital = spawner.orbitalProperties;
 			new_orbital.ringCenter = position;
@@ -176,6 +179,8 @@ void bee::OrbitalSpawnerComponent::OnCreate(entt::registry& registry, entt::enti
 
 			auto& new_model = registry.emplace<ModelRootComponent>(new_entity, spawner.particleModel);
 			auto& new_orbital = registry.emplace<OrbitalMovementComponent>(new_entity);
+			registry.emplace<InterpolatedTransform>(new_entity, new_transform);
+			registry.emplace<DynamicShadowCaster>(new_entity);
 
 			new_orbital = spawner.orbitalProperties;
 			new_orbital.orbitProgress = radiansStart;
@@ -1,13 +1,7 @@
 #include <precompiled/game_precompiled.hpp>
 #include "systems/player.hpp"
 
-#include <jolt/Jolt.h>
-#include <jolt/Physics/Collision/Shape/SphereShape.h>
-#include <jolt/Physics/Collision/CollideShape.h>
-#include "physics/helpers.hpp"
-
 #include <systems/input_helpers.hpp>
-#include "systems/collisions.hpp"
 #include "core/engine.hpp"
 #include "core/input.hpp"
 #include "rendering/debug_render.hpp"
@@ -47,7 +41,7 @@ void bee::UpdatePlayerControlInversion()
     }*/
 }
 
-void bee::PlayerMovementSystem(std::shared_ptr<Level> level, float dt)
+bee::PlayerInput bee::GetPlayerInput(float dt)
 {
     constexpr float stickRotationSpeed = 1.2f;
     constexpr float mouseSensitivity = 0.0005f;
@@ -93,6 +87,15 @@ void bee::PlayerMovementSystem(std::shared_ptr<Level> level, float dt)
         inputRotation.z *= -1.0f;
     }
 
+    return { tSpeedDelta, boostActivated, inputRotation };
+}
+
+void bee::PlayerMovementSystem(std::shared_ptr<Level> level, const PlayerInput& input, float dt)
+{
+    float tSpeedDelta = input.throttle;
+    bool boostActivated = input.boost;
+    const glm::vec3 inputRotation = input.rotation;
+
     auto view = Engine.ECS().Registry.view<Transform, Player, RigidBody>();
     for (auto&& [entity, transform, player, rigidbody] : view.each()) {
 
@@ -139,63 +142,6 @@ void bee::PlayerMovementSystem(std::shared_ptr<Level> level, float dt)
         player.speed = maxSpeed * tSpeed;
         float movementSpeed = maxSpeed * Ease::OutSine(tSpeed);
 
-        // Collision stuff
-        {
-            JPH::SphereShape sphere = JPH::SphereShape(player.playerCollisionRadius);
-            JPH::Mat44 Jtransform = JPH::Mat44::sIdentity();
-            Jtransform.SetTranslation(GlmToJolt(transform.GetTranslation()));
-
-            JPH::CollideShapeSettings collideSettings;
-            JPH::SpecifiedBroadPhaseLayerFilter filter(BroadPhaseLayers::NON_MOVING);
-
-            BodyCollisionCollector collector;
-
-            Engine.PhysicsSystem()
-                .GetNarrowPhaseQuery()
-                .CollideShape(&sphere, JPH::Vec3Arg(1.0f, 1.0f, 1.0f), Jtransform, collideSettings, JPH::RVec3Arg(0.0f, 0.0f, 0.0f), collector, filter);
-
-            if (collector.Collided())
-            {
-                float compoundedMagnitude = 0;
-                glm::vec3 compoundedNormal = glm::vec3(0.0f);
-
-                for (int i = 0; i < collector.results.size(); i += 1)
-                {
-                    auto& collision = collector.results[i];
-
-                    float percent = collision.magnitude / collector.totalMagnitude;
-
-                    compoundedNormal += collision.normal * percent;
-
-                    compoundedMagnitude += collision.magnitude * percent;
-                }
-
-                compoundedNormal = glm::normalize(compoundedNormal);
-
-#if defined(JPH_DEBUG_RENDERER) && defined(BEE_EDITOR)
-
-                JPH::Color color = JPH::Color(0, 255, 0, 255);
-
-                if (collector.Collided())
-                {
-                    color = JPH::Color(255, 0, 0, 255);
-                }
-
-                //JPH::DebugRenderer::sInstance->DrawSphere(Jtransform.GetTranslation(), sphere.GetRadius(), color);
-
-                glm::vec3 from = transform.GetTranslation();
-                glm::vec3 to = transform.GetTranslation() + compoundedNormal * compoundedMagnitude;
-
-                JPH::DebugRenderer::sInstance->DrawArrow(GlmToJolt(from), GlmToJolt(to), JPH::Color::sRed, 0.1f);
-
-#endif
-
-                glm::vec3 translation = transform.GetTranslation();
-                translation += compoundedNormal * compoundedMagnitude;
-                transform.SetTranslation(translation);
-            }
-        }
-
         glm::vec3 pushDirection(0.0f);
         float pushStrength = 0.0f;
 
@@ -2,9 +2,12 @@
 #include <systems/player_start.hpp>
 #include <physics/rigidbody.hpp>
 #include <displacement/displacer.hpp>
+#include <physics/character.hpp>
+#include <physics/sensors.hpp>
 
 #include <core/engine.hpp>
 #include <core/ecs.hpp>
+#include <core/transform_interpolation.hpp>
 #include <resources/resource_manager.hpp>
 #include <resources/model/model_loader.hpp>
 #include <systems/simple_animation.hpp>
@@ -30,6 +33,9 @@ void bee::PlayerStart::OnPatch(entt::registry& registry, entt::entity entity)
         auto poi = player.currentPOI;
         player = start.playerAttributes;
         player.currentPOI = poi;
+
+        AddSphereCharacter(registry, e, player.playerCollisionRadius);
+        AddSphereSensorTarget(registry, e, player.playerCollectionRadius);
     }
 
     for (auto&& [e, camera] : registry.view<PlayerCamera>().each())
@@ -62,10 +68,17 @@ entt::entity bee::SpawnPlayerSystem(const GameConstants& playerConstants)
         Player& player = Engine.ECS().CreateComponent<Player>(m_currentPlayer, playerComponent);
         Transform& transform = Engine.ECS().CreateComponent<Transform>(m_currentPlayer, playerInitial);
         RigidBody& rigidBody = Engine.ECS().CreateComponent<RigidBody>(m_currentPlayer);
+        Engine.ECS().Registry.emplace<InterpolatedTransform>(m_currentPlayer, transform);
 
         Engine.ECS().CreateComponent<DisplacerFocus>(m_currentPlayer);
         Engine.ECS().CreateComponent<Displacer>(m_currentPlayer);
 
+        // Moves through the terrain and props in a single sweep per step
+        AddSphereCharacter(Engine.ECS().Registry, m_currentPlayer, player.playerCollisionRadius);
+
+        // Collectables and points of interest detect the player through it
+        AddSphereSensorTarget(Engine.ECS().Registry, m_currentPlayer, player.playerCollectionRadius);
+
         transform.Name = "Player";
         rigidBody.maxVelocity = 25.0f;
         rigidBody.damping = 2.0f;
@@ -19,18 +19,48 @@
 #include <jolt/Physics/Collision/Shape/SphereShape.h>
 #include <jolt/Physics/Collision/CollideShape.h>
 #include <systems/collisions.hpp>
+#include <physics/sensors.hpp>
 #include <resources/resource_manager.hpp>
 #include <resources/model/model.hpp>
 #include <systems/scale_in_system.hpp>
 #include <systems/orbiting_bee_system.hpp>
 #include <rendering/render_components.hpp>
 
-void bee::POISystem(float dt, int hiveAudioChannelID)
+namespace
+{
+constexpr float DEPOSIT_RANGE_MULT = 0.15f;
+constexpr float POI_START_RANGE_MULT = 0.5f;
+constexpr float POI_SOUND_MULT = 0.5f;
+}
+
+void bee::POIComponent::SubscribeToEvents()
+{
+	Engine.ECS().Registry.on_update<POIComponent>().connect<POIComponent::OnPatch>();
+	Engine.ECS().Registry.on_construct<POIComponent>().connect<POIComponent::OnPatch>();
+	Engine.ECS().Registry.on_destroy<POIComponent>().connect<POIComponent::OnDestroy>();
+}
+
+void bee::POIComponent::UnsubscribeToEvents()
 {
-	constexpr float DEPOSIT_RANGE_MULT = 0.15f;
-	constexpr float POI_START_RANGE_MULT = 0.5f;
-	constexpr float POI_SOUND_MULT = 0.5f;
+	Engine.ECS().Registry.on_update<POIComponent>().disconnect<POIComponent::OnPatch>();
+	Engine.ECS().Registry.on_construct<POIComponent>().disconnect<POIComponent::OnPatch>();
+	Engine.ECS().Registry.on_destroy<POIComponent>().disconnect<POIComponent::OnDestroy>();
+}
+
+void bee::POIComponent::OnPatch(entt::registry& registry, entt::entity entity)
+{
+	//Replaces the sensor, so it follows the activation range
+	auto& poi = registry.get<POIComponent>(entity);
+	AddSphereSensor(registry, entity, POI_START_RANGE_MULT * poi.activationRange);
+}
+
+void bee::POIComponent::OnDestroy(entt::registry& registry, entt::entity entity)
+{
+	registry.remove<SensorComponent>(entity);
+}
 
+void bee::POISystem(float dt, int hiveAudioChannelID)
+{
 	auto& registry = Engine.ECS().Registry;
 
 	//Get Player
@@ -46,6 +76,14 @@ void bee::POISystem(float dt, int hiveAudioChannelID)
 
 	auto& playerComponent = registry.get<Player>(player);
 
+	//POIs whose start range the player is in, their sensors overlap the player's sensor target
+	std::vector<entt::entity> POIsInRange;
+	for (const SensorEvent& event : Engine.PhysicsSensorEvents())
+	{
+		if (event.type != SensorEvent::Type::Exit && event.other == player && registry.all_of<POIComponent>(event.sensor))
+			POIsInRange.push_back(event.sensor);
+	}
+
 	float POIHiveVolume = 0.0f;
 
 	//Case 1: player has no POI
@@ -54,7 +92,6 @@ void bee::POISystem(float dt, int hiveAudioChannelID)
 		playerComponent.currentPOI = entt::null;
 		Engine.Audio().SetChannelVolume(hiveAudioChannelID, 0.0f);
 
-		//Pick a new POI if close enough
 		auto POIView = registry.view<POIComponent, Transform>();
 		for (auto&& [e, poi, transform] : POIView.each())
 		{
@@ -64,17 +101,19 @@ void bee::POISystem(float dt, int hiveAudioChannelID)
 
 			float hiveSound = POI_SOUND_MULT * glm::log(poi.activationRange / distance);
 			POIHiveVolume = glm::max(POIHiveVolume, hiveSound);
+		}
 
+		//Pick a new POI if close enough
+		for (auto e : POIsInRange)
+		{
+			auto& poi = registry.get<POIComponent>(e);
 			if (poi.completed) continue;
 
-			if (distance < POI_START_RANGE_MULT * poi.activationRange)
+			playerComponent.currentPOI = e;
+			if (!poi.started)
 			{
-				playerComponent.currentPOI = e;
-				if (!poi.started)
-				{
-					poi.started = true;
-					StartNewPOI(e);
-				}
+				poi.started = true;
+				StartNewPOI(e);
 			}
 		}
 	}
@@ -99,11 +138,13 @@ void bee::POISystem(float dt, int hiveAudioChannelID)
 		float hiveSound = POI_SOUND_MULT * glm::log(poi.activationRange / distance);
 		POIHiveVolume = glm::max(POIHiveVolume, hiveSound);
 
+		bool inRange = std::find(POIsInRange.begin(), POIsInRange.end(), playerComponent.currentPOI) != POIsInRange.end();
+
 		if (distance < DEPOSIT_RANGE_MULT * poi.activationRange && playerComponent.currentScore > 0)
 		{
 			DepositPOI(player, playerComponent.currentPOI);
 		}
-		else if (distance > POI_START_RANGE_MULT * poi.activationRange)
+		else if (!inRange)
 		{
 			playerComponent.currentPOI = entt::null;
 		}
@@ -221,6 +262,10 @@ void bee::FinishPOI(entt::entity poiEntity)
 
 	for (auto bodyID : collector.collidedBodies) {
 		auto entity = static_cast<entt::entity>(bodyInterface.GetUserData(bodyID));
+
+		//Sensors of points of interest are in range as well
+		if (registry.all_of<POIComponent>(entity)) continue;
+
 		entities.push_back(entity);
 	}
 
@@ -20,7 +20,7 @@ void SubmitNodesRecursive(ResourceHandle<Model> model, const glm::mat4 transform
         glm::mat4_cast(node.rotation);
 
     for (auto&& [prim, mat_id] : mesh[0].primitiveMaterialPairs) {
-        Engine.Renderer().QueueMesh(this_transform, prim, model.Retrieve()->materials.at(mat_id), nullptr);
+        Engine.Renderer().QueueMesh(this_transform, prim, model.Retrieve()->materials.at(mat_id), nullptr, true);
     }
 
     for (auto node_id : node.children) {